@@ -19,7 +19,8 @@ static const char optionStarter = '-';
 enum class ProgOptStatus
 {
 	NoErrors,
-	MissingArgument
+	MissingArgument,
+	InvalidArgument
 };
 
 static po::options_description addOptions()
@@ -27,8 +28,8 @@ static po::options_description addOptions()
 	po::options_description options("Options and arguments");
 	options.add_options()
 		("help,h", "Show this help message")
-		("mysql-user,u", po::value<std::string>()->required(), "Existing MySQL user with sufficient privilege to insert and query")
-		("mysql-password,p", po::value<std::string>()->required(), "password for the MySQL user")
+		("mysql-user,u", po::value<std::string>(), "Existing MySQL user with sufficient privilege to insert and query, required unless --in-memory is used")
+		("mysql-password,p", po::value<std::string>(), "password for the MySQL user, required unless --in-memory is used")
 		("mysql-URL", po::value<std::string>()->default_value("127.0.0.1"), "IP address for the MySQL server")
 		("mysql-port", po::value<unsigned int>(), "The port value for the MySQL server. A default of 3306 is provided.")
 		("mysql-dbname", po::value<std::string>()->default_value("PlannerTaskScheduleDB"), "The name of the database that contains the tables")
@@ -36,6 +37,29 @@ static po::options_description addOptions()
 		("task-data-file", po::value<std::string>()->default_value("testData/planData.txt"), "File path including file name to task test data")
 		("time-tests", "Time the execution of the tests")
 		("verbose", "Output additional information for testing and debugging.")
+		("pool-min-size", po::value<std::size_t>(), "Number of MySQL connections opened when the connection pool starts. Default is 1.")
+		("pool-max-size", po::value<std::size_t>(), "Maximum number of MySQL connections in the connection pool. Default is 8.")
+		("pool-health-check", po::value<unsigned int>(), "Seconds an idle pooled connection waits before it is pinged. Default is 3600.")
+		("idle-reset", "Reset the session state of connections returned to the pool. This discards the prepared statements cached for the connection.")
+		("db-threads", po::value<unsigned int>(), "Number of threads executing database statements. Default is 1.")
+		("bulk-insert-rows", po::value<std::size_t>(), "Maximum rows in one multi-row INSERT statement. Default is 1000.")
+		("bulk-insert-bytes", po::value<std::size_t>(), "Maximum size in bytes of one multi-row INSERT statement. Default is 1048576.")
+		("pipeline-depth", po::value<std::size_t>(), "Maximum statements sent in one pipeline. Default is 256.")
+		("stream-batch-size", po::value<std::size_t>(), "Number of models delivered per batch by list queries. Default is 500.")
+		("lookup-batch-size", po::value<std::size_t>(), "Maximum number of keys in one batch key lookup query. Default is 500.")
+		("model-cache-size", po::value<std::size_t>(), "Maximum number of models kept in the model cache, 0 disables the cache. Default is 0.")
+		("group-commit-window", po::value<unsigned int>(), "Milliseconds single inserts wait to be committed together in one transaction, 0 disables group commit. Default is 0.")
+		("group-commit-size", po::value<std::size_t>(), "Maximum number of inserts committed together. Default is 100.")
+		("in-memory", "Store the users and tasks in memory instead of the MySQL database.")
+		("statement-statistics", "Report the counters and latency percentiles of the database statements on exit.")
+		("slow-query-ms", po::value<unsigned int>(), "Log statements that take at least this many milliseconds, 0 disables the slow query log. Default is 0.")
+		("slow-query-sample", po::value<std::uint64_t>(), "Log one in this many slow statements. Default is 1.")
+		("slow-query-log", po::value<std::string>()->default_value("slowQuery.log"), "File path including file name of the slow query log")
+		("connect-timeout-ms", po::value<unsigned int>(), "Milliseconds to wait for a pooled MySQL connection. Default is 10000.")
+		("query-timeout-ms", po::value<unsigned int>(), "Milliseconds a single statement may take before it is cancelled. Default is 30000.")
+		("call-timeout-ms", po::value<unsigned int>(), "Milliseconds a database call including all of its statements may take, 0 means no limit. Default is 0.")
+		("slow-query-log-size", po::value<std::size_t>(), "Size in bytes at which the slow query log is rotated. Default is 10485760.")
+		("write-behind-depth", po::value<std::size_t>(), "Maximum number of queued write-behind inserts and updates, 0 writes them before returning. Default is 0.")
 	;
 
 	return options;
@@ -96,7 +120,8 @@ static auto checkOptionsWithStringArguments(po::variables_map& inputOptions) ->
 		{"mysql-URL", &progOptions.mySqlUrl},
 		{"mysql-dbname", &progOptions.mySqlDBName},
 		{"user-data-file", &progOptions.userTestDataFile},
-		{"task-data-file", &progOptions.taskTestDataFile}
+		{"task-data-file", &progOptions.taskTestDataFile},
+		{"slow-query-log", &progOptions.slowQueryLogFile}
 	};
 	ProgOptStatus hasArguments = ProgOptStatus::NoErrors;
 	
@@ -151,10 +176,150 @@ static auto processProgramOptions(po::variables_map& inputOptions,
 		programOptions.verboseOutput = true;
 	}
 
+	if (inputOptions.count("statement-statistics")) {
+		programOptions.reportStatementStatistics = true;
+	}
+
+	if (inputOptions.count("slow-query-ms")) {
+		programOptions.slowQueryThresholdMilliseconds = inputOptions["slow-query-ms"].as<unsigned int>();
+	}
+
+	if (inputOptions.count("slow-query-sample")) {
+		programOptions.slowQuerySampleInterval = inputOptions["slow-query-sample"].as<std::uint64_t>();
+		if (programOptions.slowQuerySampleInterval == 0)
+		{
+			std::cerr << "The option '--slow-query-sample' must be at least 1!\n";
+			return std::unexpected(ProgOptStatus::InvalidArgument);
+		}
+	}
+
+	if (inputOptions.count("connect-timeout-ms")) {
+		programOptions.connectTimeoutMilliseconds = inputOptions["connect-timeout-ms"].as<unsigned int>();
+		if (programOptions.connectTimeoutMilliseconds == 0)
+		{
+			std::cerr << "The option '--connect-timeout-ms' must be at least 1!\n";
+			return std::unexpected(ProgOptStatus::InvalidArgument);
+		}
+	}
+
+	if (inputOptions.count("query-timeout-ms")) {
+		programOptions.queryTimeoutMilliseconds = inputOptions["query-timeout-ms"].as<unsigned int>();
+		if (programOptions.queryTimeoutMilliseconds == 0)
+		{
+			std::cerr << "The option '--query-timeout-ms' must be at least 1!\n";
+			return std::unexpected(ProgOptStatus::InvalidArgument);
+		}
+	}
+
+	if (inputOptions.count("call-timeout-ms")) {
+		programOptions.callTimeoutMilliseconds = inputOptions["call-timeout-ms"].as<unsigned int>();
+	}
+
+	if (inputOptions.count("slow-query-log-size")) {
+		programOptions.slowQueryLogMaxBytes = inputOptions["slow-query-log-size"].as<std::size_t>();
+	}
+
+	if (inputOptions.count("in-memory")) {
+		programOptions.useInMemoryStorage = true;
+	}
+	else if (programOptions.mySqlUser.empty() || programOptions.mySqlPassword.empty())
+	{
+		std::cerr << "The options '--mysql-user' and '--mysql-password' are required unless '--in-memory' is used!\n";
+		return std::unexpected(ProgOptStatus::MissingArgument);
+	}
+
+	if (inputOptions.count("pool-min-size")) {
+		programOptions.connectionPoolMinSize = inputOptions["pool-min-size"].as<std::size_t>();
+	}
+
+	if (inputOptions.count("pool-max-size")) {
+		programOptions.connectionPoolMaxSize = inputOptions["pool-max-size"].as<std::size_t>();
+	}
+
+	if (programOptions.connectionPoolMaxSize == 0 ||
+		programOptions.connectionPoolMaxSize < programOptions.connectionPoolMinSize)
+	{
+		std::cerr << "The option '--pool-max-size' must be at least 1 and not less than '--pool-min-size'!\n";
+		return std::unexpected(ProgOptStatus::InvalidArgument);
+	}
+
+	if (inputOptions.count("pool-health-check")) {
+		programOptions.connectionHealthCheckSeconds = inputOptions["pool-health-check"].as<unsigned int>();
+	}
+
+	if (inputOptions.count("idle-reset")) {
+		programOptions.resetIdleConnections = true;
+	}
+
+	if (inputOptions.count("db-threads")) {
+		programOptions.dbThreadCount = inputOptions["db-threads"].as<unsigned int>();
+		if (programOptions.dbThreadCount == 0)
+		{
+			std::cerr << "The option '--db-threads' must be at least 1!\n";
+			return std::unexpected(ProgOptStatus::InvalidArgument);
+		}
+	}
+
+	if (inputOptions.count("bulk-insert-rows")) {
+		programOptions.bulkInsertMaxRows = inputOptions["bulk-insert-rows"].as<std::size_t>();
+	}
+
+	if (inputOptions.count("bulk-insert-bytes")) {
+		programOptions.bulkInsertMaxBytes = inputOptions["bulk-insert-bytes"].as<std::size_t>();
+	}
+
+	if (inputOptions.count("pipeline-depth")) {
+		programOptions.pipelineDepth = inputOptions["pipeline-depth"].as<std::size_t>();
+		if (programOptions.pipelineDepth == 0)
+		{
+			std::cerr << "The option '--pipeline-depth' must be at least 1!\n";
+			return std::unexpected(ProgOptStatus::InvalidArgument);
+		}
+	}
+
+	if (inputOptions.count("stream-batch-size")) {
+		programOptions.streamBatchSize = inputOptions["stream-batch-size"].as<std::size_t>();
+		if (programOptions.streamBatchSize == 0)
+		{
+			std::cerr << "The option '--stream-batch-size' must be at least 1!\n";
+			return std::unexpected(ProgOptStatus::InvalidArgument);
+		}
+	}
+
+	if (inputOptions.count("lookup-batch-size")) {
+		programOptions.lookupBatchSize = inputOptions["lookup-batch-size"].as<std::size_t>();
+		if (programOptions.lookupBatchSize == 0)
+		{
+			std::cerr << "The option '--lookup-batch-size' must be at least 1!\n";
+			return std::unexpected(ProgOptStatus::InvalidArgument);
+		}
+	}
+
+	if (inputOptions.count("model-cache-size")) {
+		programOptions.modelCacheSize = inputOptions["model-cache-size"].as<std::size_t>();
+	}
+
+	if (inputOptions.count("group-commit-window")) {
+		programOptions.groupCommitWindowMilliseconds = inputOptions["group-commit-window"].as<unsigned int>();
+	}
+
+	if (inputOptions.count("group-commit-size")) {
+		programOptions.groupCommitMaxSize = inputOptions["group-commit-size"].as<std::size_t>();
+		if (programOptions.groupCommitMaxSize == 0)
+		{
+			std::cerr << "The option '--group-commit-size' must be at least 1!\n";
+			return std::unexpected(ProgOptStatus::InvalidArgument);
+		}
+	}
+
+	if (inputOptions.count("write-behind-depth")) {
+		programOptions.writeBehindDepth = inputOptions["write-behind-depth"].as<std::size_t>();
+	}
+
 	return programOptions;
 }
 
-static const int MinArgCount = 3;
+static const int MinArgCount = 2;
 
 static CommandLineStatus usage(const std::string& progName,
 	const po::options_description& options,
@@ -166,6 +331,7 @@ static CommandLineStatus usage(const std::string& progName,
 	"\tThe connection data must be listed with the appropriate flags. Default MySQL\n"
 	"\tIP address is 127.0.0.1 and a default MySQL port 3306 are provided. Default\n"
 	"\tvalues for the user data file name and task data file name are also provided\n"
+	"\tThe --in-memory flag replaces the MySQL database with an in memory database.\n"
 ;
 	if (errorMessage.length())
 	{
@@ -196,7 +362,7 @@ auto parseCommandLine(int argc, char* argv[]) ->
 	if (argc < MinArgCount)
 	{
 		return std::unexpected(usage(progName, options,
-			"Missing MySql User Name and Password"));
+			"Missing MySql User Name and Password or --in-memory"));
 	}
 
 	po::variables_map optionMemory;        
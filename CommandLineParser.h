@@ -1,6 +1,8 @@
 #ifndef COMMAND_LINE_PARSER_H_
 #define COMMAND_LINE_PARSER_H_
 
+#include <cstddef>
+#include <cstdint>
 #include <expected>
 #include <string>
 
@@ -16,6 +18,29 @@ struct ProgramOptions
     std::string taskTestDataFile;
 	bool enableExecutionTime = false;
     bool verboseOutput = false;
+    std::size_t connectionPoolMinSize = 1;
+    std::size_t connectionPoolMaxSize = 8;
+    unsigned int connectionHealthCheckSeconds = 3600;
+    bool resetIdleConnections = false;
+    unsigned int dbThreadCount = 1;
+    std::size_t bulkInsertMaxRows = 1000;
+    std::size_t bulkInsertMaxBytes = 1024 * 1024;
+    std::size_t pipelineDepth = 256;
+    std::size_t streamBatchSize = 500;
+    std::size_t lookupBatchSize = 500;
+    std::size_t modelCacheSize = 0;
+    unsigned int groupCommitWindowMilliseconds = 0;
+    std::size_t groupCommitMaxSize = 100;
+    bool useInMemoryStorage = false;
+    bool reportStatementStatistics = false;
+    unsigned int slowQueryThresholdMilliseconds = 0;
+    std::uint64_t slowQuerySampleInterval = 1;
+    std::string slowQueryLogFile = "slowQuery.log";
+    std::size_t slowQueryLogMaxBytes = 10 * 1024 * 1024;
+    unsigned int connectTimeoutMilliseconds = 10000;
+    unsigned int queryTimeoutMilliseconds = 30000;
+    unsigned int callTimeoutMilliseconds = 0;
+    std::size_t writeBehindDepth = 0;
 };
 
 enum class CommandLineStatus
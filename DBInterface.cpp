@@ -1,135 +1,2675 @@
+#include <algorithm>
 #include <boost/asio.hpp>
 #include <boost/mysql.hpp>
+#include <charconv>
 #include <chrono>
+#include <cstdint>
 #include "DBInterface.h"
 #include <exception>
 #include <format>
+#include <future>
 #include <iostream>
 #include "ModelBase.h"
+#include "ModelSchema.h"
+#include <mutex>
 #include <optional>
 #include "PTS_DataField.h"
 #include <stdexcept>
 #include <string>
 #include <string_view>
 #include <utility>
+#include <variant>
 #include <vector>
 
+const std::vector<std::string> DBInterface::AllColumns;
+
 DBInterface::DBInterface(ProgramOptions& programOptions)
-:   errorMessages{""}, databaseName{programOptions.mySqlDBName}, verboseOutput{programOptions.verboseOutput}
+:   databaseName{programOptions.mySqlDBName}, verboseOutput{programOptions.verboseOutput},
+    resetIdleConnections{programOptions.resetIdleConnections},
+    bulkInsertMaxRows{programOptions.bulkInsertMaxRows}, bulkInsertMaxBytes{programOptions.bulkInsertMaxBytes},
+    pipelineDepth{programOptions.pipelineDepth}, streamBatchSize{programOptions.streamBatchSize},
+    lookupBatchSize{programOptions.lookupBatchSize}, reportStatisticsOnExit{programOptions.reportStatementStatistics},
+    statementStatistics{{"*", "", TaskModel().getTableName(), UserModel().getTableName()}},
+    slowQueryLog{programOptions}, connectTimeout{programOptions.connectTimeoutMilliseconds},
+    queryTimeout{programOptions.queryTimeoutMilliseconds},
+    callTimeout{std::chrono::milliseconds(programOptions.callTimeoutMilliseconds)}, connectTimeouts{0}, statementTimeouts{0},
+    ioContext{static_cast<int>(programOptions.dbThreadCount)},
+    ioWorkGuard{boost::asio::make_work_guard(ioContext)},
+    poolHits{0}, poolMisses{0}, autoIncrementIncrement{0}, modelCache{programOptions.modelCacheSize},
+    transactionActive{false}, transactionLost{false}, transactionConnectionID{nullptr},
+    groupCommitWindow{programOptions.groupCommitWindowMilliseconds}, groupCommitMaxSize{programOptions.groupCommitMaxSize},
+    groupCommitNumber{0}
+{
+    // The unique indexes declared in PlannerTaskScheduleDB.sql, TaskID is the primary key of Tasks.
+    std::string userTable = UserModel().getTableName();
+    modelCache.addUniqueIndex(userTable, {"LoginName"});
+    modelCache.addUniqueIndex(userTable, {"LastName", "FirstName", "MiddleInitial"});
+
+    connectionPool = std::make_unique<boost::mysql::connection_pool>(ioContext, createPoolParameters(programOptions));
+    connectionPool->async_run(boost::asio::detached);
+
+    for (unsigned int threadCount = 0; threadCount < programOptions.dbThreadCount; ++threadCount)
+    {
+        ioThreads.emplace_back([this]() { ioContext.run(); });
+    }
+
+    startWriteBehind(programOptions.writeBehindDepth);
+}
+
+DBInterface::~DBInterface()
+{
+    // The queued writes are flushed while the connection pool is still running.
+    stopWriteBehind();
+
+    // An open transaction is rolled back when its connection is reset by the pool,
+    // the connection belongs to the pool's executor.
+    boost::asio::post(ioContext, [this]() {
+        {
+            std::lock_guard<std::mutex> guard(transactionLock);
+            transactionConnection.reset();
+        }
+        connectionPool->cancel();
+    });
+    ioWorkGuard.reset();
+    for (auto& ioThread: ioThreads)
+    {
+        if (ioThread.joinable())
+        {
+            ioThread.join();
+        }
+    }
+
+    if (reportStatisticsOnExit)
+    {
+        statementStatistics.report(std::clog);
+    }
+}
+
+bool DBInterface::beginTransaction()
+{
+    clearPreviousErrors();
+
+    return reportStatus(runOnIoContext(async_beginTransaction()));
+}
+
+bool DBInterface::commit()
+{
+    clearPreviousErrors();
+
+    return reportStatus(runOnIoContext(async_commit()));
+}
+
+bool DBInterface::rollback()
+{
+    clearPreviousErrors();
+
+    return reportStatus(runOnIoContext(async_rollback()));
+}
+
+bool DBInterface::insertIntoDataBase(ModelBase& model)
+{
+    clearPreviousErrors();
+
+    return reportStatus(runOnIoContext(async_insert(model)));
+}
+
+bool DBInterface::getUniqueModelFromDB(ModelShp model, std::vector<WhereArg> whereArgs)
+{
+    clearPreviousErrors();
+
+    return reportStatus(runOnIoContext(async_getUniqueModel(model, whereArgs)));
+}
+
+ModelShp DBInterface::getCachedModelFromDB(ModelShp model, std::vector<WhereArg> whereArgs)
+{
+    clearPreviousErrors();
+
+    std::expected<ModelShp, std::string> found = runOnIoContext(async_getCachedModel(model, whereArgs));
+    if (!found)
+    {
+        appendErrorMessage(found.error());
+        return nullptr;
+    }
+
+    return *found;
+}
+
+bool DBInterface::getUniqueModelsFromDB(ModelList& models, const std::vector<std::string>& keyColumnNames,
+    const std::vector<KeyTuple>& keys)
+{
+    clearPreviousErrors();
+
+    return reportModelStatus(runOnIoContext(async_getUniqueModels(models, keyColumnNames, keys)));
+}
+
+bool DBInterface::getTasksChangedSince(std::size_t userID, const ChangeWatermark& watermark, ChangedTasks& changes)
+{
+    clearPreviousErrors();
+
+    std::expected<ChangedTasks, std::string> found = runOnIoContext(async_getTasksChangedSince(userID, watermark));
+    if (!found)
+    {
+        appendErrorMessage(found.error());
+        return false;
+    }
+
+    changes = std::move(*found);
+    return true;
+}
+
+bool DBInterface::getTaskSubtree(std::size_t rootTaskID, std::size_t maxDepth, TaskTreeNodeShp& root)
+{
+    clearPreviousErrors();
+
+    DBStatus validDepth = validateTaskSubtreeDepth(maxDepth);
+    if (!validDepth)
+    {
+        return reportStatus(validDepth);
+    }
+
+    std::expected<TaskTreeNodeShp, std::string> found = runOnIoContext(async_getTaskSubtree(rootTaskID, maxDepth));
+    if (!found)
+    {
+        appendErrorMessage(found.error());
+        return false;
+    }
+
+    root = std::move(*found);
+    return true;
+}
+
+bool DBInterface::insertManyIntoDataBase(ModelList& models)
+{
+    clearPreviousErrors();
+
+    return reportModelStatus(runOnIoContext(async_insertMany(models)));
+}
+
+bool DBInterface::updateInDataBase(ModelBase& model)
+{
+    clearPreviousErrors();
+
+    return reportStatus(runOnIoContext(async_update(model)));
+}
+
+bool DBInterface::updateManyInDataBase(ModelList& models)
+{
+    clearPreviousErrors();
+
+    return reportModelStatus(runOnIoContext(async_updateMany(models)));
+}
+
+bool DBInterface::executePipeline(std::vector<PipelineStage>& stages)
+{
+    clearPreviousErrors();
+
+    runOnIoContext(async_executePipeline(stages));
+
+    return reportPipelineStatus(stages);
+}
+
+std::vector<DBStatus> DBInterface::insertOutsideTransaction(ModelList& models)
+{
+    return runOnIoContext(async_insertMany(models, TransactionUse::Bypass));
+}
+
+std::vector<DBStatus> DBInterface::updateOutsideTransaction(ModelList& models)
+{
+    return runOnIoContext(async_updateMany(models, TransactionUse::Bypass));
+}
+
+bool DBInterface::getAllUsers(UserBatchCallback onBatch)
+{
+    clearPreviousErrors();
+
+    return reportStatus(runOnIoContext(async_getAllUsers(onBatch)));
+}
+
+bool DBInterface::getAllTasksForUser(std::size_t userID, TaskBatchCallback onBatch)
+{
+    clearPreviousErrors();
+
+    return reportStatus(runOnIoContext(async_getAllTasksForUser(userID, onBatch)));
+}
+
+bool DBInterface::getProjectedModelFromDB(ModelShp model, std::vector<WhereArg> whereArgs, FieldProjection projection)
+{
+    clearPreviousErrors();
+
+    return reportStatus(runOnIoContext(async_getProjectedModel(model, std::move(whereArgs), std::move(projection))));
+}
+
+bool DBInterface::getAllUsers(UserBatchCallback onBatch, FieldProjection projection)
+{
+    clearPreviousErrors();
+
+    return reportStatus(runOnIoContext(async_getAllUsers(onBatch, std::move(projection))));
+}
+
+DBStatus DBInterface::loadMissingFields(ModelBase& model)
+{
+    return runOnIoContext(async_loadMissingFields(model));
+}
+
+bool DBInterface::getTaskPageForUser(std::size_t userID, TaskPageOrder order, std::size_t pageSize,
+    const std::string& cursor, TaskPage& page)
+{
+    clearPreviousErrors();
+
+    std::expected<TaskPage, std::string> found = runOnIoContext(async_getTaskPageForUser(userID, order, pageSize, cursor));
+    if (!found)
+    {
+        appendErrorMessage(found.error());
+        return false;
+    }
+
+    page = std::move(*found);
+    return true;
+}
+
+boost::asio::awaitable<DBStatus> DBInterface::async_insert(ModelBase& model)
+{
+    DBStatus insertable = validateModelForInsert(model);
+    if (!insertable)
+    {
+        co_return insertable;
+    }
+
+    std::vector<std::string> columnNames;
+    std::vector<boost::mysql::field> parameters;
+    collectInsertValues(model, columnNames, parameters);
+
+    if (groupCommitWindow.count() > 0 && !isTransactionActive())
+    {
+        co_return co_await insertWithGroupCommit(model, getTableNameFrom(model), std::move(columnNames),
+            std::move(parameters));
+    }
+
+    try
+    {
+        boost::mysql::results results = co_await executePreparedStatementCoRoutine(PreparedStatementKind::Insert,
+            getTableNameFrom(model), std::move(columnNames), std::move(parameters));
+        model.setPrimaryKey(results.last_insert_id());
+        model.clearDirtyBits();
+        refreshModelCache(model);
+    }
+    catch(const std::exception& e)
+    {
+        std::string eMsg("In DBInterface::async_insert(ModelBase &model) ");
+        eMsg += e.what();
+        co_return std::unexpected(eMsg);
+    }
+
+    co_return DBStatus{};
+}
+
+/*
+ * Only the columns whose fields were modified are written, the row is selected by
+ * the primary key. A model without modified fields is not sent to the server.
+ */
+boost::asio::awaitable<DBStatus> DBInterface::async_update(ModelBase& model)
+{
+    DBStatus updatable = validateModelForUpdate(model);
+    if (!updatable)
+    {
+        co_return updatable;
+    }
+
+    std::vector<std::string> columnNames;
+    std::vector<boost::mysql::field> parameters;
+    if (!collectUpdateValues(model, columnNames, parameters))
+    {
+        co_return DBStatus{};
+    }
+
+    try
+    {
+        boost::mysql::results result = co_await executePreparedStatementCoRoutine(PreparedStatementKind::Update,
+            getTableNameFrom(model), std::move(columnNames), std::move(parameters));
+        if (!updateMatchedRow(result))
+        {
+            co_return reportNoRowUpdated(model);
+        }
+        model.clearDirtyBits();
+        refreshModelCache(model);
+    }
+    catch(const std::exception& e)
+    {
+        std::string eMsg("In DBInterface::async_update(ModelBase &model) ");
+        eMsg += e.what();
+        co_return std::unexpected(eMsg);
+    }
+
+    co_return DBStatus{};
+}
+
+/*
+ * The updates are sent as a pipeline, models with the same set of modified columns
+ * share one prepared statement.
+ */
+boost::asio::awaitable<std::vector<DBStatus>> DBInterface::async_updateMany(ModelList& models,
+    TransactionUse transactionUse)
+{
+    std::vector<PipelineStage> stages;
+    stages.reserve(models.size());
+    for (auto& model: models)
+    {
+        stages.push_back({PipelineStage::Kind::Update, model, {}, {}});
+    }
+
+    co_await async_executePipeline(stages, transactionUse);
+
+    std::vector<DBStatus> modelStatus;
+    modelStatus.reserve(stages.size());
+    for (auto& stage: stages)
+    {
+        modelStatus.push_back(std::move(stage.status));
+    }
+
+    co_return modelStatus;
+}
+
+/*
+ * Models are grouped by table and by the set of columns that have values. Each
+ * group is inserted with multi-row INSERT statements that stay under the row and
+ * byte limits. Keys are assigned from the range that starts at last_insert_id().
+ * A statement that fails inserts nothing, so the models of that statement are
+ * retried one at a time to find the rows that are at fault.
+ */
+boost::asio::awaitable<std::vector<DBStatus>> DBInterface::async_insertMany(ModelList& models,
+    TransactionUse transactionUse)
 {
-    dbConnectionParameters.server_address.emplace_host_and_port(programOptions.mySqlUrl, programOptions.mySqlPort);
-    dbConnectionParameters.username = programOptions.mySqlUser;
-    dbConnectionParameters.password = programOptions.mySqlPassword;
-    dbConnectionParameters.database = programOptions.mySqlDBName;
+    std::vector<DBStatus> modelStatus(models.size());
+    std::vector<BulkInsertGroup> insertGroups = groupModelsForBulkInsert(models, modelStatus);
+
+    if (insertGroups.empty())
+    {
+        co_return modelStatus;
+    }
+
+    boost::mysql::pooled_connection conn;
+    try
+    {
+        conn = co_await checkOutConnection(statementStatistics.getMetrics(StatementKind::BulkInsert, "*"),
+            transactionUse);
+        conn->set_meta_mode(boost::mysql::metadata_mode::minimal);
+        std::uint64_t keyIncrement = co_await getAutoIncrementIncrement(conn);
+        boost::mysql::format_options formatOptions = conn->format_opts().value();
+
+        for (const auto& insertGroup: insertGroups)
+        {
+            std::string statementStart = formatBulkInsertStart(formatOptions, insertGroup);
+            std::vector<std::size_t> chunkModels;
+            std::vector<std::string> chunkRows;
+            std::size_t chunkBytes = statementStart.size();
+
+            for (std::size_t groupRow = 0; groupRow < insertGroup.modelIndexes.size(); ++groupRow)
+            {
+                std::string rowValues = formatBulkInsertRow(formatOptions, insertGroup.rowParameters[groupRow]);
+                if (!chunkModels.empty() && (chunkModels.size() >= bulkInsertMaxRows ||
+                    chunkBytes + rowValues.size() + 2 > bulkInsertMaxBytes))
+                {
+                    co_await executeBulkInsertChunk(conn, insertGroup, statementStart, chunkRows, chunkModels,
+                        models, modelStatus, keyIncrement);
+                    chunkModels.clear();
+                    chunkRows.clear();
+                    chunkBytes = statementStart.size();
+                }
+                chunkBytes += rowValues.size() + 2;
+                chunkRows.push_back(std::move(rowValues));
+                chunkModels.push_back(insertGroup.modelIndexes[groupRow]);
+            }
+
+            if (!chunkModels.empty())
+            {
+                co_await executeBulkInsertChunk(conn, insertGroup, statementStart, chunkRows, chunkModels,
+                    models, modelStatus, keyIncrement);
+            }
+        }
+
+        returnConnection(conn);
+    }
+    catch(const std::exception& e)
+    {
+        returnConnectionAfterError(conn);
+        std::string eMsg("In DBInterface::async_insertMany() ");
+        eMsg += e.what();
+        for (std::size_t modelIndex = 0; modelIndex < models.size(); ++modelIndex)
+        {
+            if (modelStatus[modelIndex] && !models[modelIndex]->isInDataBase())
+            {
+                modelStatus[modelIndex] = std::unexpected(eMsg);
+            }
+        }
+    }
+
+    co_return modelStatus;
 }
 
-bool DBInterface::insertIntoDataBase(ModelBase& model)
-{
-    clearPreviousErrors();
+/*
+ * The stages are sent to the server in one write per chunk of pipelineDepth
+ * stages, the responses come back in the same order. Batch latency depends on
+ * the amount of data rather than the number of round trips.
+ */
+boost::asio::awaitable<bool> DBInterface::async_executePipeline(std::vector<PipelineStage>& stages,
+    TransactionUse transactionUse)
+{
+    std::vector<PipelinedStatement> pipelinedStatements;
+
+    for (std::size_t stageIndex = 0; stageIndex < stages.size(); ++stageIndex)
+    {
+        PipelineStage& stage = stages[stageIndex];
+        if (!stage.model)
+        {
+            stage.status = std::unexpected(std::string("NULL model pointer.\n"));
+            continue;
+        }
+
+        PipelinedStatement statement{stageIndex, PreparedStatementKind::Select, getTableNameFrom(*stage.model), {}, {}};
+        switch (stage.kind)
+        {
+            case PipelineStage::Kind::Insert :
+                stage.status = validateModelForInsert(*stage.model);
+                statement.kind = PreparedStatementKind::Insert;
+                if (stage.status)
+                {
+                    collectInsertValues(*stage.model, statement.columnNames, statement.parameters);
+                }
+                break;
+
+            case PipelineStage::Kind::Update :
+                stage.status = validateModelForUpdate(*stage.model);
+                statement.kind = PreparedStatementKind::Update;
+                if (stage.status && !collectUpdateValues(*stage.model, statement.columnNames, statement.parameters))
+                {
+                    // Nothing was modified, the stage succeeds without a statement.
+                    continue;
+                }
+                break;
+
+            case PipelineStage::Kind::Select :
+                stage.status = DBStatus{};
+                collectWhereValues(stage.whereArgs, statement.columnNames, statement.parameters);
+                break;
+        }
+
+        if (stage.status)
+        {
+            pipelinedStatements.push_back(std::move(statement));
+        }
+    }
+
+    std::size_t chunkStart = 0;
+    boost::mysql::pooled_connection conn;
+    try
+    {
+        conn = co_await checkOutConnection(statementStatistics.getMetrics(StatementKind::Pipeline, "*"),
+            transactionUse);
+        conn->set_meta_mode(boost::mysql::metadata_mode::full);
+
+        for ( ; chunkStart < pipelinedStatements.size(); chunkStart += pipelineDepth)
+        {
+            std::size_t chunkEnd = std::min(chunkStart + pipelineDepth, pipelinedStatements.size());
+            bool connectionUsable = co_await executePipelineChunk(conn, pipelinedStatements, chunkStart, chunkEnd,
+                stages);
+            if (!connectionUsable)
+            {
+                // The stages of the chunk already report the outcome of their statements.
+                chunkStart = chunkEnd;
+                throwStatementTimeout(conn);
+            }
+        }
+
+        returnConnection(conn);
+    }
+    catch(const std::exception& e)
+    {
+        returnConnectionAfterError(conn);
+        std::string eMsg("In DBInterface::async_executePipeline() ");
+        eMsg += e.what();
+        for ( ; chunkStart < pipelinedStatements.size(); ++chunkStart)
+        {
+            stages[pipelinedStatements[chunkStart].stageIndex].status = std::unexpected(eMsg);
+        }
+    }
+
+    bool allStagesSucceeded = true;
+    for (const auto& stage: stages)
+    {
+        if (!stage.status)
+        {
+            allStagesSucceeded = false;
+        }
+    }
+
+    co_return allStagesSucceeded;
+}
+
+boost::asio::awaitable<DBStatus> DBInterface::async_getAllUsers(UserBatchCallback onBatch)
+{
+    UserList userBatch;
+
+    co_return co_await streamModelsFromDB(UserModel().getTableName(), {}, {},
+        []() { return std::make_shared<UserModel>(); },
+        [&userBatch, &onBatch](ModelList& modelBatch) {
+            userBatch.clear();
+            for (auto& model: modelBatch)
+            {
+                userBatch.push_back(std::static_pointer_cast<UserModel>(model));
+            }
+            onBatch(userBatch);
+        }, AllColumns);
+}
+
+/*
+ * Every streamed user is marked before its row is converted, the converted
+ * columns are marked loaded again.
+ */
+boost::asio::awaitable<DBStatus> DBInterface::async_getAllUsers(UserBatchCallback onBatch, FieldProjection projection)
+{
+    UserList userBatch;
+    std::expected<std::vector<std::size_t>, std::string> loadedSlots = findProjectedSlots(UserModel(), projection);
+    if (!loadedSlots)
+    {
+        co_return std::unexpected(loadedSlots.error());
+    }
+    std::vector<std::string> selectColumnNames = getSlotColumnNames(UserModel(), *loadedSlots);
+
+    co_return co_await streamModelsFromDB(UserModel().getTableName(), {}, {},
+        [&loadedSlots]() {
+            std::shared_ptr<UserModel> user = std::make_shared<UserModel>();
+            user->markNotLoadedExcept(*loadedSlots);
+            return user;
+        },
+        [&userBatch, &onBatch](ModelList& modelBatch) {
+            userBatch.clear();
+            for (auto& model: modelBatch)
+            {
+                userBatch.push_back(std::static_pointer_cast<UserModel>(model));
+            }
+            onBatch(userBatch);
+        }, std::move(selectColumnNames));
+}
+
+boost::asio::awaitable<DBStatus> DBInterface::async_getAllTasksForUser(std::size_t userID, TaskBatchCallback onBatch)
+{
+    TaskList taskBatch;
+    std::vector<std::string> whereColumnNames{"AsignedTo"};
+    std::vector<boost::mysql::field> parameters{convertDataValueToField(userID)};
+
+    co_return co_await streamModelsFromDB(TaskModel().getTableName(), std::move(whereColumnNames), std::move(parameters),
+        []() { return std::make_shared<TaskModel>(); },
+        [&taskBatch, &onBatch](ModelList& modelBatch) {
+            taskBatch.clear();
+            for (auto& model: modelBatch)
+            {
+                taskBatch.push_back(std::static_pointer_cast<TaskModel>(model));
+            }
+            onBatch(taskBatch);
+        }, AllColumns);
+}
+
+/*
+ * One row more than the page holds is read to find out whether there is a next
+ * page.
+ */
+boost::asio::awaitable<std::expected<TaskPage, std::string>> DBInterface::async_getTaskPageForUser(std::size_t userID,
+    TaskPageOrder order, std::size_t pageSize, std::string cursor)
+{
+    if (pageSize == 0)
+    {
+        co_return std::unexpected(std::string("The page size must be at least 1.\n"));
+    }
+
+    std::optional<TaskPageCursor> position;
+    if (!cursor.empty())
+    {
+        std::expected<TaskPageCursor, std::string> parsedCursor = parseTaskPageCursor(cursor, order, userID);
+        if (!parsedCursor)
+        {
+            co_return std::unexpected(parsedCursor.error());
+        }
+        position = *parsedCursor;
+    }
+
+    TaskPage page;
+
+    try
+    {
+        page.tasks = co_await selectTasks(
+            [this, userID, order, pageSize, &position](const boost::mysql::format_options& formatOptions) {
+                return formatTaskPage(formatOptions, userID, order, pageSize + 1, position);
+            });
+
+        if (page.tasks.size() > pageSize)
+        {
+            page.tasks.resize(pageSize);
+            const TaskModel& lastTask = *page.tasks.back();
+            TaskPageCursor nextPosition{order, userID, lastTask.getDueDate(), lastTask.getTaskID()};
+            page.nextCursor = makeTaskPageCursor(nextPosition);
+        }
+    }
+    catch(const std::exception& e)
+    {
+        std::string eMsg("In DBInterface::async_getTaskPageForUser() ");
+        eMsg += e.what();
+        co_return std::unexpected(eMsg);
+    }
+
+    co_return page;
+}
+
+/*
+ * Reads the tasks through AsignedTo_LastModified_idx, only the rows of the change
+ * window are read.
+ */
+boost::asio::awaitable<std::expected<ChangedTasks, std::string>> DBInterface::async_getTasksChangedSince(
+    std::size_t userID, ChangeWatermark watermark)
+{
+    TaskList windowTasks;
+    ChangeStamp windowStart = getChangeWindowStart(watermark);
+
+    try
+    {
+        windowTasks = co_await selectTasks(
+            [this, userID, windowStart](const boost::mysql::format_options& formatOptions) {
+                return formatTasksChangedSince(formatOptions, userID, windowStart);
+            });
+    }
+    catch(const std::exception& e)
+    {
+        std::string eMsg("In DBInterface::async_getTasksChangedSince() ");
+        eMsg += e.what();
+        co_return std::unexpected(eMsg);
+    }
+
+    co_return skipSeenChanges(watermark, std::move(windowTasks));
+}
+
+/*
+ * The whole subtree is read in one round trip, parents are returned before their
+ * children.
+ */
+boost::asio::awaitable<std::expected<TaskTreeNodeShp, std::string>> DBInterface::async_getTaskSubtree(
+    std::size_t rootTaskID, std::size_t maxDepth)
+{
+    TaskList tasks;
+
+    try
+    {
+        tasks = co_await selectTasks(
+            [this, rootTaskID, maxDepth](const boost::mysql::format_options& formatOptions) {
+                return formatTaskSubtree(formatOptions, rootTaskID, maxDepth);
+            });
+    }
+    catch(const std::exception& e)
+    {
+        std::string eMsg("In DBInterface::async_getTaskSubtree() ");
+        eMsg += e.what();
+        co_return std::unexpected(eMsg);
+    }
+
+    co_return buildTaskTree(rootTaskID, tasks);
+}
+
+boost::asio::awaitable<DBStatus> DBInterface::async_getUniqueModel(ModelShp model, std::vector<WhereArg> whereArgs)
+{
+    std::expected<ModelShp, std::string> found = co_await async_getCachedModel(model, std::move(whereArgs));
+    if (!found)
+    {
+        co_return std::unexpected(found.error());
+    }
+
+    co_return DBStatus{};
+}
+
+/*
+ * The model cache only holds fully loaded models, so a projected read always
+ * goes to the server and its model is not stored.
+ */
+boost::asio::awaitable<DBStatus> DBInterface::async_getProjectedModel(ModelShp model, std::vector<WhereArg> whereArgs,
+    FieldProjection projection)
+{
+    if (!model)
+    {
+        std::invalid_argument missingModelPtr("NULL model pointer in DBInterface::async_getProjectedModel()!");
+        throw missingModelPtr;
+    }
+
+    std::expected<std::vector<std::size_t>, std::string> loadedSlots = findProjectedSlots(*model, projection);
+    if (!loadedSlots)
+    {
+        co_return std::unexpected(loadedSlots.error());
+    }
+
+    std::vector<std::string> whereColumnNames;
+    std::vector<boost::mysql::field> parameters;
+    collectWhereValues(whereArgs, whereColumnNames, parameters);
+    model->markNotLoadedExcept(*loadedSlots);
+
+    try
+    {
+        co_return co_await executeSimpleQueryProcessResults(getTableNameFrom(*model), std::move(whereColumnNames),
+            std::move(parameters), *model, getSlotColumnNames(*model, *loadedSlots));
+    }
+    catch(const std::exception& e)
+    {
+        std::string eMsg("In DBInterface::async_getProjectedModel ");
+        eMsg += e.what();
+        co_return std::unexpected(eMsg);
+    }
+}
+
+/*
+ * The missing fields are read by primary key. A field that was set after the
+ * projected read counts as loaded, it keeps its new value.
+ */
+boost::asio::awaitable<DBStatus> DBInterface::async_loadMissingFields(ModelBase& model)
+{
+    std::vector<std::string> missingColumnNames = model.getNotLoadedFieldNames();
+    if (missingColumnNames.empty())
+    {
+        co_return DBStatus{};
+    }
+
+    if (!model.isInDataBase())
+    {
+        co_return std::unexpected(model.getModelName() + " is not in the database, its missing fields can't be loaded.\n");
+    }
+
+    std::vector<std::string> whereColumnNames{model.getFieldBySlot(0).getColumnName()};
+    std::vector<boost::mysql::field> parameters{convertDataValueToField(model.getPrimaryKey())};
+
+    try
+    {
+        co_return co_await executeSimpleQueryProcessResults(getTableNameFrom(model), std::move(whereColumnNames),
+            std::move(parameters), model, std::move(missingColumnNames));
+    }
+    catch(const std::exception& e)
+    {
+        std::string eMsg("In DBInterface::async_loadMissingFields ");
+        eMsg += e.what();
+        co_return std::unexpected(eMsg);
+    }
+}
+
+boost::asio::awaitable<std::expected<ModelShp, std::string>> DBInterface::async_getCachedModel(ModelShp model,
+    std::vector<WhereArg> whereArgs)
+{
+    if (!model)
+    {
+        std::invalid_argument missingModelPtr("NULL model pointer in DBInterface::async_getCachedModel()!");
+        throw missingModelPtr;
+    }
+
+    if (modelCache.find(*model, whereArgs))
+    {
+        co_return model;
+    }
+
+    std::vector<std::string> whereColumnNames;
+    std::vector<boost::mysql::field> parameters;
+    collectWhereValues(whereArgs, whereColumnNames, parameters);
+
+    try
+    {
+        DBStatus status = co_await executeSimpleQueryProcessResults(getTableNameFrom(*model),
+            std::move(whereColumnNames), std::move(parameters), *model, AllColumns);
+        if (!status)
+        {
+            co_return std::unexpected(status.error());
+        }
+    }
+    catch(const std::exception& e)
+    {
+        std::string eMsg("In DBInterface::async_getCachedModel ");
+        eMsg += e.what();
+        co_return std::unexpected(eMsg);
+    }
+
+    storeInModelCache(*model);
+    co_return model;
+}
+
+/*
+ * Keys found in the model cache don't go to the server. The remaining distinct
+ * keys are looked up lookupBatchSize keys per query, each returned row is
+ * matched to the models waiting for its key.
+ */
+boost::asio::awaitable<std::vector<DBStatus>> DBInterface::async_getUniqueModels(ModelList& models,
+    std::vector<std::string> keyColumnNames, std::vector<KeyTuple> keys)
+{
+    std::vector<DBStatus> modelStatus(models.size());
+    if (keys.size() != models.size())
+    {
+        std::string eMsg("The number of keys doesn't match the number of models.\n");
+        std::fill(modelStatus.begin(), modelStatus.end(), std::unexpected(eMsg));
+        co_return modelStatus;
+    }
+
+    std::string tableName;
+    std::vector<std::string> lookupKeys;
+    std::vector<const KeyTuple*> lookupTuples;
+    WaitingModelMap modelsByKey;
+
+    for (std::size_t modelIndex = 0; modelIndex < models.size(); ++modelIndex)
+    {
+        if (!models[modelIndex])
+        {
+            modelStatus[modelIndex] = std::unexpected(std::string("NULL model pointer.\n"));
+            continue;
+        }
+
+        if (keys[modelIndex].size() != keyColumnNames.size())
+        {
+            modelStatus[modelIndex] = std::unexpected(std::format("The key has {} values for {} key columns.\n",
+                keys[modelIndex].size(), keyColumnNames.size()));
+            continue;
+        }
+
+        std::string modelTableName = getTableNameFrom(*models[modelIndex]);
+        if (tableName.empty())
+        {
+            tableName = modelTableName;
+        }
+        else if (modelTableName != tableName)
+        {
+            modelStatus[modelIndex] = std::unexpected(std::format("The model is not from table {}.\n", tableName));
+            continue;
+        }
+
+        std::vector<WhereArg> whereArgs;
+        for (std::size_t keyColumn = 0; keyColumn < keyColumnNames.size(); ++keyColumn)
+        {
+            whereArgs.push_back({keyColumnNames[keyColumn], keys[modelIndex][keyColumn]});
+        }
+        if (modelCache.find(*models[modelIndex], whereArgs))
+        {
+            continue;
+        }
+
+        std::string keyString = makeLookupKeyString(keys[modelIndex]);
+        auto [waitingModels, newKey] = modelsByKey.try_emplace(keyString);
+        if (newKey)
+        {
+            lookupKeys.push_back(keyString);
+            lookupTuples.push_back(&keys[modelIndex]);
+        }
+        waitingModels->second.push_back(modelIndex);
+    }
+
+    if (lookupKeys.empty())
+    {
+        co_return modelStatus;
+    }
+
+    std::size_t chunkStart = 0;
+    boost::mysql::pooled_connection conn;
+    try
+    {
+        StatementMetrics& metrics = statementStatistics.getMetrics(StatementKind::KeyLookup, tableName);
+        conn = co_await checkOutConnection(metrics);
+        conn->set_meta_mode(boost::mysql::metadata_mode::full);
+        boost::mysql::format_options formatOptions = conn->format_opts().value();
+
+        for ( ; chunkStart < lookupKeys.size(); chunkStart += lookupBatchSize)
+        {
+            std::size_t chunkEnd = std::min(chunkStart + lookupBatchSize, lookupKeys.size());
+            ModelBase& modelPrototype = *models[modelsByKey.at(lookupKeys[chunkStart]).front()];
+            co_await executeKeyLookupChunk(conn, metrics,
+                formatKeyLookup(formatOptions, tableName, keyColumnNames, lookupTuples, chunkStart, chunkEnd),
+                keyColumnNames, modelPrototype, modelsByKey, models, modelStatus);
+        }
+
+        returnConnection(conn);
+    }
+    catch(const std::exception& e)
+    {
+        returnConnectionAfterError(conn);
+        std::string eMsg("In DBInterface::async_getUniqueModels() ");
+        eMsg += e.what();
+        for ( ; chunkStart < lookupKeys.size(); ++chunkStart)
+        {
+            auto waitingModels = modelsByKey.find(lookupKeys[chunkStart]);
+            if (waitingModels != modelsByKey.end())
+            {
+                for (auto modelIndex: waitingModels->second)
+                {
+                    modelStatus[modelIndex] = std::unexpected(eMsg);
+                }
+                modelsByKey.erase(waitingModels);
+            }
+        }
+    }
+
+    for (const auto& [keyString, waitingModels]: modelsByKey)
+    {
+        for (auto modelIndex: waitingModels)
+        {
+            if (modelStatus[modelIndex])
+            {
+                modelStatus[modelIndex] = std::unexpected(std::string("No results from query, object not found in database!"));
+            }
+        }
+    }
+
+    co_return modelStatus;
+}
+
+boost::asio::awaitable<DBStatus> DBInterface::async_beginTransaction()
+{
+    if (isTransactionActive())
+    {
+        co_return std::unexpected(std::string("A transaction is already open.\n"));
+    }
+
+    try
+    {
+        StatementMetrics& metrics = statementStatistics.getMetrics(StatementKind::Transaction, "");
+        boost::mysql::pooled_connection conn = co_await checkOutPooledConnection(metrics);
+        boost::mysql::results result;
+        co_await executeTextStatement(conn, metrics, "START TRANSACTION", result);
+
+        std::lock_guard<std::mutex> guard(transactionLock);
+        transactionConnectionID = &conn.get();
+        transactionConnection.emplace(std::move(conn));
+        transactionActive = true;
+        transactionLost = false;
+        transactionRowKeys.clear();
+    }
+    catch(const std::exception& e)
+    {
+        std::string eMsg("In DBInterface::async_beginTransaction() ");
+        eMsg += e.what();
+        co_return std::unexpected(eMsg);
+    }
+
+    co_return DBStatus{};
+}
+
+boost::asio::awaitable<DBStatus> DBInterface::async_commit()
+{
+    co_return co_await endTransaction("COMMIT");
+}
+
+boost::asio::awaitable<DBStatus> DBInterface::async_rollback()
+{
+    co_return co_await endTransaction("ROLLBACK");
+}
+
+/*
+ * Protected or private methods.
+ */
+void DBInterface::collectInsertValues(ModelBase& model, std::vector<std::string>& columnNames,
+    std::vector<boost::mysql::field>& parameters)
+{
+    forEachSlotIn(model.getFieldsWithValue() & ~model.getGeneratedFields(), [this, &model, &columnNames, &parameters](std::size_t slot) {
+        const PTS_DataField& field = model.getFieldBySlot(slot);
+        columnNames.push_back(field.getColumnName());
+        parameters.push_back(convertDataFieldToField(field));
+    });
+}
+
+/*
+ * The primary key is always the last column and the last parameter, see
+ * formatUpdate(). Returns false if no field that is written was modified.
+ */
+bool DBInterface::collectUpdateValues(ModelBase& model, std::vector<std::string>& columnNames,
+    std::vector<boost::mysql::field>& parameters)
+{
+    FieldMask modifiedFields = model.getModifiedFields() & ~fieldSlotBit(0) & ~model.getGeneratedFields();
+    if (!modifiedFields)
+    {
+        return false;
+    }
+
+    forEachSlotIn(modifiedFields, [this, &model, &columnNames, &parameters](std::size_t slot) {
+        const PTS_DataField& field = model.getFieldBySlot(slot);
+        columnNames.push_back(field.getColumnName());
+        parameters.push_back(convertDataFieldToField(field));
+    });
+
+    const PTS_DataField& primaryKey = model.getFieldBySlot(0);
+    columnNames.push_back(primaryKey.getColumnName());
+    parameters.push_back(convertDataFieldToField(primaryKey));
+
+    return true;
+}
+
+void DBInterface::collectWhereValues(std::vector<WhereArg>& whereArgs, std::vector<std::string>& columnNames,
+    std::vector<boost::mysql::field>& parameters)
+{
+    for (auto& whereArg: whereArgs)
+    {
+        columnNames.push_back(whereArg.first);
+        parameters.push_back(convertDataFieldToField(whereArg.second));
+    }
+}
+
+std::vector<DBInterface::BulkInsertGroup> DBInterface::groupModelsForBulkInsert(ModelList& models,
+    std::vector<DBStatus>& modelStatus)
+{
+    std::vector<BulkInsertGroup> insertGroups;
+    std::unordered_map<std::string, std::size_t> groupIndexes;
+
+    for (std::size_t modelIndex = 0; modelIndex < models.size(); ++modelIndex)
+    {
+        if (!models[modelIndex])
+        {
+            modelStatus[modelIndex] = std::unexpected(std::string("NULL model pointer.\n"));
+            continue;
+        }
+
+        ModelBase& model = *models[modelIndex];
+        modelStatus[modelIndex] = validateModelForInsert(model);
+        if (!modelStatus[modelIndex])
+        {
+            continue;
+        }
+
+        std::vector<std::string> columnNames;
+        std::vector<boost::mysql::field> parameters;
+        collectInsertValues(model, columnNames, parameters);
+
+        std::string tableName = getTableNameFrom(model);
+        std::string groupKey = makeStatementCacheKey(PreparedStatementKind::Insert, tableName, columnNames);
+        auto [groupEntry, newGroup] = groupIndexes.try_emplace(groupKey, insertGroups.size());
+        if (newGroup)
+        {
+            insertGroups.push_back({tableName, std::move(columnNames), {}, {}});
+        }
+
+        BulkInsertGroup& insertGroup = insertGroups[groupEntry->second];
+        insertGroup.modelIndexes.push_back(modelIndex);
+        insertGroup.rowParameters.push_back(std::move(parameters));
+    }
+
+    return insertGroups;
+}
+
+std::string DBInterface::formatBulkInsertStart(const boost::mysql::format_options& formatOptions,
+    const BulkInsertGroup& insertGroup)
+{
+    boost::mysql::format_context sqlContext(formatOptions);
+    boost::mysql::format_sql_to(sqlContext, "INSERT INTO {} (", boost::mysql::identifier(databaseName, insertGroup.tableName));
+
+    bool noComma = true;
+    for (const auto& columnName: insertGroup.columnNames)
+    {
+        if (!noComma)
+        {
+            sqlContext.append_raw(", ");
+        }
+        boost::mysql::format_sql_to(sqlContext, "{}", boost::mysql::identifier(columnName));
+        noComma = false;
+    }
+    sqlContext.append_raw(") VALUES ");
+
+    return std::move(sqlContext).get().value();
+}
+
+std::string DBInterface::formatBulkInsertRow(const boost::mysql::format_options& formatOptions,
+    const std::vector<boost::mysql::field>& rowParameters)
+{
+    boost::mysql::format_context sqlContext(formatOptions);
+    sqlContext.append_raw("(");
+
+    bool noComma = true;
+    for (const auto& parameter: rowParameters)
+    {
+        if (!noComma)
+        {
+            sqlContext.append_raw(", ");
+        }
+        sqlContext.append_value(parameter);
+        noComma = false;
+    }
+    sqlContext.append_raw(")");
+
+    return std::move(sqlContext).get().value();
+}
+
+/*
+ * Multi-row inserts receive consecutive keys that are auto_increment_increment
+ * apart, the server setting is read once.
+ */
+boost::asio::awaitable<std::uint64_t> DBInterface::getAutoIncrementIncrement(boost::mysql::pooled_connection& conn)
+{
+    if (autoIncrementIncrement == 0)
+    {
+        boost::mysql::results result;
+        co_await conn->async_execute("SELECT @@SESSION.auto_increment_increment", result,
+            boost::asio::cancel_after(queryTimeout));
+        boost::mysql::field_view increment = result.rows().at(0).at(0);
+        autoIncrementIncrement = increment.is_int64()? static_cast<std::uint64_t>(increment.as_int64()) :
+            increment.as_uint64();
+    }
+
+    co_return autoIncrementIncrement.load();
+}
+
+boost::asio::awaitable<void> DBInterface::executeBulkInsertChunk(boost::mysql::pooled_connection& conn,
+    const BulkInsertGroup& insertGroup, const std::string& statementStart, const std::vector<std::string>& chunkRows,
+    const std::vector<std::size_t>& chunkModels, ModelList& models, std::vector<DBStatus>& modelStatus,
+    std::uint64_t keyIncrement)
+{
+    std::string sqlStatement(statementStart);
+    bool noComma = true;
+    for (const auto& rowValues: chunkRows)
+    {
+        sqlStatement.append((noComma)? "" : ", ");
+        sqlStatement.append(rowValues);
+        noComma = false;
+    }
+
+    if (verboseOutput)
+    {
+        std::clog << "Executing bulk insert of " << chunkRows.size() << " rows into " << insertGroup.tableName << std::endl;
+    }
+
+    boost::mysql::results result;
+    bool chunkFailed = false;
+    try
+    {
+        co_await executeTextStatement(conn, statementStatistics.getMetrics(StatementKind::BulkInsert,
+            insertGroup.tableName), sqlStatement, result);
+    }
+    catch(const boost::mysql::error_with_diagnostics& e)
+    {
+        if (!isServerError(e.code()))
+        {
+            throw;
+        }
+        chunkFailed = true;
+    }
+
+    if (!chunkFailed)
+    {
+        std::uint64_t primaryKey = result.last_insert_id();
+        for (auto modelIndex: chunkModels)
+        {
+            models[modelIndex]->setPrimaryKey(primaryKey);
+            models[modelIndex]->clearDirtyBits();
+            refreshModelCache(*models[modelIndex]);
+            primaryKey += keyIncrement;
+        }
+        co_return;
+    }
+
+    for (auto modelIndex: chunkModels)
+    {
+        std::vector<std::string> columnNames;
+        std::vector<boost::mysql::field> parameters;
+        collectInsertValues(*models[modelIndex], columnNames, parameters);
+
+        try
+        {
+            boost::mysql::results rowResult = co_await executePreparedStatementOnConnection(conn,
+                PreparedStatementKind::Insert, insertGroup.tableName, columnNames, parameters);
+            models[modelIndex]->setPrimaryKey(rowResult.last_insert_id());
+            models[modelIndex]->clearDirtyBits();
+            refreshModelCache(*models[modelIndex]);
+        }
+        catch(const boost::mysql::error_with_diagnostics& e)
+        {
+            if (!isServerError(e.code()))
+            {
+                throw;
+            }
+            std::string eMsg("In DBInterface::async_insertMany() ");
+            eMsg += e.what();
+            modelStatus[modelIndex] = std::unexpected(eMsg);
+        }
+    }
+}
+/*
+ * Key values are compared as strings, the row's key is converted to the same
+ * value types as the model fields before it is turned into a string.
+ */
+std::string DBInterface::makeLookupKeyString(const KeyTuple& key)
+{
+    std::string keyString;
+
+    for (const auto& keyValue: key)
+    {
+        keyString += makeComparisonValue(keyValue.getValue());
+        keyString += '\x1f';
+    }
+
+    return keyString;
+}
+
+std::string DBInterface::formatKeyLookup(const boost::mysql::format_options& formatOptions,
+    const std::string& tableName, const std::vector<std::string>& keyColumnNames,
+    const std::vector<const KeyTuple*>& lookupTuples, std::size_t chunkStart, std::size_t chunkEnd)
+{
+    boost::mysql::format_context sqlContext(formatOptions);
+    boost::mysql::format_sql_to(sqlContext, "SELECT * FROM {} WHERE (", boost::mysql::identifier(databaseName, tableName));
+
+    bool noComma = true;
+    for (const auto& columnName: keyColumnNames)
+    {
+        sqlContext.append_raw((noComma)? "" : ", ");
+        boost::mysql::format_sql_to(sqlContext, "{}", boost::mysql::identifier(columnName));
+        noComma = false;
+    }
+    sqlContext.append_raw(") IN (");
+
+    for (std::size_t keyIndex = chunkStart; keyIndex < chunkEnd; ++keyIndex)
+    {
+        sqlContext.append_raw((keyIndex == chunkStart)? "(" : ", (");
+        noComma = true;
+        for (const auto& keyValue: *lookupTuples[keyIndex])
+        {
+            sqlContext.append_raw((noComma)? "" : ", ");
+            sqlContext.append_value(convertDataFieldToField(keyValue));
+            noComma = false;
+        }
+        sqlContext.append_raw(")");
+    }
+    sqlContext.append_raw(")");
+
+    return std::move(sqlContext).get().value();
+}
+
+boost::asio::awaitable<void> DBInterface::executeKeyLookupChunk(boost::mysql::pooled_connection& conn,
+    StatementMetrics& metrics, std::string sqlStatement, const std::vector<std::string>& keyColumnNames, ModelBase& modelPrototype,
+    WaitingModelMap& modelsByKey, ModelList& models, std::vector<DBStatus>& modelStatus)
+{
+    if (verboseOutput)
+    {
+        std::clog << "Executing " << sqlStatement << std::endl;
+    }
+
+    boost::mysql::results result;
+    co_await executeTextStatement(conn, metrics, sqlStatement, result);
+    if (result.rows().empty())
+    {
+        co_return;
+    }
+
+    StatisticsClock::time_point convertStart = StatisticsClock::now();
+
+    std::expected<ResultBindingPlan, std::string> bindingPlan = createBindingPlan(result.meta(), modelPrototype);
+    if (!bindingPlan)
+    {
+        throw std::runtime_error(bindingPlan.error());
+    }
+
+    std::vector<const ColumnBinding*> keyBindings;
+    KeyTuple rowKey;
+    for (const auto& keyColumnName: keyColumnNames)
+    {
+        for (const auto& binding: *bindingPlan)
+        {
+            const PTS_DataField& keyField = modelPrototype.getFieldBySlot(binding.fieldSlot);
+            if (keyField.getColumnName() == keyColumnName)
+            {
+                keyBindings.push_back(&binding);
+                rowKey.push_back(keyField);
+                break;
+            }
+        }
+    }
+
+    if (keyBindings.size() != keyColumnNames.size())
+    {
+        throw std::runtime_error("The result of the key lookup doesn't contain all key columns.");
+    }
+
+    for (boost::mysql::row_view row: result.rows())
+    {
+        for (std::size_t keyColumn = 0; keyColumn < keyBindings.size(); ++keyColumn)
+        {
+            rowKey[keyColumn].setValue(keyBindings[keyColumn]->converter(row[keyBindings[keyColumn]->columnIndex]));
+        }
+
+        auto waitingModels = modelsByKey.find(makeLookupKeyString(rowKey));
+        if (waitingModels == modelsByKey.end())
+        {
+            continue;
+        }
+
+        for (auto modelIndex: waitingModels->second)
+        {
+            modelStatus[modelIndex] = convertRowToModel(*bindingPlan, row, *models[modelIndex]);
+            if (modelStatus[modelIndex])
+            {
+                storeInModelCache(*models[modelIndex]);
+            }
+        }
+        modelsByKey.erase(waitingModels);
+    }
+
+    metrics.recordLatency(StatementPhase::Convert, StatisticsClock::now() - convertStart);
+}
+
+/*
+ * The query seeks in AsignedTo_RequiredDelivery_idx or fk_Tasks_AsignedTo_idx,
+ * InnoDB appends the primary key to secondary indexes so both are in TaskID order
+ * within their columns. The position is written out as an OR because MySQL
+ * doesn't use an index range for a row constructor comparison such as
+ * (RequiredDelivery, TaskID) > (?, ?).
+ */
+std::string DBInterface::formatTaskPage(const boost::mysql::format_options& formatOptions, std::size_t userID,
+    TaskPageOrder order, std::size_t rowLimit, const std::optional<TaskPageCursor>& position)
+{
+    boost::mysql::format_context sqlContext(formatOptions);
+    boost::mysql::format_sql_to(sqlContext, "SELECT * FROM {} WHERE `AsignedTo` = {}",
+        boost::mysql::identifier(databaseName, TaskModel().getTableName()), userID);
+
+    if (order == TaskPageOrder::RequiredDelivery)
+    {
+        if (position)
+        {
+            boost::mysql::date lastDueDate = convertChronoDateToBoostMySQLDate(position->lastDueDate);
+            boost::mysql::format_sql_to(sqlContext,
+                " AND (`RequiredDelivery` > {0} OR (`RequiredDelivery` = {0} AND `TaskID` > {1}))",
+                lastDueDate, position->lastTaskID);
+        }
+        sqlContext.append_raw(" ORDER BY `RequiredDelivery`, `TaskID`");
+    }
+    else
+    {
+        if (position)
+        {
+            boost::mysql::format_sql_to(sqlContext, " AND `TaskID` > {}", position->lastTaskID);
+        }
+        sqlContext.append_raw(" ORDER BY `TaskID`");
+    }
+    boost::mysql::format_sql_to(sqlContext, " LIMIT {}", rowLimit);
+
+    return std::move(sqlContext).get().value();
+}
+
+std::string DBInterface::formatTasksChangedSince(const boost::mysql::format_options& formatOptions, std::size_t userID,
+    ChangeStamp windowStart)
+{
+    return boost::mysql::format_sql(formatOptions,
+        "SELECT * FROM {} WHERE `AsignedTo` = {} AND `LastModified` >= {} ORDER BY `LastModified`, `TaskID`",
+        boost::mysql::identifier(databaseName, TaskModel().getTableName()), userID,
+        convertDataValueToField(windowStart));
+}
+
+/*
+ * Each level of the CTE joins on ParentTask_idx. Path lists the TaskIDs from the
+ * root down, a child that is already on the path closes a ParentTask cycle and
+ * isn't followed. A TaskID has at most 10 digits and is followed by a comma.
+ */
+std::string DBInterface::formatTaskSubtree(const boost::mysql::format_options& formatOptions, std::size_t rootTaskID,
+    std::size_t maxDepth)
+{
+    return boost::mysql::format_sql(formatOptions,
+        "WITH RECURSIVE `Subtree` (`TaskID`, `Depth`, `Path`) AS ("
+            "SELECT `TaskID`, 0, CAST(`TaskID` AS CHAR({3})) FROM {0} WHERE `TaskID` = {1} "
+            "UNION ALL "
+            "SELECT `Child`.`TaskID`, `Subtree`.`Depth` + 1, CONCAT(`Subtree`.`Path`, ',', `Child`.`TaskID`) "
+            "FROM {0} AS `Child` JOIN `Subtree` ON `Child`.`ParentTask` = `Subtree`.`TaskID` "
+            "WHERE `Subtree`.`Depth` < {2} AND NOT FIND_IN_SET(`Child`.`TaskID`, `Subtree`.`Path`)) "
+        "SELECT `Task`.* FROM {0} AS `Task` JOIN `Subtree` ON `Task`.`TaskID` = `Subtree`.`TaskID` "
+        "ORDER BY `Subtree`.`Depth`, `Task`.`TaskID`",
+        boost::mysql::identifier(databaseName, TaskModel().getTableName()), rootTaskID, maxDepth,
+        (maxDepth + 1) * 11);
+}
+
+/*
+ * The statement is formatted once the connection, and with it the format options,
+ * is known. The connection is returned before the rows are converted.
+ */
+boost::asio::awaitable<TaskList> DBInterface::selectTasks(QueryFormatter formatQuery)
+{
+    StatementMetrics& metrics = statementStatistics.getMetrics(StatementKind::Select, TaskModel().getTableName());
+    boost::mysql::pooled_connection conn = co_await checkOutConnection(metrics);
+    conn->set_meta_mode(boost::mysql::metadata_mode::full);
+
+    std::string sqlStatement = formatQuery(conn->format_opts().value());
+    if (verboseOutput)
+    {
+        std::clog << "Executing " << sqlStatement << std::endl;
+    }
+
+    boost::mysql::results result;
+    try
+    {
+        co_await executeTextStatement(conn, metrics, sqlStatement, result);
+    }
+    catch(const std::exception&)
+    {
+        returnConnectionAfterError(conn);
+        throw;
+    }
+    returnConnection(conn);
+
+    StatisticsClock::time_point convertStart = StatisticsClock::now();
+    TaskModel taskPrototype;
+    std::expected<ResultBindingPlan, std::string> bindingPlan = createBindingPlan(result.meta(), taskPrototype);
+    if (!bindingPlan)
+    {
+        throw std::runtime_error(bindingPlan.error());
+    }
+
+    TaskList tasks;
+    tasks.reserve(result.rows().size());
+    for (boost::mysql::row_view row: result.rows())
+    {
+        TaskModel_shp task = std::make_shared<TaskModel>();
+        DBStatus converted = convertRowToModel(*bindingPlan, row, *task);
+        if (!converted)
+        {
+            throw std::runtime_error(converted.error());
+        }
+        tasks.push_back(task);
+    }
+    metrics.recordLatency(StatementPhase::Convert, StatisticsClock::now() - convertStart);
+
+    co_return tasks;
+}
+
+std::string DBInterface::getTableNameFrom(ModelBase &model)
+{
+    std::string tableName;
+    tableName = model.getTableName();
+    return tableName;
+}
+
+std::vector<std::string> DBInterface::getSlotColumnNames(const ModelBase& model, const std::vector<std::size_t>& slots)
+{
+    std::vector<std::string> columnNames;
+    columnNames.reserve(slots.size());
+
+    for (std::size_t slot: slots)
+    {
+        columnNames.push_back(model.getFieldBySlot(slot).getColumnName());
+    }
+
+    return columnNames;
+}
+
+std::string DBInterface::makeStatementCacheKey(PreparedStatementKind kind, const std::string& tableName,
+    const std::vector<std::string>& columnNames, const std::vector<std::string>& selectColumnNames)
+{
+    std::string cacheKey;
+    switch (kind)
+    {
+        case PreparedStatementKind::Insert :
+            cacheKey = "I:";
+            break;
+        case PreparedStatementKind::Update :
+            cacheKey = "U:";
+            break;
+        case PreparedStatementKind::Select :
+            cacheKey = "S:";
+            break;
+    }
+    cacheKey += tableName;
+
+    for (const auto& columnName: columnNames)
+    {
+        cacheKey += ',';
+        cacheKey += columnName;
+    }
+
+    if (kind == PreparedStatementKind::Select && !selectColumnNames.empty())
+    {
+        cacheKey += ':';
+        for (const auto& columnName: selectColumnNames)
+        {
+            cacheKey += columnName;
+            cacheKey += ',';
+        }
+    }
+
+    return cacheKey;
+}
+
+std::string DBInterface::formatPreparedStatement(PreparedStatementKind kind, const std::string& tableName,
+    const std::vector<std::string>& columnNames, const std::vector<std::string>& selectColumnNames)
+{
+    switch (kind)
+    {
+        case PreparedStatementKind::Insert :
+            return formatInsert(tableName, columnNames);
+        case PreparedStatementKind::Update :
+            return formatUpdate(tableName, columnNames);
+        default :
+            return formatSelect(tableName, columnNames, selectColumnNames);
+    }
+}
+
+std::string DBInterface::formatInsert(const std::string& tableName, const std::vector<std::string>& columnNames)
+{
+    std::string argFmt;
+    std::string valueFmt;
+
+    bool noComma = true;
+    for (const auto& columnName: columnNames)
+    {
+        argFmt.append((noComma) ? std::format("{}", columnName) : std::format(", {}", columnName));
+        valueFmt.append((noComma) ? "?" : ", ?");
+        noComma = false;
+    }
+
+    std::string insertFMT(std::format("INSERT INTO {}.{} ({}) VALUES ({})", databaseName,
+        tableName, argFmt, valueFmt));
+
+    return insertFMT;
+}
+
+/*
+ * The last column is the primary key that selects the row, all other columns are
+ * set.
+ */
+std::string DBInterface::formatUpdate(const std::string& tableName, const std::vector<std::string>& columnNames)
+{
+    std::string updateFMT(std::format("UPDATE {}.{} SET ", databaseName, tableName));
+
+    bool noComma = true;
+    for (std::size_t columnIndex = 0; columnIndex + 1 < columnNames.size(); ++columnIndex)
+    {
+        updateFMT.append((noComma)? std::format("{} = ?", columnNames[columnIndex]) :
+            std::format(", {} = ?", columnNames[columnIndex]));
+        noComma = false;
+    }
+    updateFMT.append(std::format(" WHERE {} = ?", columnNames.back()));
+
+    return updateFMT;
+}
+
+std::string DBInterface::formatSelect(const std::string& tableName, const std::vector<std::string>& whereColumnNames,
+    const std::vector<std::string>& selectColumnNames)
+{
+    std::string selectList;
+    for (const auto& columnName: selectColumnNames)
+    {
+        selectList.append((selectList.empty())? columnName : std::format(", {}", columnName));
+    }
+
+    std::string selectFMT(std::format("SELECT {} FROM {}.{}", (selectList.empty())? "*" : selectList, databaseName,
+        tableName));
+    if (!whereColumnNames.empty())
+    {
+        selectFMT.append(" WHERE ");
+    }
+
+    bool noComma = true;
+    for (const auto& columnName: whereColumnNames)
+    {
+        selectFMT.append((noComma)? std::format("{} = ?", columnName) : std::format(" AND {} = ?", columnName));
+        noComma = false;
+    }
+
+    return selectFMT;
+}
+
+/*
+ * Statement parameters are bound with their native types, there is no conversion
+ * to and from strings.
+ */
+struct DataValueToFieldVisitor
+{
+    boost::mysql::field operator()(std::monostate) const { return boost::mysql::field(); }
+    boost::mysql::field operator()(std::size_t arg) const { return boost::mysql::field(static_cast<std::uint64_t>(arg)); }
+    boost::mysql::field operator()(unsigned int arg) const { return boost::mysql::field(static_cast<std::uint64_t>(arg)); }
+    boost::mysql::field operator()(int arg) const { return boost::mysql::field(static_cast<std::int64_t>(arg)); }
+    boost::mysql::field operator()(bool arg) const { return boost::mysql::field(static_cast<std::int64_t>(arg)); }
+    boost::mysql::field operator()(double arg) const { return boost::mysql::field(arg); }
+    boost::mysql::field operator()(const std::string& arg) const { return boost::mysql::field(arg); }
+
+    boost::mysql::field operator()(std::chrono::year_month_day arg) const
+    {
+        std::chrono::sys_days days = arg;
+        return boost::mysql::field(boost::mysql::date(days));
+    }
+
+    boost::mysql::field operator()(std::chrono::time_point<std::chrono::system_clock> arg) const
+    {
+        return boost::mysql::field(boost::mysql::datetime(
+            std::chrono::time_point_cast<boost::mysql::datetime::time_point::duration>(arg)));
+    }
+};
+
+boost::mysql::field DBInterface::convertDataValueToField(const DataValueType& dataValue)
+{
+    return std::visit(DataValueToFieldVisitor{}, dataValue);
+}
+
+/*
+ * A string is copied into the parameter once, straight from the field.
+ */
+boost::mysql::field DBInterface::convertDataFieldToField(const PTS_DataField& dataField)
+{
+    if (dataField.getValueCell().holds<std::string>())
+    {
+        return boost::mysql::field(std::string(dataField.getValueCell().getStringView()));
+    }
+
+    return convertDataValueToField(dataField.getValue());
+}
+
+/*
+ * MySQL counts only the rows an UPDATE changed, a row written with the values it
+ * already has isn't affected. The info string has the count of rows matched.
+ */
+bool DBInterface::updateMatchedRow(const boost::mysql::results& result)
+{
+    if (result.affected_rows() != 0)
+    {
+        return true;
+    }
+
+    constexpr std::string_view matchedLabel("Rows matched: ");
+    std::string_view info = result.info();
+    std::size_t labelStart = info.find(matchedLabel);
+    if (labelStart == std::string_view::npos)
+    {
+        return false;
+    }
+
+    std::string_view matchedCount = info.substr(labelStart + matchedLabel.size());
+    std::size_t rowsMatched = 0;
+    std::from_chars(matchedCount.data(), matchedCount.data() + matchedCount.size(), rowsMatched);
+
+    return rowsMatched != 0;
+}
+
+/*
+ * A cancelled check out reports no_connection_available when the pool failed to
+ * connect while the check out was waiting.
+ */
+bool DBInterface::isTimeout(const boost::system::error_code& errorCode)
+{
+    return errorCode == boost::asio::error::operation_aborted ||
+        errorCode == boost::mysql::client_errc::no_connection_available;
+}
+
+bool DBInterface::isServerError(const boost::system::error_code& errorCode)
+{
+    return errorCode.category() == boost::mysql::get_common_server_category() ||
+        errorCode.category() == boost::mysql::get_mysql_server_category() ||
+        errorCode.category() == boost::mysql::get_mariadb_server_category();
+}
+
+/*
+ * The connection is dropped here so that no error path can give it back.
+ */
+void DBInterface::throwStatementTimeout(boost::mysql::pooled_connection& conn)
+{
+    ++statementTimeouts;
+    dropConnection(conn);
+
+    throw DBTimeoutError(std::format("The statement was cancelled at its deadline, the query timeout is {} ms.",
+        queryTimeout.count()));
+}
+
+boost::mysql::pool_params DBInterface::createPoolParameters(ProgramOptions& programOptions)
+{
+    boost::mysql::pool_params poolParameters;
+
+    poolParameters.server_address.emplace_host_and_port(programOptions.mySqlUrl, programOptions.mySqlPort);
+    poolParameters.username = programOptions.mySqlUser;
+    poolParameters.password = programOptions.mySqlPassword;
+    poolParameters.database = programOptions.mySqlDBName;
+    poolParameters.initial_size = programOptions.connectionPoolMinSize;
+    poolParameters.max_size = programOptions.connectionPoolMaxSize;
+    poolParameters.ping_interval = std::chrono::seconds(programOptions.connectionHealthCheckSeconds);
+    poolParameters.thread_safe = programOptions.dbThreadCount > 1;
+
+    return poolParameters;
+}
+
+bool DBInterface::isTransactionActive()
+{
+    std::lock_guard<std::mutex> guard(transactionLock);
+    return transactionActive;
+}
+
+/*
+ * The transaction is over whatever the outcome of sqlStatement, its connection
+ * goes back to the pool.
+ */
+boost::asio::awaitable<DBStatus> DBInterface::endTransaction(std::string sqlStatement)
+{
+    std::optional<boost::mysql::pooled_connection> conn;
+    std::vector<std::string> rowKeys;
+    bool connectionLost = false;
+
+    {
+        std::lock_guard<std::mutex> guard(transactionLock);
+        if (!transactionActive)
+        {
+            co_return std::unexpected(std::string("No transaction is open.\n"));
+        }
+        if (!transactionConnection.has_value() && !transactionLost)
+        {
+            co_return std::unexpected(std::string("A statement of the transaction is still running.\n"));
+        }
+        conn = std::move(transactionConnection);
+        transactionConnection.reset();
+        transactionConnectionID = nullptr;
+        transactionActive = false;
+        connectionLost = transactionLost;
+        transactionLost = false;
+        rowKeys.swap(transactionRowKeys);
+    }
+
+    DBStatus status;
+    if (connectionLost)
+    {
+        if (sqlStatement != "ROLLBACK")
+        {
+            status = std::unexpected(std::string("The transaction was rolled back by the server when its connection "
+                "was lost.\n"));
+        }
+    }
+    else
+    {
+        try
+        {
+            if (verboseOutput)
+            {
+                std::clog << "Executing " << sqlStatement << std::endl;
+            }
+
+            boost::mysql::results result;
+            co_await executeTextStatement(*conn, statementStatistics.getMetrics(StatementKind::Transaction, ""),
+                sqlStatement, result);
+            returnConnection(*conn);
+        }
+        catch(const std::exception& e)
+        {
+            std::string eMsg("In DBInterface::endTransaction() ");
+            eMsg += sqlStatement + " " + e.what();
+            status = std::unexpected(eMsg);
+        }
+    }
+
+    // Only a commit makes the cached values of the rows written by the transaction true.
+    if (!status || sqlStatement != "COMMIT")
+    {
+        for (const auto& rowKey: rowKeys)
+        {
+            modelCache.eraseRow(rowKey);
+        }
+    }
+
+    co_return status;
+}
+
+/*
+ * A row cached while a transaction is open may hold values the transaction never
+ * commits, its row key is kept until the transaction ends.
+ */
+void DBInterface::storeInModelCache(const ModelBase& model)
+{
+    rememberTransactionRow(model);
+    modelCache.store(model);
+}
+
+/*
+ * The database sets the generated fields of a row that was written, the model
+ * doesn't hold them. The cached copy of the row is dropped and the next read goes
+ * to the server.
+ */
+void DBInterface::refreshModelCache(const ModelBase& model)
+{
+    if (modelCache.isEnabled() && model.isInDataBase())
+    {
+        modelCache.eraseRow(modelCache.getRowKey(model));
+    }
+}
+
+void DBInterface::rememberTransactionRow(const ModelBase& model)
+{
+    if (!modelCache.isEnabled() || !model.isInDataBase())
+    {
+        return;
+    }
+
+    std::lock_guard<std::mutex> guard(transactionLock);
+    if (transactionActive)
+    {
+        transactionRowKeys.push_back(modelCache.getRowKey(model));
+    }
+}
+
+/*
+ * The first request of a group starts the window timer, a full group is committed
+ * immediately. groupCommitNumber tells the timer whether its group is still the
+ * one waiting in groupCommitQueue.
+ */
+boost::asio::awaitable<DBStatus> DBInterface::insertWithGroupCommit(ModelBase& model, std::string tableName,
+    std::vector<std::string> columnNames, std::vector<boost::mysql::field> parameters)
+{
+    GroupCommitRequestShp request = std::make_shared<GroupCommitRequest>(ioContext.get_executor(),
+        std::move(tableName), std::move(columnNames), std::move(parameters));
+    std::vector<GroupCommitRequestShp> fullGroup;
+
+    {
+        std::lock_guard<std::mutex> guard(groupCommitLock);
+        if (groupCommitQueue.empty())
+        {
+            ++groupCommitNumber;
+            boost::asio::co_spawn(getExecutor(), commitGroupAfterWindow(groupCommitNumber), boost::asio::detached);
+        }
+        groupCommitQueue.push_back(request);
+        if (groupCommitQueue.size() >= groupCommitMaxSize)
+        {
+            fullGroup.swap(groupCommitQueue);
+        }
+    }
+
+    if (!fullGroup.empty())
+    {
+        boost::asio::co_spawn(getExecutor(), commitGroup(std::move(fullGroup)), boost::asio::detached);
+    }
+
+    try
+    {
+        co_await request->completion.async_receive(boost::asio::use_awaitable);
+    }
+    catch (const boost::system::system_error&)
+    {
+        // Only the wait is cancelled, the group may still commit the row.
+        co_return std::unexpected(std::string("The insert missed its deadline waiting for the group commit, "
+            "the row may still be committed.\n"));
+    }
+
+    if (!request->status)
+    {
+        co_return request->status;
+    }
+
+    model.setPrimaryKey(request->insertID);
+    model.clearDirtyBits();
+    refreshModelCache(model);
+
+    co_return DBStatus{};
+}
+
+boost::asio::awaitable<void> DBInterface::commitGroupAfterWindow(std::size_t groupNumber)
+{
+    boost::asio::steady_timer windowTimer(ioContext, groupCommitWindow);
+    co_await windowTimer.async_wait(boost::asio::use_awaitable);
+
+    std::vector<GroupCommitRequestShp> group;
+    {
+        std::lock_guard<std::mutex> guard(groupCommitLock);
+        if (groupNumber == groupCommitNumber)
+        {
+            group.swap(groupCommitQueue);
+        }
+    }
+
+    if (!group.empty())
+    {
+        co_await commitGroup(std::move(group));
+    }
+}
+
+/*
+ * A row that fails only rolls back its own statement, the other rows of the group
+ * are still committed. A deadlock rolls back the whole transaction, so it fails
+ * the group like any other error that prevents the commit. Keys are only given
+ * to the models once the commit succeeded.
+ */
+boost::asio::awaitable<void> DBInterface::commitGroup(std::vector<GroupCommitRequestShp> group)
+{
+    std::string eMsg("In DBInterface::async_insert() ");
+    bool committed = false;
+
+    try
+    {
+        StatementMetrics& metrics = statementStatistics.getMetrics(StatementKind::Transaction, "");
+        boost::mysql::pooled_connection conn = co_await checkOutPooledConnection(metrics);
+        boost::mysql::results result;
+
+        if (verboseOutput)
+        {
+            std::clog << "Executing group commit of " << group.size() << " inserts" << std::endl;
+        }
+
+        co_await executeTextStatement(conn, metrics, "START TRANSACTION", result);
+        for (auto& request: group)
+        {
+            try
+            {
+                boost::mysql::results rowResult = co_await executePreparedStatementOnConnection(conn,
+                    PreparedStatementKind::Insert, request->tableName, request->columnNames, request->parameters);
+                request->insertID = rowResult.last_insert_id();
+            }
+            catch(const boost::mysql::error_with_diagnostics& e)
+            {
+                if (e.code() == boost::mysql::common_server_errc::er_lock_deadlock || !isServerError(e.code()))
+                {
+                    throw;
+                }
+                request->status = std::unexpected(eMsg + e.what());
+            }
+        }
+        co_await executeTextStatement(conn, metrics, "COMMIT", result);
+        committed = true;
+
+        returnConnection(conn);
+    }
+    catch(const std::exception& e)
+    {
+        eMsg += e.what();
+    }
+
+    for (auto& request: group)
+    {
+        if (!committed && request->status)
+        {
+            request->status = std::unexpected(eMsg);
+        }
+        request->completion.try_send(boost::system::error_code{});
+    }
+}
+
+/*
+ * The pool only hands out connections that are already connected and healthy. A
+ * session the pool has handed out before is a warm connection and counts as a
+ * hit. The pool reuses the connection object when it reconnects, so a session is
+ * the connection object's entry in preparedStatements together with the server's
+ * connection id. There is one entry per connection object, a reconnect replaces
+ * the id instead of adding a session.
+ */
+boost::asio::awaitable<boost::mysql::pooled_connection> DBInterface::checkOutPooledConnection(StatementMetrics& metrics)
+{
+    StatisticsClock::time_point connectStart = StatisticsClock::now();
+    boost::mysql::pooled_connection connection;
+    try
+    {
+        connection = co_await connectionPool->async_get_connection(boost::asio::cancel_after(connectTimeout));
+    }
+    catch (const boost::system::system_error& e)
+    {
+        if (!isTimeout(e.code()))
+        {
+            throw;
+        }
+        ++connectTimeouts;
+        throw DBTimeoutError(std::format("No database connection was available before the deadline, "
+            "the connect timeout is {} ms.", connectTimeout.count()));
+    }
+    metrics.recordLatency(StatementPhase::Connect, StatisticsClock::now() - connectStart);
+
+    if (claimPreparedStatements(connection))
+    {
+        ++poolHits;
+    }
+    else
+    {
+        ++poolMisses;
+    }
+
+    co_return connection;
+}
+
+/*
+ * Statements run on the connection of an open transaction unless they bypass it,
+ * otherwise on a pooled connection. Only waiting for the pool is recorded as
+ * connect time.
+ */
+boost::asio::awaitable<boost::mysql::pooled_connection> DBInterface::checkOutConnection(StatementMetrics& metrics,
+    TransactionUse transactionUse)
+{
+    if (transactionUse == TransactionUse::Join)
+    {
+        std::lock_guard<std::mutex> guard(transactionLock);
+        if (transactionActive)
+        {
+            if (transactionLost)
+            {
+                throw std::runtime_error("The transaction was rolled back when its connection was lost, "
+                    "call rollback() to end it.");
+            }
+            if (!transactionConnection.has_value())
+            {
+                throw std::logic_error("The connection of the open transaction is in use by another statement.");
+            }
+            boost::mysql::pooled_connection connection = std::move(*transactionConnection);
+            transactionConnection.reset();
+            co_return connection;
+        }
+    }
+
+    co_return co_await checkOutPooledConnection(metrics);
+}
+
+/*
+ * Letting the pooled_connection go out of scope returns it to the pool and resets
+ * the session, which also deallocates the session's prepared statements. Skip the
+ * reset when it isn't wanted, none of the statements generated here change the
+ * session state.
+ */
+void DBInterface::returnConnection(boost::mysql::pooled_connection& connection)
+{
+    if (!connection.valid())
+    {
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> guard(transactionLock);
+        if (transactionActive && &connection.get() == transactionConnectionID)
+        {
+            transactionConnection.emplace(std::move(connection));
+            return;
+        }
+    }
+
+    if (resetIdleConnections)
+    {
+        forgetPreparedStatements(connection);
+    }
+    else
+    {
+        {
+            std::lock_guard<std::mutex> guard(preparedStatementsLock);
+            preparedStatements[&connection.get()].returnedWithoutReset = true;
+        }
+        connection.return_without_reset();
+    }
+}
+
+/*
+ * The pool resets the connection when it goes out of scope. If it belongs to the
+ * open transaction the transaction is lost, the reset rolls it back.
+ */
+void DBInterface::dropConnection(boost::mysql::pooled_connection& connection)
+{
+    if (!connection.valid())
+    {
+        return;
+    }
+
+    forgetPreparedStatements(connection);
+    {
+        std::lock_guard<std::mutex> guard(transactionLock);
+        if (transactionActive && &connection.get() == transactionConnectionID)
+        {
+            transactionLost = true;
+        }
+    }
+    boost::mysql::pooled_connection droppedConnection(std::move(connection));
+}
+
+/*
+ * After an error the connection of the open transaction goes back to the
+ * transaction, any other connection goes back to the pool with a reset since its
+ * state is not known.
+ */
+void DBInterface::returnConnectionAfterError(boost::mysql::pooled_connection& connection)
+{
+    if (!connection.valid())
+    {
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> guard(transactionLock);
+        if (transactionActive && &connection.get() == transactionConnectionID)
+        {
+            transactionConnection.emplace(std::move(connection));
+            return;
+        }
+    }
+
+    forgetPreparedStatements(connection);
+    boost::mysql::pooled_connection resetConnection(std::move(connection));
+}
+
+std::uint32_t DBInterface::getSessionID(const boost::mysql::pooled_connection& connection)
+{
+    auto sessionID = connection.get().connection_id();
+    return sessionID? *sessionID : 0;
+}
+
+boost::asio::awaitable<boost::mysql::statement> DBInterface::getPreparedStatement(boost::mysql::pooled_connection& conn,
+    PreparedStatementKind kind, const std::string& tableName, const std::vector<std::string>& columnNames,
+    const std::vector<std::string>& selectColumnNames)
+{
+    std::string cacheKey = makeStatementCacheKey(kind, tableName, columnNames, selectColumnNames);
+
+    {
+        std::lock_guard<std::mutex> guard(preparedStatementsLock);
+        SessionStatements& sessionStatements = preparedStatements[&conn.get()];
+        if (sessionStatements.sessionID == getSessionID(conn))
+        {
+            auto cachedStatement = sessionStatements.statements.find(cacheKey);
+            if (cachedStatement != sessionStatements.statements.end())
+            {
+                co_return cachedStatement->second;
+            }
+        }
+    }
+
+    std::string sqlStatement = formatPreparedStatement(kind, tableName, columnNames, selectColumnNames);
+    if (verboseOutput)
+    {
+        std::clog << "Preparing " << sqlStatement << std::endl;
+    }
+
+    boost::mysql::statement newStatement;
+    try
+    {
+        newStatement = co_await conn->async_prepare_statement(sqlStatement, boost::asio::cancel_after(queryTimeout));
+    }
+    catch (const boost::system::system_error& e)
+    {
+        if (isTimeout(e.code()))
+        {
+            throwStatementTimeout(conn);
+        }
+        throw;
+    }
+
+    {
+        std::lock_guard<std::mutex> guard(preparedStatementsLock);
+        SessionStatements& sessionStatements = preparedStatements[&conn.get()];
+        std::uint32_t sessionID = getSessionID(conn);
+        if (sessionStatements.sessionID != sessionID)
+        {
+            sessionStatements.statements.clear();
+            sessionStatements.sessionID = sessionID;
+        }
+        sessionStatements.statements.insert_or_assign(cacheKey, newStatement);
+    }
+
+    co_return newStatement;
+}
+
+bool DBInterface::claimPreparedStatements(const boost::mysql::pooled_connection& conn)
+{
+    std::lock_guard<std::mutex> guard(preparedStatementsLock);
+    SessionStatements& sessionStatements = preparedStatements[&conn.get()];
+    std::uint32_t sessionID = getSessionID(conn);
+    bool warmSession = sessionStatements.sessionID == sessionID;
+    if (!warmSession || !sessionStatements.returnedWithoutReset)
+    {
+        sessionStatements.statements.clear();
+        sessionStatements.sessionID = sessionID;
+    }
+    sessionStatements.returnedWithoutReset = false;
+
+    return warmSession;
+}
+
+void DBInterface::forgetPreparedStatements(const boost::mysql::pooled_connection& conn)
+{
+    std::lock_guard<std::mutex> guard(preparedStatementsLock);
+    preparedStatements[&conn.get()].statements.clear();
+}
+
+StatementKind DBInterface::getStatementKind(PreparedStatementKind kind)
+{
+    switch (kind)
+    {
+        case PreparedStatementKind::Insert :
+            return StatementKind::Insert;
+
+        case PreparedStatementKind::Update :
+            return StatementKind::Update;
+
+        case PreparedStatementKind::Select :
+            return StatementKind::Select;
+    }
+
+    return StatementKind::Select;
+}
+
+/*
+ * If the pool had to reconnect a connection its prepared statements are gone. The
+ * server reports an unknown statement handler, prepare the statement again and
+ * retry once.
+ */
+boost::asio::awaitable<boost::mysql::results> DBInterface::executePreparedStatementOnConnection(
+    boost::mysql::pooled_connection& conn, PreparedStatementKind kind, const std::string& tableName,
+    const std::vector<std::string>& columnNames, const std::vector<boost::mysql::field>& parameters,
+    const std::vector<std::string>& selectColumnNames)
+{
+    conn->set_meta_mode((kind == PreparedStatementKind::Select)? boost::mysql::metadata_mode::full :
+        boost::mysql::metadata_mode::minimal);
+
+    StatementMetrics& metrics = statementStatistics.getMetrics(getStatementKind(kind), tableName);
+    StatisticsClock::time_point executeStart = StatisticsClock::now();
+    boost::mysql::results result;
+    bool statementWasStale = false;
+
+    try
+    {
+        boost::mysql::statement statement = co_await getPreparedStatement(conn, kind, tableName, columnNames,
+            selectColumnNames);
+        co_await conn->async_execute(statement.bind(parameters.begin(), parameters.end()), result,
+            boost::asio::cancel_after(queryTimeout));
+    }
+    catch (const boost::mysql::error_with_diagnostics& e)
+    {
+        if (e.code() != boost::mysql::common_server_errc::er_unknown_stmt_handler)
+        {
+            metrics.recordError();
+            if (isTimeout(e.code()))
+            {
+                throwStatementTimeout(conn);
+            }
+            throw;
+        }
+        statementWasStale = true;
+    }
+
+    if (statementWasStale)
+    {
+        forgetPreparedStatements(conn);
+        try
+        {
+            boost::mysql::statement statement = co_await getPreparedStatement(conn, kind, tableName, columnNames,
+                selectColumnNames);
+            co_await conn->async_execute(statement.bind(parameters.begin(), parameters.end()), result,
+                boost::asio::cancel_after(queryTimeout));
+        }
+        catch (const boost::mysql::error_with_diagnostics& e)
+        {
+            metrics.recordError();
+            if (isTimeout(e.code()))
+            {
+                throwStatementTimeout(conn);
+            }
+            throw;
+        }
+    }
+
+    StatisticsClock::duration executeTime = StatisticsClock::now() - executeStart;
+    metrics.recordLatency(StatementPhase::Execute, executeTime);
+    metrics.recordStatement(result.rows().size(), countParameterBytes(parameters) + countRowBytes(result.rows()));
+    if (slowQueryLog.isSlow(executeTime))
+    {
+        slowQueryLog.record(formatPreparedStatement(kind, tableName, columnNames, selectColumnNames), executeTime,
+            result.rows().size());
+    }
+
+    co_return result;
+}
+
+/*
+ * Every statement a pipeline refers to is prepared before the pipeline is sent,
+ * only statements missing from the cache cost a round trip. The PIPELINE metrics
+ * count round trips, each stage is counted under its own kind and table.
+ * A stage whose statement was deallocated by the server never ran. Those stages
+ * alone are prepared again and sent once more as a second pipeline, so they run
+ * after the rest of the chunk.
+ */
+boost::asio::awaitable<bool> DBInterface::executePipelineChunk(boost::mysql::pooled_connection& conn,
+    const std::vector<PipelinedStatement>& pipelinedStatements, std::size_t chunkStart, std::size_t chunkEnd,
+    std::vector<PipelineStage>& stages)
+{
+    std::vector<boost::mysql::stage_response> responses;
+    boost::system::error_code pipelineError;
+    StatementMetrics& pipelineMetrics = statementStatistics.getMetrics(StatementKind::Pipeline, "*");
+    StatisticsClock::time_point executeStart = StatisticsClock::now();
+
+    std::vector<std::size_t> pendingStatements;
+    for (std::size_t statementIndex = chunkStart; statementIndex < chunkEnd; ++statementIndex)
+    {
+        pendingStatements.push_back(statementIndex);
+    }
+
+    for (int attempt = 0; attempt < 2 && !pendingStatements.empty(); ++attempt)
+    {
+        boost::mysql::pipeline_request request;
+        std::vector<std::vector<boost::mysql::field_view>> parameterViews;
+        parameterViews.reserve(pendingStatements.size());
+
+        for (std::size_t statementIndex: pendingStatements)
+        {
+            const PipelinedStatement& statement = pipelinedStatements[statementIndex];
+            boost::mysql::statement prepared = co_await getPreparedStatement(conn, statement.kind,
+                statement.tableName, statement.columnNames);
+            parameterViews.emplace_back(statement.parameters.begin(), statement.parameters.end());
+            request.add_execute_range(prepared, parameterViews.back());
+        }
+
+        if (verboseOutput)
+        {
+            std::clog << "Executing pipeline of " << pendingStatements.size() << " statements" << std::endl;
+        }
+
+        std::vector<boost::mysql::stage_response> attemptResponses;
+        boost::system::error_code attemptError;
+        co_await conn->async_run_pipeline(request, attemptResponses,
+            boost::asio::cancel_after(queryTimeout, boost::asio::redirect_error(boost::asio::use_awaitable, attemptError)));
+
+        if (attempt == 0)
+        {
+            responses = std::move(attemptResponses);
+            pipelineError = attemptError;
+        }
+        else
+        {
+            for (std::size_t retryIndex = 0; retryIndex < attemptResponses.size(); ++retryIndex)
+            {
+                responses[pendingStatements[retryIndex] - chunkStart] = std::move(attemptResponses[retryIndex]);
+            }
+            pipelineError = attemptError;
+            for (const auto& response: responses)
+            {
+                if (!pipelineError && response.error())
+                {
+                    pipelineError = response.error();
+                }
+            }
+        }
+
+        if (!pipelineError || isTimeout(pipelineError))
+        {
+            break;
+        }
 
-    if (model.isInDataBase())
-    {
-        appendErrorMessage("The model object is already in the database.\n");
-        return false;
+        std::vector<std::size_t> staleStatements;
+        for (std::size_t statementIndex: pendingStatements)
+        {
+            std::size_t responseIndex = statementIndex - chunkStart;
+            if (responseIndex < responses.size() &&
+                responses[responseIndex].error() == boost::mysql::common_server_errc::er_unknown_stmt_handler)
+            {
+                staleStatements.push_back(statementIndex);
+            }
+        }
+        if (!staleStatements.empty())
+        {
+            forgetPreparedStatements(conn);
+        }
+        pendingStatements = std::move(staleStatements);
     }
 
-    if (!model.allRequiredFieldsHaveData())
+    StatisticsClock::duration executeTime = StatisticsClock::now() - executeStart;
+    pipelineMetrics.recordLatency(StatementPhase::Execute, executeTime);
+    if (slowQueryLog.isSlow(executeTime))
     {
-        appendErrorMessage(model.reportMissingRequiredFields());
-        return false;
+        const PipelinedStatement& firstStatement = pipelinedStatements[chunkStart];
+        slowQueryLog.record(std::format("PIPELINE of {} statements starting with {}", chunkEnd - chunkStart,
+            formatPreparedStatement(firstStatement.kind, firstStatement.tableName, firstStatement.columnNames)),
+            executeTime, responses.size());
     }
-
-    try
+    if (pipelineError)
     {
-        boost::mysql::results results = runAnyMySQLstatementsAsynchronously(formatInsert(model));
-        model.setPrimaryKey(results.last_insert_id());
-        model.onInsertionClearDirtyBits();
-
-        return true;
+        pipelineMetrics.recordError();
     }
-    catch(const std::exception& e)
+    else
     {
-        std::string eMsg("In DBInterface::insertIntoDataBase(ModelBase &model) ");
-        eMsg += e.what();
-        appendErrorMessage(eMsg);
-        return false;
+        pipelineMetrics.recordStatement(0, 0);
+    }
+
+    for (std::size_t statementIndex = chunkStart; statementIndex < chunkEnd; ++statementIndex)
+    {
+        const PipelinedStatement& statement = pipelinedStatements[statementIndex];
+        PipelineStage& stage = stages[statement.stageIndex];
+        std::size_t responseIndex = statementIndex - chunkStart;
+        StatementMetrics& stageMetrics = statementStatistics.getMetrics(getStatementKind(statement.kind),
+            statement.tableName);
+
+        if (responseIndex >= responses.size() || responses[responseIndex].error())
+        {
+            stageMetrics.recordError();
+            std::string eMsg("In DBInterface::async_executePipeline() ");
+            if (responseIndex < responses.size())
+            {
+                eMsg += responses[responseIndex].error().message() + " ";
+                eMsg += responses[responseIndex].diag().server_message();
+            }
+            else
+            {
+                eMsg += pipelineError.message();
+            }
+            stage.status = std::unexpected(eMsg);
+            continue;
+        }
+
+        const boost::mysql::results& result = responses[responseIndex].as_results();
+        stageMetrics.recordStatement(result.rows().size(),
+            countParameterBytes(statement.parameters) + countRowBytes(result.rows()));
+        switch (stage.kind)
+        {
+            case PipelineStage::Kind::Insert :
+                stage.model->setPrimaryKey(result.last_insert_id());
+                stage.model->clearDirtyBits();
+                break;
+
+            case PipelineStage::Kind::Update :
+                if (!updateMatchedRow(result))
+                {
+                    stage.status = reportNoRowUpdated(*stage.model);
+                    break;
+                }
+                stage.model->clearDirtyBits();
+                break;
+
+            case PipelineStage::Kind::Select :
+            {
+                StatisticsClock::time_point convertStart = StatisticsClock::now();
+                stage.status = convertFirstRowToModel(result, *stage.model);
+                stageMetrics.recordLatency(StatementPhase::Convert, StatisticsClock::now() - convertStart);
+                break;
+            }
+        }
+
+        if (stage.status && stage.kind == PipelineStage::Kind::Select)
+        {
+            storeInModelCache(*stage.model);
+        }
+        else if (stage.status)
+        {
+            refreshModelCache(*stage.model);
+        }
     }
+
+    co_return !isTimeout(pipelineError);
 }
 
-bool DBInterface::getUniqueModelFromDB(ModelShp model, std::vector<WhereArg> whereArgs)
+boost::asio::awaitable<void> DBInterface::startPreparedExecution(boost::mysql::pooled_connection& conn,
+    PreparedStatementKind kind, const std::string& tableName, const std::vector<std::string>& columnNames,
+    const std::vector<boost::mysql::field>& parameters, boost::mysql::execution_state& executionState,
+    const std::vector<std::string>& selectColumnNames)
 {
-    clearPreviousErrors();
+    bool statementWasStale = false;
 
-    if (!model)
+    try
     {
-        std::invalid_argument missingModelPtr("NULL model pointer in DBInterface::getUniqueModelFromDB()!");
-        throw missingModelPtr;
+        boost::mysql::statement statement = co_await getPreparedStatement(conn, kind, tableName, columnNames,
+            selectColumnNames);
+        co_await conn->async_start_execution(statement.bind(parameters.begin(), parameters.end()), executionState,
+            boost::asio::cancel_after(queryTimeout));
     }
-
-    try
+    catch (const boost::mysql::error_with_diagnostics& e)
     {
-        std::string sqlStatement = formatSelect(getTableNameFrom(*model), whereArgs);
-        if (executeSimpleQueryProcessResults(sqlStatement, model))
+        if (isTimeout(e.code()))
+        {
+            throwStatementTimeout(conn);
+        }
+        if (e.code() != boost::mysql::common_server_errc::er_unknown_stmt_handler)
         {
-            return true;
+            throw;
         }
+        statementWasStale = true;
     }
-    catch(const std::exception& e)
+
+    if (statementWasStale)
     {
-        std::string eMsg("In DBInterface::getUniqueModelFromDB ");
-        eMsg += e.what();
-        appendErrorMessage(eMsg);
-        return false;
+        forgetPreparedStatements(conn);
+        try
+        {
+            boost::mysql::statement statement = co_await getPreparedStatement(conn, kind, tableName, columnNames,
+                selectColumnNames);
+            co_await conn->async_start_execution(statement.bind(parameters.begin(), parameters.end()), executionState,
+                boost::asio::cancel_after(queryTimeout));
+        }
+        catch (const boost::mysql::error_with_diagnostics& e)
+        {
+            if (isTimeout(e.code()))
+            {
+                throwStatementTimeout(conn);
+            }
+            throw;
+        }
     }
-    
-    return false;
 }
 
 /*
- * Protected or private methods.
+ * Rows are read with read_some_rows() as they arrive and converted into models
+ * that are handed to onBatch streamBatchSize models at a time. Only one batch of
+ * models and one network buffer of rows are in memory at any time.
  */
-std::string DBInterface::getTableNameFrom(ModelBase &model)
+boost::asio::awaitable<DBStatus> DBInterface::streamModelsFromDB(std::string tableName,
+    std::vector<std::string> whereColumnNames, std::vector<boost::mysql::field> parameters, ModelFactory modelFactory,
+    ModelBatchCallback onBatch, std::vector<std::string> selectColumnNames)
 {
-    std::string tableName;
-    tableName = model.getTableName();
-    return tableName;
-}
+    std::string allConversionErrors;
+    StatementMetrics& metrics = statementStatistics.getMetrics(StatementKind::Stream, tableName);
+    StatisticsClock::duration executeTime{0};
+    StatisticsClock::duration convertTime{0};
+    std::size_t rowCount = 0;
+    std::size_t rowBytes = 0;
 
-std::string DBInterface::formatInsert(ModelBase &model)
-{
-    PTS_DataField_vector allFieldsWithValue = model.getAllFieldsWithValue();
-    std::string argFmt;
-    std::string valueFmt;
+    boost::mysql::pooled_connection conn;
+    boost::mysql::execution_state executionState;
+    try
+    {
+        conn = co_await checkOutConnection(metrics);
+        conn->set_meta_mode(boost::mysql::metadata_mode::full);
 
-    bool noComma = true;
-    for (auto field: allFieldsWithValue)
+        StatisticsClock::time_point phaseStart = StatisticsClock::now();
+        co_await startPreparedExecution(conn, PreparedStatementKind::Select, tableName, whereColumnNames, parameters,
+            executionState, selectColumnNames);
+        executeTime += StatisticsClock::now() - phaseStart;
+
+        ModelShp modelPrototype = modelFactory();
+        std::expected<ResultBindingPlan, std::string> bindingPlan = createBindingPlan(executionState.meta(),
+            *modelPrototype);
+        if (!bindingPlan)
+        {
+            // Rows left unread make the connection unusable.
+            dropConnection(conn);
+            co_return std::unexpected(bindingPlan.error());
+        }
+
+        ModelList modelBatch;
+        modelBatch.reserve(streamBatchSize);
+        while (executionState.should_read_rows())
+        {
+            phaseStart = StatisticsClock::now();
+            boost::mysql::rows_view rows;
+            try
+            {
+                rows = co_await conn->async_read_some_rows(executionState, boost::asio::cancel_after(queryTimeout));
+            }
+            catch (const boost::system::system_error& e)
+            {
+                if (isTimeout(e.code()))
+                {
+                    throwStatementTimeout(conn);
+                }
+                throw;
+            }
+            executeTime += StatisticsClock::now() - phaseStart;
+            rowCount += rows.size();
+            rowBytes += countRowBytes(rows);
+
+            phaseStart = StatisticsClock::now();
+            for (boost::mysql::row_view row: rows)
+            {
+                ModelShp model = modelFactory();
+                DBStatus converted = convertRowToModel(*bindingPlan, row, *model);
+                if (!converted)
+                {
+                    allConversionErrors += converted.error();
+                    continue;
+                }
+                modelBatch.push_back(model);
+                if (modelBatch.size() >= streamBatchSize)
+                {
+                    // The time spent in onBatch belongs to the caller.
+                    convertTime += StatisticsClock::now() - phaseStart;
+                    onBatch(modelBatch);
+                    modelBatch.clear();
+                    phaseStart = StatisticsClock::now();
+                }
+            }
+            convertTime += StatisticsClock::now() - phaseStart;
+        }
+
+        if (!modelBatch.empty())
+        {
+            onBatch(modelBatch);
+        }
+
+        returnConnection(conn);
+    }
+    catch(const std::exception& e)
     {
-        argFmt.append((noComma) ? std::format("{}", field->getColumnName()) : 
-            std::format(", {}", field->getColumnName()));
-        valueFmt.append((noComma) ? std::format("{}", field->toString()) :
-            std::format(", '{}'", field->toString()));
-        noComma = false;
+        if (executionState.should_read_head() || executionState.should_read_rows())
+        {
+            dropConnection(conn);
+        }
+        else
+        {
+            returnConnectionAfterError(conn);
+        }
+        metrics.recordError();
+        std::string eMsg("In DBInterface::streamModelsFromDB() ");
+        eMsg += e.what();
+        co_return std::unexpected(allConversionErrors + eMsg);
     }
 
-    std::string insertFMT(std::format("INSERT INTO {}.{} ({}) VALUES ({})", databaseName,
-        getTableNameFrom(model), argFmt, valueFmt));
+    metrics.recordLatency(StatementPhase::Execute, executeTime);
+    metrics.recordLatency(StatementPhase::Convert, convertTime);
+    metrics.recordStatement(rowCount, countParameterBytes(parameters) + rowBytes);
+    if (slowQueryLog.isSlow(executeTime))
+    {
+        slowQueryLog.record(formatSelect(tableName, whereColumnNames, selectColumnNames), executeTime, rowCount);
+    }
 
-    return insertFMT;
+    if (!allConversionErrors.empty())
+    {
+        co_return std::unexpected(allConversionErrors);
+    }
+
+    co_return DBStatus{};
 }
 
-std::string DBInterface::formatSelect(std::string tableName, std::vector<WhereArg> whereArgs)
+boost::asio::awaitable<boost::mysql::results> DBInterface::executePreparedStatementCoRoutine(PreparedStatementKind kind,
+    std::string tableName, std::vector<std::string> columnNames, std::vector<boost::mysql::field> parameters,
+    std::vector<std::string> selectColumnNames)
 {
-    std::string selectFMT(std::format("SELECT * FROM {}.{} WHERE ", databaseName, tableName));
+    boost::mysql::pooled_connection conn = co_await checkOutConnection(
+        statementStatistics.getMetrics(getStatementKind(kind), tableName));
+    boost::mysql::results result;
 
-    bool noComma = true;
-    for (auto whereArg: whereArgs)
+    try
     {
-        selectFMT.append((noComma)? std::format("{} = '{}'", whereArg.first, whereArg.second.toString()) :
-            std::format(" AND {} = '{}'", whereArg.first, whereArg.second.toString()));
-        noComma = false;
+        result = co_await executePreparedStatementOnConnection(conn, kind, tableName, columnNames, parameters,
+            selectColumnNames);
+    }
+    catch(const boost::mysql::error_with_diagnostics& e)
+    {
+        if (isServerError(e.code()))
+        {
+            returnConnection(conn);
+        }
+        else
+        {
+            returnConnectionAfterError(conn);
+        }
+        throw;
+    }
+    catch(const std::exception&)
+    {
+        returnConnectionAfterError(conn);
+        throw;
     }
 
-    return selectFMT;
+    returnConnection(conn);
+
+    co_return result;
 }
 
 /*
@@ -137,21 +2677,22 @@ std::string DBInterface::formatSelect(std::string tableName, std::vector<WhereAr
  * level as necessary where the knowlege about the results exists. This method only
  * executes the SQL statement(s) and returns all results.
  */
-boost::asio::awaitable<boost::mysql::results> DBInterface::executeSqlStatementsCoRoutine(std::string sqlStatement)
+boost::asio::awaitable<boost::mysql::results> DBInterface::executeSqlStatementsCoRoutine(StatementKind kind,
+    std::string tableName, std::string sqlStatement)
 {
-    boost::mysql::any_connection conn(co_await boost::asio::this_coro::executor);
+    StatementMetrics& metrics = statementStatistics.getMetrics(kind, tableName);
+    boost::mysql::pooled_connection conn = co_await checkOutConnection(metrics);
 
-    co_await conn.async_connect(dbConnectionParameters);
 /*
  * To properly process the select statements we need the column names in the metadata.
  */
     size_t foundPos = sqlStatement.find("SELECT");
     if (foundPos != std::string::npos) {
-        conn.set_meta_mode(boost::mysql::metadata_mode::full);
+        conn->set_meta_mode(boost::mysql::metadata_mode::full);
     }
     else
     {
-        conn.set_meta_mode(boost::mysql::metadata_mode::minimal);
+        conn->set_meta_mode(boost::mysql::metadata_mode::minimal);
     }
 
     if (verboseOutput)
@@ -160,143 +2701,277 @@ boost::asio::awaitable<boost::mysql::results> DBInterface::executeSqlStatementsC
     }
 
     boost::mysql::results result;
-    co_await conn.async_execute(sqlStatement, result);
+    try
+    {
+        co_await executeTextStatement(conn, metrics, sqlStatement, result);
+    }
+    catch(const std::exception&)
+    {
+        returnConnectionAfterError(conn);
+        throw;
+    }
 
-    co_await conn.async_close();
+    returnConnection(conn);
 
     co_return result;
 }
 
-boost::mysql::results DBInterface::runAnyMySQLstatementsAsynchronously(std::string selectSqlStatement)
+boost::asio::awaitable<void> DBInterface::executeTextStatement(boost::mysql::pooled_connection& conn,
+    StatementMetrics& metrics, const std::string& sqlStatement, boost::mysql::results& result)
 {
-    boost::asio::io_context ctx;
-    boost::mysql::results localResult;
+    StatisticsClock::time_point executeStart = StatisticsClock::now();
 
-    boost::asio::co_spawn(
-        ctx, executeSqlStatementsCoRoutine(selectSqlStatement),
-        [&localResult, this](std::exception_ptr ptr, boost::mysql::results result)
+    try
+    {
+        co_await conn->async_execute(sqlStatement, result, boost::asio::cancel_after(queryTimeout));
+    }
+    catch(const boost::system::system_error& e)
+    {
+        metrics.recordError();
+        if (isTimeout(e.code()))
         {
-            if (ptr)
-            {
-                std::rethrow_exception(ptr);
-            }
-            localResult = std::move(result);
+            throwStatementTimeout(conn);
         }
-    );
+        throw;
+    }
+
+    StatisticsClock::duration executeTime = StatisticsClock::now() - executeStart;
+    metrics.recordLatency(StatementPhase::Execute, executeTime);
+    metrics.recordStatement(result.rows().size(), sqlStatement.size() + countRowBytes(result.rows()));
+    if (slowQueryLog.isSlow(executeTime))
+    {
+        slowQueryLog.record(sqlStatement, executeTime, result.rows().size());
+    }
+}
+
+/*
+ * The size of the value as sent or received, numbers and dates count as 8 bytes.
+ */
+std::size_t DBInterface::countFieldBytes(boost::mysql::field_view value)
+{
+    switch (value.kind())
+    {
+        case boost::mysql::field_kind::null :
+            return 0;
+
+        case boost::mysql::field_kind::string :
+            return value.as_string().size();
+
+        case boost::mysql::field_kind::blob :
+            return value.as_blob().size();
+
+        default :
+            return sizeof(std::uint64_t);
+    }
+}
+
+std::size_t DBInterface::countParameterBytes(const std::vector<boost::mysql::field>& parameters)
+{
+    std::size_t parameterBytes = 0;
 
-    ctx.run();
+    for (const auto& parameter: parameters)
+    {
+        parameterBytes += countFieldBytes(parameter);
+    }
 
-    return localResult;
+    return parameterBytes;
 }
 
-bool DBInterface::convertResultsToModel(boost::mysql::row_view &sourceFromDB, std::vector<std::string> &columnNames, ModelShp destination)
+std::size_t DBInterface::countRowBytes(boost::mysql::rows_view rows)
 {
-    bool success = true;
-    auto sourceField = sourceFromDB.begin();
+    std::size_t rowBytes = 0;
 
-    for (auto columnName: columnNames)
+    for (boost::mysql::row_view row: rows)
     {
-        std::string conversionError("In DBInterface::convertResultsToMode(): to " + destination->getModelName() + " ");
-        PTS_DataField_shp currentFieldPtr = destination->findFieldInDataFields(columnName);
-        if (!currentFieldPtr)
+        for (boost::mysql::field_view value: row)
         {
-            conversionError += " does not contain field: " + columnName;
-            appendErrorMessage(conversionError);
-            return false;
+            rowBytes += countFieldBytes(value);
         }
-        if (!sourceField->is_null())
+    }
+
+    return rowBytes;
+}
+
+/*
+ * The result set metadata is resolved once per result set. Each binding holds the
+ * column index, the slot of the model field the column is stored in and the
+ * converter for the field type, so converting a row doesn't look up any names.
+ */
+std::expected<DBInterface::ResultBindingPlan, std::string> DBInterface::createBindingPlan(
+    boost::mysql::metadata_collection_view metadata, ModelBase& modelPrototype)
+{
+    ResultBindingPlan bindingPlan;
+    bindingPlan.reserve(metadata.size());
+
+    std::size_t columnIndex = 0;
+    for (auto metaIter: metadata)
+    {
+        std::string columnName(metaIter.column_name());
+        std::optional<std::size_t> fieldSlot = modelPrototype.findFieldSlot(columnName);
+        if (!fieldSlot.has_value())
         {
-            if (currentFieldPtr->isStringType())
-            {
-                currentFieldPtr->dbSetValue(sourceField->as_string());
-            }
-            else
-            {
-                try
-                {
-                    convertScalarFieldValue(*sourceField, currentFieldPtr);
-                }
-                catch(const std::exception& e)
-                {
-                    conversionError += e.what();
-                    appendErrorMessage(conversionError);
-                    success = false;
-                }
-                
-            }
+            return std::unexpected("In DBInterface::createBindingPlan(): " + modelPrototype.getModelName() +
+                " does not contain field: " + columnName);
+        }
+
+        PTS_DataField::PTS_DB_FieldType fieldType = modelPrototype.getFieldBySlot(*fieldSlot).getFieldType();
+        ColumnConverter converter = selectColumnConverter(fieldType);
+        if (!converter)
+        {
+            return std::unexpected("In DBInterface::createBindingPlan(): Column " + columnName +
+                " Unknown column type " + std::to_string(static_cast<int>(fieldType)));
+        }
+
+        bindingPlan.push_back({columnIndex, *fieldSlot, converter});
+        ++columnIndex;
+    }
+
+    return bindingPlan;
+}
+
+DBStatus DBInterface::convertRowToModel(const ResultBindingPlan& bindingPlan, boost::mysql::row_view sourceFromDB,
+    ModelBase& destination)
+{
+    std::string allConversionErrors;
+
+    for (const auto& binding: bindingPlan)
+    {
+        // The field now matches its column, only later changes need to be written back.
+        destination.markFieldLoaded(binding.fieldSlot);
+
+        boost::mysql::field_view sourceField = sourceFromDB[binding.columnIndex];
+        if (sourceField.is_null())
+        {
+            continue;
+        }
+
+        try
+        {
+            destination.loadFieldValueBySlot(binding.fieldSlot, binding.converter(sourceField));
         }
-        ++sourceField;
+        catch(const std::exception& e)
+        {
+            allConversionErrors += "In DBInterface::convertRowToModel(): to " + destination.getModelName() + " " +
+                destination.getFieldBySlot(binding.fieldSlot).getColumnName() + " " + e.what();
+        }
+    }
+
+    if (!allConversionErrors.empty())
+    {
+        return std::unexpected(allConversionErrors);
     }
 
-    return success;
+    return DBStatus{};
 }
 
-void DBInterface::convertScalarFieldValue(boost::mysql::field_view sourceField, PTS_DataField_shp currentFieldPtr)
+DBInterface::ColumnConverter DBInterface::selectColumnConverter(PTS_DataField::PTS_DB_FieldType fieldType)
 {
-    switch (currentFieldPtr->getFieldType())
+    switch (fieldType)
     {
+        case PTS_DataField::PTS_DB_FieldType::VarChar45 :
+        case PTS_DataField::PTS_DB_FieldType::VarChar256 :
+        case PTS_DataField::PTS_DB_FieldType::VarChar1024 :
+        case PTS_DataField::PTS_DB_FieldType::TinyText :
+        case PTS_DataField::PTS_DB_FieldType::Text :
+            return convertStringColumn;
+
         case PTS_DataField::PTS_DB_FieldType::Boolean :
-            currentFieldPtr->dbSetValue(static_cast<bool>(sourceField.as_int64()));
-            break;
+            return convertBooleanColumn;
 
         case PTS_DataField::PTS_DB_FieldType::Date :
-            currentFieldPtr->dbSetValue(convertBoostMySQLDateToChornoDate(sourceField.as_date()));
-            break;
+            return convertDateColumn;
 
         case PTS_DataField::PTS_DB_FieldType::DateTime :
         case PTS_DataField::PTS_DB_FieldType::TimeStamp :
-            currentFieldPtr->dbSetValue(sourceField.as_datetime().as_time_point());
-            break;
+            return convertDateTimeColumn;
 
         case PTS_DataField::PTS_DB_FieldType::Int :
-            currentFieldPtr->dbSetValue(static_cast<int>(sourceField.as_int64()));
-            break;
+            return convertIntColumn;
 
         case PTS_DataField::PTS_DB_FieldType::Key :
         case PTS_DataField::PTS_DB_FieldType::Size_T :
-            currentFieldPtr->dbSetValue(sourceField.as_uint64());
-            break;
+            return convertKeyColumn;
 
         case PTS_DataField::PTS_DB_FieldType::UnsignedInt :
-            currentFieldPtr->dbSetValue(static_cast<unsigned int>(sourceField.as_uint64()));
-            break;
+            return convertUnsignedIntColumn;
 
         case PTS_DataField::PTS_DB_FieldType::Double :
-            currentFieldPtr->dbSetValue(sourceField.as_double());
-            break;
+            return convertDoubleColumn;
 
         default:
-            std::string typeError("Column " + currentFieldPtr->getColumnName() +
-                "Unknown column type " + std::to_string(static_cast<int>(currentFieldPtr->getFieldType())));
-            std::domain_error ex(typeError);
-            throw ex;
-            break;
+            return nullptr;
     }
 }
 
-bool DBInterface::executeSimpleQueryProcessResults(std::string sqlStatements, ModelShp destination)
+DataValueType DBInterface::convertStringColumn(boost::mysql::field_view sourceField)
+{
+    return std::string(sourceField.as_string());
+}
+
+DataValueType DBInterface::convertBooleanColumn(boost::mysql::field_view sourceField)
+{
+    return static_cast<bool>(sourceField.as_int64());
+}
+
+DataValueType DBInterface::convertDateColumn(boost::mysql::field_view sourceField)
+{
+    return convertBoostMySQLDateToChornoDate(sourceField.as_date());
+}
+
+DataValueType DBInterface::convertDateTimeColumn(boost::mysql::field_view sourceField)
+{
+    return sourceField.as_datetime().as_time_point();
+}
+
+DataValueType DBInterface::convertIntColumn(boost::mysql::field_view sourceField)
+{
+    return static_cast<int>(sourceField.as_int64());
+}
+
+DataValueType DBInterface::convertKeyColumn(boost::mysql::field_view sourceField)
+{
+    return static_cast<std::size_t>(sourceField.as_uint64());
+}
+
+DataValueType DBInterface::convertUnsignedIntColumn(boost::mysql::field_view sourceField)
 {
-    boost::mysql::results results = runAnyMySQLstatementsAsynchronously(sqlStatements);
+    return static_cast<unsigned int>(sourceField.as_uint64());
+}
+
+DataValueType DBInterface::convertDoubleColumn(boost::mysql::field_view sourceField)
+{
+    return sourceField.as_double();
+}
+
+boost::asio::awaitable<DBStatus> DBInterface::executeSimpleQueryProcessResults(std::string tableName,
+    std::vector<std::string> whereColumnNames, std::vector<boost::mysql::field> parameters, ModelBase& destination,
+    std::vector<std::string> selectColumnNames)
+{
+    boost::mysql::results results = co_await executePreparedStatementCoRoutine(PreparedStatementKind::Select,
+        tableName, std::move(whereColumnNames), std::move(parameters), std::move(selectColumnNames));
+
+    StatisticsClock::time_point convertStart = StatisticsClock::now();
+    DBStatus converted = convertFirstRowToModel(results, destination);
+    statementStatistics.getMetrics(StatementKind::Select, tableName).recordLatency(StatementPhase::Convert,
+        StatisticsClock::now() - convertStart);
+
+    co_return converted;
+}
 
+DBStatus DBInterface::convertFirstRowToModel(const boost::mysql::results& results, ModelBase& destination)
+{
     if (results.rows().empty())
     {
         std::string eMsg("No results from query, object not found in database!");
-        appendErrorMessage(eMsg);
-        return false;
-    }
-
-    std::vector<std::string> columnNames;
-    for (auto metaIter: results.meta())
-    {
-        columnNames.push_back(metaIter.column_name());
+        return std::unexpected(eMsg);
     }
 
-    boost::mysql::row_view sourceFromDB = results.rows().at(0);
-    if (convertResultsToModel(sourceFromDB, columnNames, destination))
+    std::expected<ResultBindingPlan, std::string> bindingPlan = createBindingPlan(results.meta(), destination);
+    if (!bindingPlan)
     {
-        return true;
+        return std::unexpected(bindingPlan.error());
     }
 
-    return false;
+    return convertRowToModel(*bindingPlan, results.rows().at(0), destination);
 }
 
@@ -1,15 +1,33 @@
 #ifndef DBINTERFACE_H_
 #define DBINTERFACE_H_
 
+#include <atomic>
 #include <boost/asio.hpp>
+#include <boost/asio/experimental/concurrent_channel.hpp>
 #include <boost/mysql.hpp>
 #include <chrono>
 #include "CommandLineParser.h"
+#include <cstddef>
+#include <cstdint>
+#include <expected>
+#include <functional>
+#include <future>
 #include <initializer_list>
+#include <memory>
 #include "ModelBase.h"
+#include "ModelIdentityMap.h"
+#include <mutex>
+#include <optional>
+#include <ostream>
 #include "PTS_DataField.h"
+#include "SlowQueryLog.h"
+#include <stdexcept>
+#include "StatementStatistics.h"
+#include "StorageInterface.h"
 #include <string>
 #include "TaskModel.h"
+#include <thread>
+#include <unordered_map>
 #include "UserModel.h"
 #include <utility>
 #include <vector>
@@ -28,45 +46,419 @@
  * 
  * Exceptions should not be used if at all possible.
  * 
+ * The async_ methods may run concurrently with each other, so they don't touch
+ * errorMessages. They report errors through the returned DBStatus instead, the
+ * blocking methods copy any error in DBStatus into errorMessages.
+ * 
+ */
+
+/*
+ * A pool hit is a check out of a session that had been checked out before, a miss
+ * is the first check out of a session the pool opened or reopened. Sessions are
+ * told apart by the server's connection id.
  */
+struct ConnectionPoolStatistics
+{
+    std::size_t hits;
+    std::size_t misses;
+};
+
+/*
+ * A connect timeout is a check out that got no connection before its deadline,
+ * a statement timeout is a statement cancelled by the query timeout or by the
+ * deadline of the call.
+ */
+struct TimeoutStatistics
+{
+    std::size_t connectTimeouts;
+    std::size_t statementTimeouts;
+};
 
- using WhereArg = std::pair<std::string, PTS_DataField>;
+/*
+ * Thrown inside DBInterface when an operation misses its deadline, the public
+ * methods report it like any other error.
+ */
+class DBTimeoutError : public std::runtime_error
+{
+public:
+    using std::runtime_error::runtime_error;
+};
 
-class DBInterface
+/*
+ * The MySQL implementation of StorageInterface.
+ */
+class DBInterface : public StorageInterface
 {
 public:
     DBInterface(ProgramOptions& programOptions);
-    virtual ~DBInterface() = default;
-    std::string getAllErrorMessages() const { return errorMessages; };
-    bool insertIntoDataBase(ModelBase& model);
-    bool getUniqueModelFromDB(ModelShp model, std::vector<WhereArg> whereArgs);
-    bool getUniqueModelFromDB(ModelShp model, std::initializer_list<WhereArg> whereArgs)
+    virtual ~DBInterface();
+    ConnectionPoolStatistics getConnectionPoolStatistics() const { return {poolHits.load(), poolMisses.load()}; };
+    ModelCacheStatistics getModelCacheStatistics() const { return modelCache.getStatistics(); };
+    std::vector<StatementStatisticsSummary> getStatementStatistics() const { return statementStatistics.getSummary(); };
+    void reportStatementStatistics(std::ostream& output) const { statementStatistics.report(output); };
+    TimeoutStatistics getTimeoutStatistics() const { return {connectTimeouts.load(), statementTimeouts.load()}; };
+/*
+ * Every blocking call made after this must complete within timeout, zero removes
+ * the deadline. Each statement is also limited by the query timeout.
+ */
+    void setCallTimeout(std::chrono::milliseconds timeout) { callTimeout = timeout; };
+/*
+ * Spawn the async_ methods on getExecutor() to keep many statements in flight.
+ * Models passed by reference must outlive the awaitable. Each call returns a new
+ * strand, the deadlines cancel operations through cancellation slots and those
+ * are not thread safe.
+ */
+    boost::asio::strand<boost::asio::io_context::executor_type> getExecutor()
     {
-        std::vector<WhereArg> vWhereArgs{whereArgs};
-        return getUniqueModelFromDB(model, vWhereArgs);
+        return boost::asio::make_strand(ioContext);
     };
-    UserList getAllUsers();
-    TaskList getAllTasksForUser(UserModel_shp user);
-    TaskList getAllTasksForUser(UserModel& user);
+    boost::asio::awaitable<DBStatus> async_insert(ModelBase& model);
+    boost::asio::awaitable<DBStatus> async_getUniqueModel(ModelShp model, std::vector<WhereArg> whereArgs);
+    boost::asio::awaitable<std::expected<ModelShp, std::string>> async_getCachedModel(ModelShp model,
+        std::vector<WhereArg> whereArgs);
+    boost::asio::awaitable<std::vector<DBStatus>> async_getUniqueModels(ModelList& models,
+        std::vector<std::string> keyColumnNames, std::vector<KeyTuple> keys);
+/*
+ * Statements join an open transaction unless TransactionUse::Bypass asks for a
+ * pooled connection of their own, they are then committed on their own.
+ */
+    enum class TransactionUse {Join, Bypass};
+    boost::asio::awaitable<std::vector<DBStatus>> async_insertMany(ModelList& models,
+        TransactionUse transactionUse=TransactionUse::Join);
+    boost::asio::awaitable<DBStatus> async_update(ModelBase& model);
+    boost::asio::awaitable<std::vector<DBStatus>> async_updateMany(ModelList& models,
+        TransactionUse transactionUse=TransactionUse::Join);
+    boost::asio::awaitable<bool> async_executePipeline(std::vector<PipelineStage>& stages,
+        TransactionUse transactionUse=TransactionUse::Join);
+    boost::asio::awaitable<DBStatus> async_getAllUsers(UserBatchCallback onBatch);
+    boost::asio::awaitable<DBStatus> async_getAllTasksForUser(std::size_t userID, TaskBatchCallback onBatch);
+    boost::asio::awaitable<DBStatus> async_getProjectedModel(ModelShp model, std::vector<WhereArg> whereArgs,
+        FieldProjection projection);
+    boost::asio::awaitable<DBStatus> async_getAllUsers(UserBatchCallback onBatch, FieldProjection projection);
+    boost::asio::awaitable<DBStatus> async_loadMissingFields(ModelBase& model);
+    boost::asio::awaitable<std::expected<TaskPage, std::string>> async_getTaskPageForUser(std::size_t userID,
+        TaskPageOrder order, std::size_t pageSize, std::string cursor);
+    boost::asio::awaitable<std::expected<ChangedTasks, std::string>> async_getTasksChangedSince(std::size_t userID,
+        ChangeWatermark watermark);
+    boost::asio::awaitable<std::expected<TaskTreeNodeShp, std::string>> async_getTaskSubtree(std::size_t rootTaskID,
+        std::size_t maxDepth);
+    boost::asio::awaitable<DBStatus> async_beginTransaction();
+    boost::asio::awaitable<DBStatus> async_commit();
+    boost::asio::awaitable<DBStatus> async_rollback();
+/*
+ * While a transaction is open every statement of this DBInterface runs on the
+ * connection of the transaction, so statements must not be issued concurrently.
+ * A statement that fails gives the connection back to the transaction. If a
+ * statement misses its deadline the connection is dropped and the server rolls
+ * the transaction back, every later statement of the transaction and commit()
+ * then fail until rollback() ends it. Models cached while the transaction is
+ * open are dropped from the model cache unless it commits.
+ */
+    bool beginTransaction() override;
+    bool commit() override;
+    bool rollback() override;
+    bool insertIntoDataBase(ModelBase& model) override;
+    bool insertManyIntoDataBase(ModelList& models) override;
+    bool updateInDataBase(ModelBase& model) override;
+    bool updateManyInDataBase(ModelList& models) override;
+    bool executePipeline(std::vector<PipelineStage>& stages) override;
+    using StorageInterface::getUniqueModelFromDB;
+    bool getUniqueModelFromDB(ModelShp model, std::vector<WhereArg> whereArgs) override;
+    ModelShp getCachedModelFromDB(ModelShp model, std::vector<WhereArg> whereArgs) override;
+    bool getUniqueModelsFromDB(ModelList& models, const std::vector<std::string>& keyColumnNames,
+        const std::vector<KeyTuple>& keys) override;
+    using StorageInterface::getAllUsers;
+    using StorageInterface::getAllTasksForUser;
+    bool getAllUsers(UserBatchCallback onBatch) override;
+    bool getAllTasksForUser(std::size_t userID, TaskBatchCallback onBatch) override;
+    bool getTaskPageForUser(std::size_t userID, TaskPageOrder order, std::size_t pageSize, const std::string& cursor,
+        TaskPage& page) override;
+    bool getTasksChangedSince(std::size_t userID, const ChangeWatermark& watermark, ChangedTasks& changes) override;
+    bool getTaskSubtree(std::size_t rootTaskID, std::size_t maxDepth, TaskTreeNodeShp& root) override;
+/*
+ * Projected reads select only the primary key and the projected columns. Projected
+ * models bypass the model cache.
+ */
+    bool getProjectedModelFromDB(ModelShp model, std::vector<WhereArg> whereArgs, FieldProjection projection) override;
+    bool getAllUsers(UserBatchCallback onBatch, FieldProjection projection) override;
+    DBStatus loadMissingFields(ModelBase& model) override;
 
 private:
-    void clearPreviousErrors() { errorMessages.clear(); };
-    void appendErrorMessage(std::string newError) { errorMessages.append(newError); };
+/*
+ * The write-behind flusher writes on pooled connections of its own, an open
+ * transaction neither includes the queued writes nor waits for them.
+ */
+    std::vector<DBStatus> insertOutsideTransaction(ModelList& models) override;
+    std::vector<DBStatus> updateOutsideTransaction(ModelList& models) override;
+/*
+ * Blocks the calling thread until the operation completes on ioContext. Exceptions
+ * are rethrown by get(). When the call deadline expires the statement in progress
+ * is cancelled and the operation reports the timeout.
+ * Called from one of the ioContext threads, such as from a batch callback, the
+ * wait would never end, the thread it waits for is the one that is blocked. That
+ * throws std::logic_error instead.
+ */
+    template<typename ResultType>
+    ResultType runOnIoContext(boost::asio::awaitable<ResultType> operation)
+    {
+        if (ioContext.get_executor().running_in_this_thread())
+        {
+            throw std::logic_error("A blocking DBInterface method was called on a DBInterface thread, "
+                "batch callbacks must not call back into the storage.");
+        }
+
+        std::chrono::milliseconds timeout = callTimeout.load();
+        if (timeout.count() == 0)
+        {
+            std::future<ResultType> result = boost::asio::co_spawn(getExecutor(), std::move(operation),
+                boost::asio::use_future);
+            return result.get();
+        }
+
+        std::future<ResultType> result = boost::asio::co_spawn(getExecutor(), std::move(operation),
+            boost::asio::cancel_after(timeout, boost::asio::use_future));
+        return result.get();
+    }
     std::string getTableNameFrom(ModelBase& model);
-    std::string formatInsert(ModelBase& model);
-    std::string formatSelect(std::string tableName, std::vector<WhereArg> whereArgs);
-    boost::asio::awaitable<boost::mysql::results> executeSqlStatementsCoRoutine(std::string selectSqlStatement);
-    boost::mysql::results runAnyMySQLstatementsAsynchronously(std::string selectSqlStatement);
-    bool convertResultsToModel(boost::mysql::row_view& sourceFromDB, std::vector<std::string>& columnNames, ModelShp destination);
-    void convertScalarFieldValue(boost::mysql::field_view sourceField, PTS_DataField_shp currentFieldPtr);
-    bool executeSimpleQueryProcessResults(std::string sqlStatements, ModelShp destination);
+    void collectInsertValues(ModelBase& model, std::vector<std::string>& columnNames,
+        std::vector<boost::mysql::field>& parameters);
+    bool collectUpdateValues(ModelBase& model, std::vector<std::string>& columnNames,
+        std::vector<boost::mysql::field>& parameters);
+    void collectWhereValues(std::vector<WhereArg>& whereArgs, std::vector<std::string>& columnNames,
+        std::vector<boost::mysql::field>& parameters);
+
+/*
+ * Prepared statements belong to a session, so they are cached per connection for
+ * the session id they were prepared in. A reconnect starts a new session and a
+ * reset deallocates the statements, the pool resets every connection that isn't
+ * returned without reset. Checking out a connection drops its statements unless
+ * the session is unchanged and was returned without reset.
+ * The cache key is built from the table and column names only, the SQL text is
+ * only generated when a statement has to be prepared. selectColumnNames only
+ * applies to Select, AllColumns selects every column.
+ */
+    enum class PreparedStatementKind {Insert, Update, Select};
+    using PreparedStatementMap = std::unordered_map<std::string, boost::mysql::statement>;
+    struct SessionStatements
+    {
+        std::uint32_t sessionID = 0;
+        bool returnedWithoutReset = false;
+        PreparedStatementMap statements;
+    };
+    static const std::vector<std::string> AllColumns;
+    std::string makeStatementCacheKey(PreparedStatementKind kind, const std::string& tableName,
+        const std::vector<std::string>& columnNames, const std::vector<std::string>& selectColumnNames = AllColumns);
+    std::string formatPreparedStatement(PreparedStatementKind kind, const std::string& tableName,
+        const std::vector<std::string>& columnNames, const std::vector<std::string>& selectColumnNames = AllColumns);
+    std::string formatInsert(const std::string& tableName, const std::vector<std::string>& columnNames);
+    std::string formatUpdate(const std::string& tableName, const std::vector<std::string>& columnNames);
+    std::string formatSelect(const std::string& tableName, const std::vector<std::string>& whereColumnNames,
+        const std::vector<std::string>& selectColumnNames = AllColumns);
+    boost::mysql::field convertDataValueToField(const DataValueType& dataValue);
+    boost::mysql::field convertDataFieldToField(const PTS_DataField& dataField);
+    boost::asio::awaitable<boost::mysql::statement> getPreparedStatement(boost::mysql::pooled_connection& conn,
+        PreparedStatementKind kind, const std::string& tableName, const std::vector<std::string>& columnNames,
+        const std::vector<std::string>& selectColumnNames = AllColumns);
+/*
+ * Returns true if the session was handed out before, the entry of the connection
+ * remembers its last session id.
+ */
+    bool claimPreparedStatements(const boost::mysql::pooled_connection& conn);
+    void forgetPreparedStatements(const boost::mysql::pooled_connection& conn);
+    static StatementKind getStatementKind(PreparedStatementKind kind);
+    boost::asio::awaitable<boost::mysql::results> executePreparedStatementOnConnection(boost::mysql::pooled_connection& conn,
+        PreparedStatementKind kind, const std::string& tableName, const std::vector<std::string>& columnNames,
+        const std::vector<boost::mysql::field>& parameters, const std::vector<std::string>& selectColumnNames = AllColumns);
+    boost::asio::awaitable<void> startPreparedExecution(boost::mysql::pooled_connection& conn,
+        PreparedStatementKind kind, const std::string& tableName, const std::vector<std::string>& columnNames,
+        const std::vector<boost::mysql::field>& parameters, boost::mysql::execution_state& executionState,
+        const std::vector<std::string>& selectColumnNames = AllColumns);
+    boost::asio::awaitable<boost::mysql::results> executePreparedStatementCoRoutine(PreparedStatementKind kind,
+        std::string tableName, std::vector<std::string> columnNames, std::vector<boost::mysql::field> parameters,
+        std::vector<std::string> selectColumnNames = AllColumns);
+
+/*
+ * The columns that a projected read selects, see findProjectedSlots().
+ */
+    std::vector<std::string> getSlotColumnNames(const ModelBase& model, const std::vector<std::size_t>& slots);
+/*
+ * Bulk inserts, each group of models shares a table and column list.
+ */
+    struct BulkInsertGroup
+    {
+        std::string tableName;
+        std::vector<std::string> columnNames;
+        std::vector<std::size_t> modelIndexes;
+        std::vector<std::vector<boost::mysql::field>> rowParameters;
+    };
+    std::vector<BulkInsertGroup> groupModelsForBulkInsert(ModelList& models, std::vector<DBStatus>& modelStatus);
+    std::string formatBulkInsertStart(const boost::mysql::format_options& formatOptions, const BulkInsertGroup& insertGroup);
+    std::string formatBulkInsertRow(const boost::mysql::format_options& formatOptions,
+        const std::vector<boost::mysql::field>& rowParameters);
+    boost::asio::awaitable<std::uint64_t> getAutoIncrementIncrement(boost::mysql::pooled_connection& conn);
+    boost::asio::awaitable<void> executeBulkInsertChunk(boost::mysql::pooled_connection& conn,
+        const BulkInsertGroup& insertGroup, const std::string& statementStart, const std::vector<std::string>& chunkRows,
+        const std::vector<std::size_t>& chunkModels, ModelList& models, std::vector<DBStatus>& modelStatus,
+        std::uint64_t keyIncrement);
+
+/*
+ * Batch key lookups, modelsByKey lists the models waiting for each key that is
+ * still to be found. The server matches the keys under the collation of the key
+ * columns, so the key strings are built from comparison values.
+ */
+    using WaitingModelMap = std::unordered_map<std::string, std::vector<std::size_t>>;
+    std::string makeLookupKeyString(const KeyTuple& key);
+    std::string formatKeyLookup(const boost::mysql::format_options& formatOptions, const std::string& tableName,
+        const std::vector<std::string>& keyColumnNames, const std::vector<const KeyTuple*>& lookupTuples,
+        std::size_t chunkStart, std::size_t chunkEnd);
+    boost::asio::awaitable<void> executeKeyLookupChunk(boost::mysql::pooled_connection& conn, StatementMetrics& metrics,
+        std::string sqlStatement, const std::vector<std::string>& keyColumnNames, ModelBase& modelPrototype, WaitingModelMap& modelsByKey,
+        ModelList& models, std::vector<DBStatus>& modelStatus);
+
+/*
+ * Streaming list queries.
+ */
+    using ModelFactory = std::function<ModelShp()>;
+    using ModelBatchCallback = std::function<void(ModelList& modelBatch)>;
+    boost::asio::awaitable<DBStatus> streamModelsFromDB(std::string tableName, std::vector<std::string> whereColumnNames,
+        std::vector<boost::mysql::field> parameters, ModelFactory modelFactory, ModelBatchCallback onBatch,
+        std::vector<std::string> selectColumnNames);
+
+/*
+ * Task queries formatted as text. The page query continues after position instead
+ * of using an OFFSET, the subtree query walks ParentTask with a recursive CTE.
+ */
+    using QueryFormatter = std::function<std::string(const boost::mysql::format_options& formatOptions)>;
+    boost::asio::awaitable<TaskList> selectTasks(QueryFormatter formatQuery);
+    std::string formatTaskPage(const boost::mysql::format_options& formatOptions, std::size_t userID,
+        TaskPageOrder order, std::size_t rowLimit, const std::optional<TaskPageCursor>& position);
+    std::string formatTasksChangedSince(const boost::mysql::format_options& formatOptions, std::size_t userID,
+        ChangeStamp windowStart);
+    std::string formatTaskSubtree(const boost::mysql::format_options& formatOptions, std::size_t rootTaskID,
+        std::size_t maxDepth);
+
+/*
+ * Pipelines, a PipelinedStatement is the prepared form of stages[stageIndex].
+ */
+    struct PipelinedStatement
+    {
+        std::size_t stageIndex;
+        PreparedStatementKind kind;
+        std::string tableName;
+        std::vector<std::string> columnNames;
+        std::vector<boost::mysql::field> parameters;
+    };
+    boost::asio::awaitable<bool> executePipelineChunk(boost::mysql::pooled_connection& conn,
+        const std::vector<PipelinedStatement>& pipelinedStatements, std::size_t chunkStart, std::size_t chunkEnd,
+        std::vector<PipelineStage>& stages);
+
+/*
+ * Transactions, the connection of an open transaction is checked out by one
+ * statement at a time and returned to transactionConnection afterwards, also
+ * when the statement fails. transactionLost is set when the connection had to
+ * be dropped.
+ */
+    bool isTransactionActive();
+    boost::asio::awaitable<DBStatus> endTransaction(std::string sqlStatement);
+    void storeInModelCache(const ModelBase& model);
+    void refreshModelCache(const ModelBase& model);
+    void rememberTransactionRow(const ModelBase& model);
+
+/*
+ * Group commit, single inserts are queued for up to groupCommitWindow and then
+ * inserted and committed in one transaction. The completion channel wakes the
+ * waiting insert once status and insertID are set.
+ */
+    struct GroupCommitRequest
+    {
+        GroupCommitRequest(boost::asio::io_context::executor_type executor, std::string table,
+            std::vector<std::string> columns, std::vector<boost::mysql::field> values)
+        :   tableName{std::move(table)}, columnNames{std::move(columns)}, parameters{std::move(values)},
+            insertID{0}, completion{executor, 1}
+        {
+        }
+        std::string tableName;
+        std::vector<std::string> columnNames;
+        std::vector<boost::mysql::field> parameters;
+        std::uint64_t insertID;
+        DBStatus status;
+        boost::asio::experimental::concurrent_channel<void(boost::system::error_code)> completion;
+    };
+    using GroupCommitRequestShp = std::shared_ptr<GroupCommitRequest>;
+    boost::asio::awaitable<DBStatus> insertWithGroupCommit(ModelBase& model, std::string tableName,
+        std::vector<std::string> columnNames, std::vector<boost::mysql::field> parameters);
+    boost::asio::awaitable<void> commitGroupAfterWindow(std::size_t groupNumber);
+    boost::asio::awaitable<void> commitGroup(std::vector<GroupCommitRequestShp> group);
+
+/*
+ * Deadlines, an operation cancelled by its deadline leaves the connection in an
+ * unknown state. The connection is not used again, it goes back to the pool with
+ * a reset when it goes out of scope and the pool reconnects it if necessary.
+ */
+    static bool isTimeout(const boost::system::error_code& errorCode);
+/*
+ * An error reported by the server leaves the connection usable, a network or
+ * client error does not.
+ */
+    static bool isServerError(const boost::system::error_code& errorCode);
+    static bool updateMatchedRow(const boost::mysql::results& result);
+    [[noreturn]] void throwStatementTimeout(boost::mysql::pooled_connection& conn);
+
+    boost::mysql::pool_params createPoolParameters(ProgramOptions& programOptions);
+    boost::asio::awaitable<boost::mysql::pooled_connection> checkOutConnection(StatementMetrics& metrics,
+        TransactionUse transactionUse=TransactionUse::Join);
+    boost::asio::awaitable<boost::mysql::pooled_connection> checkOutPooledConnection(StatementMetrics& metrics);
+    void returnConnection(boost::mysql::pooled_connection& connection);
+    void returnConnectionAfterError(boost::mysql::pooled_connection& connection);
+    void dropConnection(boost::mysql::pooled_connection& connection);
+/*
+ * The server's id for the session, it changes when the pool reconnects. Zero if
+ * the connection isn't connected.
+ */
+    static std::uint32_t getSessionID(const boost::mysql::pooled_connection& connection);
+    boost::asio::awaitable<void> executeTextStatement(boost::mysql::pooled_connection& conn, StatementMetrics& metrics,
+        const std::string& sqlStatement, boost::mysql::results& result);
+    boost::asio::awaitable<boost::mysql::results> executeSqlStatementsCoRoutine(StatementKind kind, std::string tableName,
+        std::string sqlStatement);
+    static std::size_t countFieldBytes(boost::mysql::field_view value);
+    static std::size_t countParameterBytes(const std::vector<boost::mysql::field>& parameters);
+    static std::size_t countRowBytes(boost::mysql::rows_view rows);
+    DBStatus convertFirstRowToModel(const boost::mysql::results& results, ModelBase& destination);
+
+/*
+ * Result set conversion, see createBindingPlan().
+ */
+    using ColumnConverter = DataValueType (*)(boost::mysql::field_view sourceField);
+    struct ColumnBinding
+    {
+        std::size_t columnIndex;
+        std::size_t fieldSlot;
+        ColumnConverter converter;
+    };
+    using ResultBindingPlan = std::vector<ColumnBinding>;
+    std::expected<ResultBindingPlan, std::string> createBindingPlan(boost::mysql::metadata_collection_view metadata,
+        ModelBase& modelPrototype);
+    DBStatus convertRowToModel(const ResultBindingPlan& bindingPlan, boost::mysql::row_view sourceFromDB,
+        ModelBase& destination);
+    static ColumnConverter selectColumnConverter(PTS_DataField::PTS_DB_FieldType fieldType);
+    static DataValueType convertStringColumn(boost::mysql::field_view sourceField);
+    static DataValueType convertBooleanColumn(boost::mysql::field_view sourceField);
+    static DataValueType convertDateColumn(boost::mysql::field_view sourceField);
+    static DataValueType convertDateTimeColumn(boost::mysql::field_view sourceField);
+    static DataValueType convertIntColumn(boost::mysql::field_view sourceField);
+    static DataValueType convertKeyColumn(boost::mysql::field_view sourceField);
+    static DataValueType convertUnsignedIntColumn(boost::mysql::field_view sourceField);
+    static DataValueType convertDoubleColumn(boost::mysql::field_view sourceField);
+    boost::asio::awaitable<DBStatus> executeSimpleQueryProcessResults(std::string tableName,
+        std::vector<std::string> whereColumnNames, std::vector<boost::mysql::field> parameters, ModelBase& destination,
+        std::vector<std::string> selectColumnNames);
     boost::mysql::date convertChronoDateToBoostMySQLDate(std::chrono::year_month_day source)
     {
         std::chrono::sys_days tp = source;
         boost::mysql::date boostDate(tp);
         return boostDate;
     };
-    std::chrono::year_month_day convertBoostMySQLDateToChornoDate(boost::mysql::date source)
+    static std::chrono::year_month_day convertBoostMySQLDateToChornoDate(boost::mysql::date source)
     {
         const std::chrono::year year{source.year()};
         const std::chrono::month month{source.month()};
@@ -75,10 +467,48 @@ private:
         return converted;
     };
 
-    boost::mysql::connect_params dbConnectionParameters;
-    std::string errorMessages;
     std::string databaseName;
     bool verboseOutput;
+    bool resetIdleConnections;
+    std::size_t bulkInsertMaxRows;
+    std::size_t bulkInsertMaxBytes;
+    std::size_t pipelineDepth;
+    std::size_t streamBatchSize;
+    std::size_t lookupBatchSize;
+    bool reportStatisticsOnExit;
+    StatementStatistics statementStatistics;
+    SlowQueryLog slowQueryLog;
+    std::chrono::milliseconds connectTimeout;
+    std::chrono::milliseconds queryTimeout;
+    std::atomic<std::chrono::milliseconds> callTimeout;
+    std::atomic<std::size_t> connectTimeouts;
+    std::atomic<std::size_t> statementTimeouts;
+
+/*
+ * The connection pool and all statements run on ioContext for the lifetime of the
+ * DBInterface object so that connections stay open between statements.
+ */
+    boost::asio::io_context ioContext;
+    boost::asio::executor_work_guard<boost::asio::io_context::executor_type> ioWorkGuard;
+    std::unique_ptr<boost::mysql::connection_pool> connectionPool;
+    std::vector<std::jthread> ioThreads;
+    std::atomic<std::size_t> poolHits;
+    std::atomic<std::size_t> poolMisses;
+    std::atomic<std::uint64_t> autoIncrementIncrement;
+    ModelIdentityMap modelCache;
+    std::mutex transactionLock;
+    bool transactionActive;
+    bool transactionLost;
+    const boost::mysql::any_connection* transactionConnectionID;
+    std::optional<boost::mysql::pooled_connection> transactionConnection;
+    std::vector<std::string> transactionRowKeys;
+    std::chrono::milliseconds groupCommitWindow;
+    std::size_t groupCommitMaxSize;
+    std::mutex groupCommitLock;
+    std::vector<GroupCommitRequestShp> groupCommitQueue;
+    std::size_t groupCommitNumber;
+    std::mutex preparedStatementsLock;
+    std::unordered_map<const boost::mysql::any_connection*, SessionStatements> preparedStatements;
 };
 
 #endif // DBINTERFACE_H_
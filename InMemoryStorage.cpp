@@ -0,0 +1,1042 @@
+#include <algorithm>
+#include <chrono>
+#include "CommandLineParser.h"
+#include <cstddef>
+#include <expected>
+#include <format>
+#include "InMemoryStorage.h"
+#include <map>
+#include <memory>
+#include "ModelBase.h"
+#include "ModelSchema.h"
+#include <mutex>
+#include <optional>
+#include "PTS_DataField.h"
+#include <stdexcept>
+#include "StorageInterface.h"
+#include <string>
+#include "TaskModel.h"
+#include <unordered_map>
+#include <unordered_set>
+#include "UserModel.h"
+#include <utility>
+#include <variant>
+#include <vector>
+
+InMemoryStorage::InMemoryStorage(ProgramOptions& programOptions)
+: streamBatchSize{programOptions.streamBatchSize}, transactionActive{false}
+{
+    UserModel userPrototype;
+    TaskModel taskPrototype;
+    std::string userTable = userPrototype.getTableName();
+    std::string taskTable = taskPrototype.getTableName();
+
+    // The tables and indexes declared in PlannerTaskScheduleDB.sql.
+    addTable(userPrototype);
+    addIndex(userTable, "FullName_UNIQUE", {"LastName", "FirstName", "MiddleInitial"}, true);
+    addIndex(userTable, "LoginName_UNIQUE", {"LoginName"}, true);
+    addIndex(userTable, "LastModified_idx", {"LastModified"}, false);
+
+    addTable(taskPrototype);
+    addIndex(taskTable, "fk_Tasks_CreatedBy_idx", {"CreatedBy"}, false);
+    addIndex(taskTable, "fk_Tasks_AsignedTo_idx", {"AsignedTo"}, false);
+    addIndex(taskTable, "Description_idx", {"Description"}, false);
+    addIndex(taskTable, "AsignedTo_RequiredDelivery_idx", {"AsignedTo", "RequiredDelivery", "TaskID"}, false);
+    addIndex(taskTable, "AsignedTo_LastModified_idx", {"AsignedTo", "LastModified"}, false);
+    addIndex(taskTable, "ParentTask_idx", {"ParentTask"}, false);
+
+    startWriteBehind(programOptions.writeBehindDepth);
+}
+
+InMemoryStorage::~InMemoryStorage()
+{
+    stopWriteBehind();
+}
+
+bool InMemoryStorage::beginTransaction()
+{
+    clearPreviousErrors();
+
+    std::lock_guard<std::mutex> guard(storageLock);
+    if (transactionActive)
+    {
+        appendErrorMessage("A transaction is already open.\n");
+        return false;
+    }
+
+    transactionActive = true;
+    undoLog.clear();
+
+    return true;
+}
+
+bool InMemoryStorage::commit()
+{
+    clearPreviousErrors();
+
+    std::lock_guard<std::mutex> guard(storageLock);
+    if (!transactionActive)
+    {
+        appendErrorMessage("No transaction is open.\n");
+        return false;
+    }
+
+    transactionActive = false;
+    undoLog.clear();
+
+    return true;
+}
+
+/*
+ * Keys handed out by the transaction are not reused, as with InnoDB.
+ */
+bool InMemoryStorage::rollback()
+{
+    clearPreviousErrors();
+
+    std::lock_guard<std::mutex> guard(storageLock);
+    if (!transactionActive)
+    {
+        appendErrorMessage("No transaction is open.\n");
+        return false;
+    }
+
+    transactionActive = false;
+    for (auto undoRecord = undoLog.rbegin(); undoRecord != undoLog.rend(); ++undoRecord)
+    {
+        storeRow(*undoRecord->table, undoRecord->primaryKey, std::move(undoRecord->previousRow));
+    }
+    undoLog.clear();
+
+    return true;
+}
+
+bool InMemoryStorage::insertIntoDataBase(ModelBase& model)
+{
+    clearPreviousErrors();
+
+    std::lock_guard<std::mutex> guard(storageLock);
+    return reportStatus(insertModel(model));
+}
+
+bool InMemoryStorage::insertManyIntoDataBase(ModelList& models)
+{
+    clearPreviousErrors();
+
+    std::vector<DBStatus> modelStatus;
+    modelStatus.reserve(models.size());
+
+    std::lock_guard<std::mutex> guard(storageLock);
+    for (auto& model: models)
+    {
+        modelStatus.push_back(model? insertModel(*model) : std::unexpected(std::string("NULL model pointer.\n")));
+    }
+
+    return reportModelStatus(modelStatus);
+}
+
+bool InMemoryStorage::updateInDataBase(ModelBase& model)
+{
+    clearPreviousErrors();
+
+    std::lock_guard<std::mutex> guard(storageLock);
+    return reportStatus(updateModel(model));
+}
+
+bool InMemoryStorage::updateManyInDataBase(ModelList& models)
+{
+    clearPreviousErrors();
+
+    std::vector<DBStatus> modelStatus;
+    modelStatus.reserve(models.size());
+
+    std::lock_guard<std::mutex> guard(storageLock);
+    for (auto& model: models)
+    {
+        modelStatus.push_back(model? updateModel(*model) : std::unexpected(std::string("NULL model pointer.\n")));
+    }
+
+    return reportModelStatus(modelStatus);
+}
+
+bool InMemoryStorage::executePipeline(std::vector<PipelineStage>& stages)
+{
+    clearPreviousErrors();
+
+    std::lock_guard<std::mutex> guard(storageLock);
+    for (auto& stage: stages)
+    {
+        if (!stage.model)
+        {
+            stage.status = std::unexpected(std::string("NULL model pointer.\n"));
+            continue;
+        }
+
+        switch (stage.kind)
+        {
+            case PipelineStage::Kind::Insert :
+                stage.status = insertModel(*stage.model);
+                break;
+
+            case PipelineStage::Kind::Update :
+                stage.status = updateModel(*stage.model);
+                break;
+
+            case PipelineStage::Kind::Select :
+                stage.status = selectModel(*stage.model, stage.whereArgs);
+                break;
+        }
+    }
+
+    return reportPipelineStatus(stages);
+}
+
+std::vector<DBStatus> InMemoryStorage::insertOutsideTransaction(ModelList& models)
+{
+    std::vector<DBStatus> modelStatus;
+    modelStatus.reserve(models.size());
+
+    std::lock_guard<std::mutex> guard(storageLock);
+    for (auto& model: models)
+    {
+        modelStatus.push_back(model? insertModel(*model, true) : std::unexpected(std::string("NULL model pointer.\n")));
+    }
+
+    return modelStatus;
+}
+
+std::vector<DBStatus> InMemoryStorage::updateOutsideTransaction(ModelList& models)
+{
+    std::vector<DBStatus> modelStatus;
+    modelStatus.reserve(models.size());
+
+    std::lock_guard<std::mutex> guard(storageLock);
+    for (auto& model: models)
+    {
+        modelStatus.push_back(model? updateModel(*model, true) : std::unexpected(std::string("NULL model pointer.\n")));
+    }
+
+    return modelStatus;
+}
+
+bool InMemoryStorage::getUniqueModelFromDB(ModelShp model, std::vector<WhereArg> whereArgs)
+{
+    clearPreviousErrors();
+
+    if (!model)
+    {
+        std::invalid_argument missingModelPtr("NULL model pointer in InMemoryStorage::getUniqueModelFromDB()!");
+        throw missingModelPtr;
+    }
+
+    std::lock_guard<std::mutex> guard(storageLock);
+    return reportStatus(selectModel(*model, whereArgs));
+}
+
+/*
+ * Every row is already in memory, there is nothing to cache.
+ */
+ModelShp InMemoryStorage::getCachedModelFromDB(ModelShp model, std::vector<WhereArg> whereArgs)
+{
+    return getUniqueModelFromDB(model, whereArgs)? model : nullptr;
+}
+
+bool InMemoryStorage::getUniqueModelsFromDB(ModelList& models, const std::vector<std::string>& keyColumnNames,
+    const std::vector<KeyTuple>& keys)
+{
+    clearPreviousErrors();
+
+    std::vector<DBStatus> modelStatus;
+    modelStatus.reserve(models.size());
+
+    std::lock_guard<std::mutex> guard(storageLock);
+    for (std::size_t modelIndex = 0; modelIndex < models.size(); ++modelIndex)
+    {
+        if (!models[modelIndex] || modelIndex >= keys.size() || keys[modelIndex].size() != keyColumnNames.size())
+        {
+            modelStatus.push_back(std::unexpected(std::string("NULL model pointer or key mismatch.\n")));
+            continue;
+        }
+
+        std::vector<WhereArg> whereArgs;
+        for (std::size_t keyColumn = 0; keyColumn < keyColumnNames.size(); ++keyColumn)
+        {
+            whereArgs.push_back({keyColumnNames[keyColumn], keys[modelIndex][keyColumn]});
+        }
+        modelStatus.push_back(selectModel(*models[modelIndex], whereArgs));
+    }
+
+    return reportModelStatus(modelStatus);
+}
+
+bool InMemoryStorage::getAllUsers(UserBatchCallback onBatch)
+{
+    clearPreviousErrors();
+
+    UserList userBatch;
+
+    return reportStatus(streamModels(UserModel().getTableName(), {},
+        []() { return std::make_shared<UserModel>(); },
+        [&userBatch, &onBatch](ModelList& modelBatch) {
+            userBatch.clear();
+            for (auto& model: modelBatch)
+            {
+                userBatch.push_back(std::static_pointer_cast<UserModel>(model));
+            }
+            onBatch(userBatch);
+        }));
+}
+
+bool InMemoryStorage::getAllTasksForUser(std::size_t userID, TaskBatchCallback onBatch)
+{
+    clearPreviousErrors();
+
+    TaskList taskBatch;
+    std::vector<WhereArg> whereArgs{{"AsignedTo", PTS_DataField(userID)}};
+
+    return reportStatus(streamModels(TaskModel().getTableName(), whereArgs,
+        []() { return std::make_shared<TaskModel>(); },
+        [&taskBatch, &onBatch](ModelList& modelBatch) {
+            taskBatch.clear();
+            for (auto& model: modelBatch)
+            {
+                taskBatch.push_back(std::static_pointer_cast<TaskModel>(model));
+            }
+            onBatch(taskBatch);
+        }));
+}
+
+/*
+ * The whole row is read and the fields outside the projection are then marked not
+ * loaded, as if only the projected columns had been selected.
+ */
+bool InMemoryStorage::getProjectedModelFromDB(ModelShp model, std::vector<WhereArg> whereArgs,
+    FieldProjection projection)
+{
+    clearPreviousErrors();
+
+    if (!model)
+    {
+        std::invalid_argument missingModelPtr("NULL model pointer in InMemoryStorage::getProjectedModelFromDB()!");
+        throw missingModelPtr;
+    }
+
+    std::expected<std::vector<std::size_t>, std::string> loadedSlots = findProjectedSlots(*model, projection);
+    if (!loadedSlots)
+    {
+        appendErrorMessage(loadedSlots.error());
+        return false;
+    }
+
+    std::lock_guard<std::mutex> guard(storageLock);
+    DBStatus found = selectModel(*model, whereArgs);
+    if (found)
+    {
+        model->markNotLoadedExcept(*loadedSlots);
+    }
+
+    return reportStatus(found);
+}
+
+bool InMemoryStorage::getAllUsers(UserBatchCallback onBatch, FieldProjection projection)
+{
+    clearPreviousErrors();
+
+    std::expected<std::vector<std::size_t>, std::string> loadedSlots = findProjectedSlots(UserModel(), projection);
+    if (!loadedSlots)
+    {
+        appendErrorMessage(loadedSlots.error());
+        return false;
+    }
+
+    UserList userBatch;
+
+    return reportStatus(streamModels(UserModel().getTableName(), {},
+        []() { return std::make_shared<UserModel>(); },
+        [&userBatch, &onBatch, &loadedSlots](ModelList& modelBatch) {
+            userBatch.clear();
+            for (auto& model: modelBatch)
+            {
+                model->markNotLoadedExcept(*loadedSlots);
+                userBatch.push_back(std::static_pointer_cast<UserModel>(model));
+            }
+            onBatch(userBatch);
+        }));
+}
+
+DBStatus InMemoryStorage::loadMissingFields(ModelBase& model)
+{
+    if (model.allFieldsLoaded())
+    {
+        return DBStatus{};
+    }
+
+    if (!model.isInDataBase())
+    {
+        return std::unexpected(model.getModelName() + " is not in the database, its missing fields can't be loaded.\n");
+    }
+
+    std::lock_guard<std::mutex> guard(storageLock);
+    std::expected<Table*, std::string> table = findTable(model);
+    if (!table)
+    {
+        return std::unexpected(table.error());
+    }
+
+    auto row = (*table)->rowsByPrimaryKey.find(model.getPrimaryKey());
+    if (row == (*table)->rowsByPrimaryKey.end())
+    {
+        return std::unexpected(model.getModelName() + " is not in the database, its missing fields can't be loaded.\n");
+    }
+
+    for (std::size_t slot = 0; slot < model.getFieldCount(); ++slot)
+    {
+        if (!(model.getLoadedFields() & fieldSlotBit(slot)))
+        {
+            model.loadFieldValueBySlot(slot, row->second[slot]);
+        }
+    }
+
+    return DBStatus{};
+}
+
+/*
+ * There is no ordered index to seek in, the tasks of the user that follow the
+ * cursor are partially sorted to find the page.
+ */
+bool InMemoryStorage::getTaskPageForUser(std::size_t userID, TaskPageOrder order, std::size_t pageSize,
+    const std::string& cursor, TaskPage& page)
+{
+    clearPreviousErrors();
+
+    if (pageSize == 0)
+    {
+        appendErrorMessage("The page size must be at least 1.\n");
+        return false;
+    }
+
+    std::optional<TaskPageCursor> position;
+    if (!cursor.empty())
+    {
+        std::expected<TaskPageCursor, std::string> parsedCursor = parseTaskPageCursor(cursor, order, userID);
+        if (!parsedCursor)
+        {
+            appendErrorMessage(parsedCursor.error());
+            return false;
+        }
+        position = *parsedCursor;
+    }
+
+    std::lock_guard<std::mutex> guard(storageLock);
+    Table& table = tables.at(TaskModel().getTableName());
+    std::vector<WhereArg> whereArgs{{"AsignedTo", PTS_DataField(userID)}};
+    std::expected<std::vector<std::size_t>, std::string> primaryKeys = findPrimaryKeys(table, whereArgs, false);
+    if (!primaryKeys)
+    {
+        appendErrorMessage(primaryKeys.error());
+        return false;
+    }
+
+    using PageKey = std::pair<std::chrono::year_month_day, std::size_t>;
+    std::size_t dueDateSlot = table.slotsByColumnName.at("RequiredDelivery");
+    auto makePageKey = [&table, dueDateSlot, order](std::size_t primaryKey) {
+        const std::chrono::year_month_day* dueDate = (order == TaskPageOrder::RequiredDelivery)?
+            std::get_if<std::chrono::year_month_day>(&table.rowsByPrimaryKey.at(primaryKey)[dueDateSlot]) : nullptr;
+        return PageKey{(dueDate)? *dueDate : std::chrono::year_month_day{}, primaryKey};
+    };
+
+    std::vector<PageKey> pageKeys;
+    for (auto primaryKey: *primaryKeys)
+    {
+        PageKey pageKey = makePageKey(primaryKey);
+        if (!position || pageKey > PageKey{(order == TaskPageOrder::RequiredDelivery)?
+            position->lastDueDate : std::chrono::year_month_day{}, position->lastTaskID})
+        {
+            pageKeys.push_back(pageKey);
+        }
+    }
+
+    std::size_t pageRows = std::min(pageKeys.size(), pageSize);
+    std::partial_sort(pageKeys.begin(), pageKeys.begin() + pageRows, pageKeys.end());
+
+    page.tasks.clear();
+    page.nextCursor.clear();
+    for (std::size_t keyIndex = 0; keyIndex < pageRows; ++keyIndex)
+    {
+        TaskModel_shp task = std::make_shared<TaskModel>();
+        copyRowToModel(table.rowsByPrimaryKey.at(pageKeys[keyIndex].second), *task);
+        page.tasks.push_back(task);
+    }
+
+    if (pageKeys.size() > pageSize)
+    {
+        TaskPageCursor nextPosition{order, userID, pageKeys[pageRows - 1].first, pageKeys[pageRows - 1].second};
+        page.nextCursor = makeTaskPageCursor(nextPosition);
+    }
+
+    return true;
+}
+
+/*
+ * The indexes can't be searched by range, the tasks of the user are filtered by
+ * LastModified.
+ */
+bool InMemoryStorage::getTasksChangedSince(std::size_t userID, const ChangeWatermark& watermark,
+    ChangedTasks& changes)
+{
+    clearPreviousErrors();
+
+    std::lock_guard<std::mutex> guard(storageLock);
+    Table& table = tables.at(TaskModel().getTableName());
+    std::vector<WhereArg> whereArgs{{"AsignedTo", PTS_DataField(userID)}};
+    std::expected<std::vector<std::size_t>, std::string> primaryKeys = findPrimaryKeys(table, whereArgs, false);
+    if (!primaryKeys)
+    {
+        appendErrorMessage(primaryKeys.error());
+        return false;
+    }
+
+    using ChangeKey = std::pair<ChangeStamp, std::size_t>;
+    ChangeStamp windowStart = getChangeWindowStart(watermark);
+    std::size_t lastModifiedSlot = table.slotsByColumnName.at("LastModified");
+    std::vector<ChangeKey> changeKeys;
+    for (auto primaryKey: *primaryKeys)
+    {
+        const ChangeStamp* lastModified = std::get_if<ChangeStamp>(
+            &table.rowsByPrimaryKey.at(primaryKey)[lastModifiedSlot]);
+        if (lastModified && *lastModified >= windowStart)
+        {
+            changeKeys.push_back({*lastModified, primaryKey});
+        }
+    }
+    std::sort(changeKeys.begin(), changeKeys.end());
+
+    TaskList windowTasks;
+    for (const auto& changeKey: changeKeys)
+    {
+        TaskModel_shp task = std::make_shared<TaskModel>();
+        copyRowToModel(table.rowsByPrimaryKey.at(changeKey.second), *task);
+        windowTasks.push_back(task);
+    }
+    changes = skipSeenChanges(watermark, std::move(windowTasks));
+
+    return true;
+}
+
+/*
+ * The tree is walked one level at a time through ParentTask_idx, each level is
+ * sorted by TaskID like the ORDER BY of the MySQL query. A task that was already
+ * visited isn't walked again, so a ParentTask cycle ends.
+ */
+bool InMemoryStorage::getTaskSubtree(std::size_t rootTaskID, std::size_t maxDepth, TaskTreeNodeShp& root)
+{
+    clearPreviousErrors();
+
+    DBStatus validDepth = validateTaskSubtreeDepth(maxDepth);
+    if (!validDepth)
+    {
+        return reportStatus(validDepth);
+    }
+
+    std::lock_guard<std::mutex> guard(storageLock);
+    Table& table = tables.at(TaskModel().getTableName());
+    TaskList tasks;
+    std::unordered_set<std::size_t> visitedKeys;
+    std::vector<std::size_t> levelKeys;
+    if (table.rowsByPrimaryKey.contains(rootTaskID))
+    {
+        levelKeys.push_back(rootTaskID);
+    }
+
+    for (std::size_t depth = 0; !levelKeys.empty(); ++depth)
+    {
+        std::vector<std::size_t> nextLevelKeys;
+        for (auto primaryKey: levelKeys)
+        {
+            if (!visitedKeys.insert(primaryKey).second)
+            {
+                continue;
+            }
+            TaskModel_shp task = std::make_shared<TaskModel>();
+            copyRowToModel(table.rowsByPrimaryKey.at(primaryKey), *task);
+            tasks.push_back(task);
+
+            if (depth == maxDepth)
+            {
+                continue;
+            }
+            std::vector<WhereArg> whereArgs{{"ParentTask", PTS_DataField(primaryKey)}};
+            std::expected<std::vector<std::size_t>, std::string> childKeys = findPrimaryKeys(table, whereArgs, false);
+            if (!childKeys)
+            {
+                appendErrorMessage(childKeys.error());
+                return false;
+            }
+            nextLevelKeys.insert(nextLevelKeys.end(), childKeys->begin(), childKeys->end());
+        }
+        std::sort(nextLevelKeys.begin(), nextLevelKeys.end());
+        levelKeys.swap(nextLevelKeys);
+    }
+
+    std::expected<TaskTreeNodeShp, std::string> subtree = buildTaskTree(rootTaskID, tasks);
+    if (!subtree)
+    {
+        appendErrorMessage(subtree.error());
+        return false;
+    }
+
+    root = std::move(*subtree);
+    return true;
+}
+
+/*
+ * Private methods, storageLock must be held by the caller unless stated otherwise.
+ */
+void InMemoryStorage::addTable(ModelBase& modelPrototype)
+{
+    Table table{modelPrototype.getTableName(), {}, modelPrototype.getFieldCount(), {}, {}, 1};
+
+    for (std::size_t slot = 0; slot < modelPrototype.getFieldCount(); ++slot)
+    {
+        table.slotsByColumnName.insert({modelPrototype.getFieldBySlot(slot).getColumnName(), slot});
+    }
+
+    tables.insert({table.tableName, std::move(table)});
+}
+
+void InMemoryStorage::addIndex(const std::string& tableName, const std::string& indexName,
+    std::vector<std::string> columnNames, bool unique)
+{
+    Table& table = tables.at(tableName);
+    TableIndex index{indexName, {}, unique, {}};
+
+    for (const auto& columnName: columnNames)
+    {
+        index.fieldSlots.push_back(table.slotsByColumnName.at(columnName));
+    }
+
+    table.indexes.push_back(std::move(index));
+}
+
+std::expected<InMemoryStorage::Table*, std::string> InMemoryStorage::findTable(ModelBase& model)
+{
+    auto table = tables.find(model.getTableName());
+    if (table == tables.end())
+    {
+        return std::unexpected(std::format("Table '{}' doesn't exist\n", model.getTableName()));
+    }
+
+    if (table->second.fieldCount != model.getFieldCount())
+    {
+        return std::unexpected(std::format("{} doesn't match the columns of table '{}'\n", model.getModelName(),
+            model.getTableName()));
+    }
+
+    return &table->second;
+}
+
+/*
+ * As in MySQL a NULL in any column of the index never matches another row.
+ */
+std::optional<std::string> InMemoryStorage::makeIndexValue(const TableIndex& index, const Row& row)
+{
+    std::string indexValue;
+
+    for (auto slot: index.fieldSlots)
+    {
+        if (std::holds_alternative<std::monostate>(row[slot]))
+        {
+            return std::nullopt;
+        }
+        if (!indexValue.empty())
+        {
+            indexValue += '\x1f';
+        }
+        indexValue += makeComparisonValue(row[slot]);
+    }
+
+    return indexValue;
+}
+
+DBStatus InMemoryStorage::checkUniqueIndexes(Table& table, const Row& row, std::size_t primaryKey)
+{
+    for (const auto& index: table.indexes)
+    {
+        if (!index.unique)
+        {
+            continue;
+        }
+
+        std::optional<std::string> indexValue = makeIndexValue(index, row);
+        if (!indexValue.has_value())
+        {
+            continue;
+        }
+
+        auto [firstMatch, lastMatch] = index.primaryKeysByValue.equal_range(*indexValue);
+        for (auto match = firstMatch; match != lastMatch; ++match)
+        {
+            if (match->second != primaryKey)
+            {
+                std::string shownValue(*indexValue);
+                std::replace(shownValue.begin(), shownValue.end(), '\x1f', '-');
+                return std::unexpected(std::format("Duplicate entry '{}' for key '{}.{}'\n", shownValue,
+                    table.tableName, index.indexName));
+            }
+        }
+    }
+
+    return DBStatus{};
+}
+
+void InMemoryStorage::addToIndexes(Table& table, const Row& row, std::size_t primaryKey)
+{
+    for (auto& index: table.indexes)
+    {
+        std::optional<std::string> indexValue = makeIndexValue(index, row);
+        if (indexValue.has_value())
+        {
+            index.primaryKeysByValue.insert({std::move(*indexValue), primaryKey});
+        }
+    }
+}
+
+void InMemoryStorage::removeFromIndexes(Table& table, const Row& row, std::size_t primaryKey)
+{
+    for (auto& index: table.indexes)
+    {
+        std::optional<std::string> indexValue = makeIndexValue(index, row);
+        if (!indexValue.has_value())
+        {
+            continue;
+        }
+
+        auto [firstMatch, lastMatch] = index.primaryKeysByValue.equal_range(*indexValue);
+        for (auto match = firstMatch; match != lastMatch; ++match)
+        {
+            if (match->second == primaryKey)
+            {
+                index.primaryKeysByValue.erase(match);
+                break;
+            }
+        }
+    }
+}
+
+/*
+ * Replaces the row stored under primaryKey by newRow, an empty newRow removes the
+ * row. All row changes go through here so the indexes and the undo log stay
+ * consistent.
+ */
+void InMemoryStorage::storeRow(Table& table, std::size_t primaryKey, std::optional<Row> newRow,
+    bool outsideTransaction)
+{
+    auto existingRow = table.rowsByPrimaryKey.find(primaryKey);
+
+    if (transactionActive && !outsideTransaction)
+    {
+        undoLog.push_back({&table, primaryKey, (existingRow != table.rowsByPrimaryKey.end())?
+            std::optional<Row>(existingRow->second) : std::nullopt});
+    }
+
+    if (existingRow != table.rowsByPrimaryKey.end())
+    {
+        removeFromIndexes(table, existingRow->second, primaryKey);
+        if (!newRow.has_value())
+        {
+            table.rowsByPrimaryKey.erase(existingRow);
+            return;
+        }
+    }
+
+    if (newRow.has_value())
+    {
+        addToIndexes(table, *newRow, primaryKey);
+        table.rowsByPrimaryKey.insert_or_assign(primaryKey, std::move(*newRow));
+    }
+}
+
+/*
+ * The generated fields are the LastModified columns, they are stamped the way
+ * DATETIME(6) ON UPDATE CURRENT_TIMESTAMP(6) stamps them.
+ */
+void InMemoryStorage::stampGeneratedFields(const ModelBase& model, Row& row)
+{
+    ChangeStamp now = std::chrono::floor<std::chrono::microseconds>(std::chrono::system_clock::now());
+    forEachSlotIn(model.getGeneratedFields(), [&row, now](std::size_t slot) {
+        row[slot] = now;
+    });
+}
+
+bool InMemoryStorage::isLockedByTransaction(const Table& table, std::size_t primaryKey) const
+{
+    return std::any_of(undoLog.begin(), undoLog.end(), [&table, primaryKey](const UndoRecord& undoRecord) {
+        return undoRecord.table == &table && undoRecord.primaryKey == primaryKey;
+    });
+}
+
+DBStatus InMemoryStorage::insertModel(ModelBase& model, bool outsideTransaction)
+{
+    DBStatus insertable = validateModelForInsert(model);
+    if (!insertable)
+    {
+        return insertable;
+    }
+
+    std::expected<Table*, std::string> table = findTable(model);
+    if (!table)
+    {
+        return std::unexpected(table.error());
+    }
+
+    std::size_t primaryKey = (*table)->nextPrimaryKey;
+    Row row(model.getFieldCount());
+    for (std::size_t slot = 1; slot < row.size(); ++slot)
+    {
+        row[slot] = model.getFieldBySlot(slot).getValue();
+    }
+    row[0] = primaryKey;
+    stampGeneratedFields(model, row);
+
+    DBStatus unique = checkUniqueIndexes(**table, row, primaryKey);
+    if (!unique)
+    {
+        return unique;
+    }
+
+    ++(*table)->nextPrimaryKey;
+    storeRow(**table, primaryKey, std::move(row), outsideTransaction);
+    model.setPrimaryKey(primaryKey);
+    model.clearDirtyBits();
+
+    return DBStatus{};
+}
+
+/*
+ * Only the modified fields are written. Updating a row that doesn't exist is an
+ * error, as it is for DBInterface.
+ */
+DBStatus InMemoryStorage::updateModel(ModelBase& model, bool outsideTransaction)
+{
+    DBStatus updatable = validateModelForUpdate(model);
+    if (!updatable)
+    {
+        return updatable;
+    }
+
+    std::expected<Table*, std::string> table = findTable(model);
+    if (!table)
+    {
+        return std::unexpected(table.error());
+    }
+
+    std::size_t primaryKey = model.getPrimaryKey();
+    auto existingRow = (*table)->rowsByPrimaryKey.find(primaryKey);
+    if (existingRow == (*table)->rowsByPrimaryKey.end())
+    {
+        return reportNoRowUpdated(model);
+    }
+    if (outsideTransaction && isLockedByTransaction(**table, primaryKey))
+    {
+        return std::unexpected(std::format("{} {} is locked by the open transaction.\n", model.getModelName(),
+            primaryKey));
+    }
+
+    FieldMask modifiedFields = model.getModifiedFields() & ~fieldSlotBit(0) & ~model.getGeneratedFields();
+    if (modifiedFields)
+    {
+        Row row(existingRow->second);
+        forEachSlotIn(modifiedFields, [&model, &row](std::size_t slot) {
+            row[slot] = model.getFieldBySlot(slot).getValue();
+        });
+        stampGeneratedFields(model, row);
+
+        DBStatus unique = checkUniqueIndexes(**table, row, primaryKey);
+        if (!unique)
+        {
+            return unique;
+        }
+        storeRow(**table, primaryKey, std::move(row), outsideTransaction);
+    }
+    model.clearDirtyBits();
+
+    return DBStatus{};
+}
+
+DBStatus InMemoryStorage::selectModel(ModelBase& model, const std::vector<WhereArg>& whereArgs)
+{
+    std::expected<Table*, std::string> table = findTable(model);
+    if (!table)
+    {
+        return std::unexpected(table.error());
+    }
+
+    std::expected<std::vector<std::size_t>, std::string> primaryKeys = findPrimaryKeys(**table, whereArgs, true);
+    if (!primaryKeys)
+    {
+        return std::unexpected(primaryKeys.error());
+    }
+
+    if (primaryKeys->empty())
+    {
+        return std::unexpected(std::string("No results from query, object not found in database!"));
+    }
+
+    copyRowToModel((*table)->rowsByPrimaryKey.at(primaryKeys->front()), model);
+
+    return DBStatus{};
+}
+
+/*
+ * Returns the keys of the matching rows in primary key order. A lookup by primary
+ * key or by the exact columns of an index doesn't scan the table.
+ */
+std::expected<std::vector<std::size_t>, std::string> InMemoryStorage::findPrimaryKeys(Table& table,
+    const std::vector<WhereArg>& whereArgs, bool firstOnly)
+{
+    std::vector<std::size_t> primaryKeys;
+    std::vector<std::size_t> whereSlots;
+    Row whereRow(table.fieldCount);
+
+    for (const auto& whereArg: whereArgs)
+    {
+        auto slot = table.slotsByColumnName.find(whereArg.first);
+        if (slot == table.slotsByColumnName.end())
+        {
+            return std::unexpected(std::format("Unknown column '{}' in 'where clause'\n", whereArg.first));
+        }
+        PTS_DataField whereValue = whereArg.second;
+        whereRow[slot->second] = whereValue.getValue();
+        whereSlots.push_back(slot->second);
+        if (std::holds_alternative<std::monostate>(whereRow[slot->second]))
+        {
+            return primaryKeys;
+        }
+    }
+    std::sort(whereSlots.begin(), whereSlots.end());
+
+    if (whereSlots.size() == 1 && whereSlots[0] == 0 && std::holds_alternative<std::size_t>(whereRow[0]))
+    {
+        std::size_t primaryKey = std::get<std::size_t>(whereRow[0]);
+        if (table.rowsByPrimaryKey.contains(primaryKey))
+        {
+            primaryKeys.push_back(primaryKey);
+        }
+        return primaryKeys;
+    }
+
+    for (const auto& index: table.indexes)
+    {
+        std::vector<std::size_t> indexSlots(index.fieldSlots);
+        std::sort(indexSlots.begin(), indexSlots.end());
+        if (whereSlots.empty() || indexSlots != whereSlots)
+        {
+            continue;
+        }
+
+        auto [firstMatch, lastMatch] = index.primaryKeysByValue.equal_range(*makeIndexValue(index, whereRow));
+        for (auto match = firstMatch; match != lastMatch; ++match)
+        {
+            primaryKeys.push_back(match->second);
+        }
+        std::sort(primaryKeys.begin(), primaryKeys.end());
+        if (firstOnly && primaryKeys.size() > 1)
+        {
+            primaryKeys.resize(1);
+        }
+        return primaryKeys;
+    }
+
+    std::vector<std::string> whereValues;
+    for (auto slot: whereSlots)
+    {
+        whereValues.push_back(makeComparisonValue(whereRow[slot]));
+    }
+
+    for (const auto& [primaryKey, row]: table.rowsByPrimaryKey)
+    {
+        bool rowMatches = true;
+        for (std::size_t whereIndex = 0; rowMatches && whereIndex < whereSlots.size(); ++whereIndex)
+        {
+            rowMatches = makeComparisonValue(row[whereSlots[whereIndex]]) == whereValues[whereIndex];
+        }
+
+        if (rowMatches)
+        {
+            primaryKeys.push_back(primaryKey);
+            if (firstOnly)
+            {
+                break;
+            }
+        }
+    }
+
+    return primaryKeys;
+}
+
+void InMemoryStorage::copyRowToModel(const Row& row, ModelBase& model)
+{
+    for (std::size_t slot = 0; slot < row.size(); ++slot)
+    {
+        model.loadFieldValueBySlot(slot, row[slot]);
+    }
+
+    model.clearDirtyBits();
+}
+
+/*
+ * Takes storageLock itself, it is released while onBatch runs so the callback may
+ * use this storage.
+ */
+DBStatus InMemoryStorage::streamModels(const std::string& tableName, const std::vector<WhereArg>& whereArgs,
+    ModelFactory modelFactory, ModelBatchCallback onBatch)
+{
+    std::vector<std::size_t> primaryKeys;
+    Table* table = nullptr;
+
+    {
+        std::lock_guard<std::mutex> guard(storageLock);
+        auto namedTable = tables.find(tableName);
+        if (namedTable == tables.end())
+        {
+            return std::unexpected(std::format("Table '{}' doesn't exist\n", tableName));
+        }
+        table = &namedTable->second;
+
+        std::expected<std::vector<std::size_t>, std::string> foundKeys = findPrimaryKeys(*table, whereArgs, false);
+        if (!foundKeys)
+        {
+            return std::unexpected(foundKeys.error());
+        }
+        primaryKeys = std::move(*foundKeys);
+    }
+
+    ModelList modelBatch;
+    modelBatch.reserve(streamBatchSize);
+    for (std::size_t batchStart = 0; batchStart < primaryKeys.size(); batchStart += streamBatchSize)
+    {
+        std::size_t batchEnd = std::min(batchStart + streamBatchSize, primaryKeys.size());
+        modelBatch.clear();
+
+        {
+            std::lock_guard<std::mutex> guard(storageLock);
+            for (std::size_t keyIndex = batchStart; keyIndex < batchEnd; ++keyIndex)
+            {
+                auto row = table->rowsByPrimaryKey.find(primaryKeys[keyIndex]);
+                if (row != table->rowsByPrimaryKey.end())
+                {
+                    ModelShp model = modelFactory();
+                    copyRowToModel(row->second, *model);
+                    modelBatch.push_back(model);
+                }
+            }
+        }
+
+        if (!modelBatch.empty())
+        {
+            onBatch(modelBatch);
+        }
+    }
+
+    return DBStatus{};
+}
@@ -0,0 +1,120 @@
+#ifndef INMEMORYSTORAGE_H_
+#define INMEMORYSTORAGE_H_
+
+/*
+ * InMemoryStorage:
+ * Keeps the tables of PlannerTaskScheduleDB.sql in memory. Rows are stored by
+ * field slot and keyed by an auto increment primary key, the unique indexes are
+ * enforced the way MySQL enforces them. Strings compare without regard to case
+ * as they do under the database's collation. Nothing is persisted.
+ */
+#include "CommandLineParser.h"
+#include <cstddef>
+#include <expected>
+#include <functional>
+#include <map>
+#include "ModelBase.h"
+#include <mutex>
+#include <optional>
+#include "PTS_DataField.h"
+#include "StorageInterface.h"
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+class InMemoryStorage : public StorageInterface
+{
+public:
+    InMemoryStorage(ProgramOptions& programOptions);
+    virtual ~InMemoryStorage();
+    bool beginTransaction() override;
+    bool commit() override;
+    bool rollback() override;
+    bool insertIntoDataBase(ModelBase& model) override;
+    bool insertManyIntoDataBase(ModelList& models) override;
+    bool updateInDataBase(ModelBase& model) override;
+    bool updateManyInDataBase(ModelList& models) override;
+    bool executePipeline(std::vector<PipelineStage>& stages) override;
+    using StorageInterface::getUniqueModelFromDB;
+    bool getUniqueModelFromDB(ModelShp model, std::vector<WhereArg> whereArgs) override;
+    ModelShp getCachedModelFromDB(ModelShp model, std::vector<WhereArg> whereArgs) override;
+    bool getUniqueModelsFromDB(ModelList& models, const std::vector<std::string>& keyColumnNames,
+        const std::vector<KeyTuple>& keys) override;
+    using StorageInterface::getAllUsers;
+    using StorageInterface::getAllTasksForUser;
+    bool getAllUsers(UserBatchCallback onBatch) override;
+    bool getAllTasksForUser(std::size_t userID, TaskBatchCallback onBatch) override;
+    bool getProjectedModelFromDB(ModelShp model, std::vector<WhereArg> whereArgs, FieldProjection projection) override;
+    bool getAllUsers(UserBatchCallback onBatch, FieldProjection projection) override;
+    DBStatus loadMissingFields(ModelBase& model) override;
+    bool getTaskPageForUser(std::size_t userID, TaskPageOrder order, std::size_t pageSize, const std::string& cursor,
+        TaskPage& page) override;
+    bool getTasksChangedSince(std::size_t userID, const ChangeWatermark& watermark, ChangedTasks& changes) override;
+    bool getTaskSubtree(std::size_t rootTaskID, std::size_t maxDepth, TaskTreeNodeShp& root) override;
+
+private:
+/*
+ * Writes outside the transaction aren't undone by its rollback. A row that the
+ * open transaction has written stays locked until the transaction ends.
+ */
+    std::vector<DBStatus> insertOutsideTransaction(ModelList& models) override;
+    std::vector<DBStatus> updateOutsideTransaction(ModelList& models) override;
+
+    using Row = std::vector<DataValueType>;
+    struct TableIndex
+    {
+        std::string indexName;
+        std::vector<std::size_t> fieldSlots;
+        bool unique;
+        std::unordered_multimap<std::string, std::size_t> primaryKeysByValue;
+    };
+    struct Table
+    {
+        std::string tableName;
+        std::unordered_map<std::string, std::size_t> slotsByColumnName;
+        std::size_t fieldCount;
+        std::map<std::size_t, Row> rowsByPrimaryKey;
+        std::vector<TableIndex> indexes;
+        std::size_t nextPrimaryKey;
+    };
+/*
+ * An open transaction records the previous state of every row it writes, a row
+ * without a previous state was inserted by the transaction.
+ */
+    struct UndoRecord
+    {
+        Table* table;
+        std::size_t primaryKey;
+        std::optional<Row> previousRow;
+    };
+    using ModelFactory = std::function<ModelShp()>;
+    using ModelBatchCallback = std::function<void(ModelList& modelBatch)>;
+
+    void addTable(ModelBase& modelPrototype);
+    void addIndex(const std::string& tableName, const std::string& indexName, std::vector<std::string> columnNames,
+        bool unique);
+    std::expected<Table*, std::string> findTable(ModelBase& model);
+    std::optional<std::string> makeIndexValue(const TableIndex& index, const Row& row);
+    DBStatus checkUniqueIndexes(Table& table, const Row& row, std::size_t primaryKey);
+    void addToIndexes(Table& table, const Row& row, std::size_t primaryKey);
+    void removeFromIndexes(Table& table, const Row& row, std::size_t primaryKey);
+    void storeRow(Table& table, std::size_t primaryKey, std::optional<Row> newRow, bool outsideTransaction=false);
+    void stampGeneratedFields(const ModelBase& model, Row& row);
+    bool isLockedByTransaction(const Table& table, std::size_t primaryKey) const;
+    DBStatus insertModel(ModelBase& model, bool outsideTransaction=false);
+    DBStatus updateModel(ModelBase& model, bool outsideTransaction=false);
+    DBStatus selectModel(ModelBase& model, const std::vector<WhereArg>& whereArgs);
+    std::expected<std::vector<std::size_t>, std::string> findPrimaryKeys(Table& table,
+        const std::vector<WhereArg>& whereArgs, bool firstOnly);
+    void copyRowToModel(const Row& row, ModelBase& model);
+    DBStatus streamModels(const std::string& tableName, const std::vector<WhereArg>& whereArgs,
+        ModelFactory modelFactory, ModelBatchCallback onBatch);
+
+    std::size_t streamBatchSize;
+    std::mutex storageLock;
+    std::unordered_map<std::string, Table> tables;
+    bool transactionActive;
+    std::vector<UndoRecord> undoLog;
+};
+
+#endif  // INMEMORYSTORAGE_H_
@@ -3,21 +3,29 @@
 #include <iostream>
 #include <memory>
 #include "ModelBase.h"
+#include "ModelSchema.h"
+#include <optional>
 #include "PTS_DataField.h"
+#include <stdexcept>
 #include <string>
-#include <unordered_map>
+#include <string_view>
+#include <utility>
 #include <vector>
 
 
-ModelBase::ModelBase(const std::string modelName, const std::string tabName, std::string primaryKeyName, std::size_t primaryKeyIn)
-: modelClassName{modelName}, tableName{tabName}, primaryKeyFieldName{primaryKeyName}
+ModelBase::ModelBase(const ModelSchema& modelSchema, std::size_t primaryKeyIn)
+: schema{&modelSchema}, modifiedFields{0}, fieldsWithValue{0}, loadedFields{modelSchema.getAllFieldsMask()}
 {
-    PTS_DataField_shp primaryKey = std::make_shared<PTS_DataField>(PTS_DataField(PTS_DataField::PTS_DB_FieldType::Key, primaryKeyName, true));
+    fields.reserve(schema->getFieldCount());
+    for (std::size_t slot = 0; slot < schema->getFieldCount(); ++slot)
+    {
+        fields.emplace_back(schema->getField(slot));
+    }
+
     if (primaryKeyIn)
     {
-        primaryKey->setValue(primaryKeyIn);
+        setFieldValueBySlot(0, primaryKeyIn);
     }
-    dataFields.insert({primaryKeyName, primaryKey});
 }
 
 std::string ModelBase::dateToString(std::chrono::year_month_day taskDate)
@@ -60,55 +68,30 @@ std::chrono::year_month_day ModelBase::stringToDate(std::string dateString)
     return dateValue;
 }
 
-void ModelBase::addDataField(const std::string& fieldName, PTS_DataField::PTS_DB_FieldType fieldType, bool required)
-{
-    PTS_DataField_shp dataField = std::make_shared<PTS_DataField>(PTS_DataField(fieldType, fieldName, required));
-    dataFields.insert({fieldName, dataField});
-}
-
 bool ModelBase::isInDataBase() const
 {
-    PTS_DataField_shp pkField = findFieldInDataFields(primaryKeyFieldName);
-    return pkField? pkField->hasValue() : false;
+    return fieldsWithValue & fieldSlotBit(0);
 }
 
-void ModelBase::onInsertionClearDirtyBits()
+bool ModelBase::setFieldValue(std::string_view fieldName, DataValueType dataValue)
 {
-    for (const auto& [key, value] : dataFields)
-    {
-        value->clearDirtyBit();
-    }
-}
-
-bool ModelBase::setFieldValue(const std::string& fieldName, DataValueType dataValue)
-{
-    PTS_DataField_shp fieldToUpdate = findFieldInDataFields(fieldName);
-    if (fieldToUpdate)
-    {
-        fieldToUpdate->setValue(dataValue);
-        return true;
-    }
-
-    return false;
+    setFieldValueBySlot(getExistingFieldSlot(fieldName), std::move(dataValue));
+    return true;
 }
 
 /*
  * Does not set the modified flag.
  */
-void ModelBase::initFieldValueNotChanged(const std::string &fieldName, DataValueType dataValue)
+void ModelBase::initFieldValueNotChanged(std::string_view fieldName, DataValueType dataValue)
 {
-    PTS_DataField_shp fieldToUpdate = findFieldInDataFields(fieldName);
-    if (fieldToUpdate)
-    {
-        fieldToUpdate->dbSetValue(dataValue);
-    }
+    loadFieldValueBySlot(getExistingFieldSlot(fieldName), std::move(dataValue));
 }
 
-std::string ModelBase::getFieldValueString(const std::string& fieldName)
+std::string ModelBase::getFieldValueString(std::string_view fieldName)
 {
     std::string valueString("No Value Set");
 
-    PTS_DataField_shp fieldToFind = findFieldInDataFields(fieldName);
+    const PTS_DataField* fieldToFind = findLoadedField(fieldName);
     if (fieldToFind)
     {
         valueString = fieldToFind->toString();
@@ -117,11 +100,11 @@ std::string ModelBase::getFieldValueString(const std::string& fieldName)
     return valueString;
 }
 
-DataValueType ModelBase::getFieldValue(const std::string& fieldName) const
+DataValueType ModelBase::getFieldValue(std::string_view fieldName) const
 {
     DataValueType dataValue;
 
-    PTS_DataField_shp fieldToFind = findFieldInDataFields(fieldName);
+    const PTS_DataField* fieldToFind = findLoadedField(fieldName);
     if (fieldToFind)
     {
         if (fieldToFind->hasValue())
@@ -133,9 +116,9 @@ DataValueType ModelBase::getFieldValue(const std::string& fieldName) const
     return dataValue;
 }
 
-bool ModelBase::fieldHasValue(const std::string& fieldName) const
+bool ModelBase::fieldHasValue(std::string_view fieldName) const
 {
-    PTS_DataField_shp fieldToFind = findFieldInDataFields(fieldName);
+    const PTS_DataField* fieldToFind = findLoadedField(fieldName);
     if (fieldToFind)
     {
         return fieldToFind->hasValue();
@@ -144,92 +127,85 @@ bool ModelBase::fieldHasValue(const std::string& fieldName) const
     return false;
 }
 
-bool ModelBase::fieldWasModified(const std::string &fieldName) const
+bool ModelBase::fieldWasModified(std::string_view fieldName) const
 {
-    PTS_DataField_shp fieldToFind = findFieldInDataFields(fieldName);
-    if (fieldToFind)
-    {
-        return fieldToFind->wasModified();
-    }
-
-    return false;
+    return modifiedFields & fieldSlotBit(getExistingFieldSlot(fieldName));
 }
 
-void ModelBase::setPrimaryKey(std::size_t keyValue)
+/*
+ * The primary key is always loaded, it identifies the row the other fields are
+ * loaded from.
+ */
+void ModelBase::markNotLoadedExcept(const std::vector<std::size_t>& loadedSlots)
 {
-    initFieldValueNotChanged(primaryKeyFieldName, keyValue);
+    FieldMask keepLoaded = fieldSlotBit(0);
+    for (std::size_t slot: loadedSlots)
+    {
+        keepLoaded |= fieldSlotBit(slot);
+    }
+
+    FieldMask notLoaded = schema->getAllFieldsMask() & ~keepLoaded;
+    forEachSlotIn(notLoaded, [this](std::size_t slot) { fields[slot].clearValue(); });
+    loadedFields &= ~notLoaded;
+    fieldsWithValue &= ~notLoaded;
+    modifiedFields &= ~notLoaded;
 }
 
-std::size_t ModelBase::getPrimaryKey() const
+/*
+ * Returned in slot order.
+ */
+std::vector<std::string> ModelBase::getNotLoadedFieldNames() const
 {
-    std::size_t primaryKey = 0;
+    std::vector<std::string> fieldNames;
 
-    PTS_DataField_shp  primaryKeyField = findFieldInDataFields(primaryKeyFieldName);
-    if (primaryKeyField)
-    {
-        if (primaryKeyField->hasValue())
-        {
-            DataValueType dataValue = primaryKeyField->getValue();
-            primaryKey = std::get<std::size_t>(dataValue);
-        }
-    }
+    forEachSlotIn(schema->getAllFieldsMask() & ~loadedFields, [this, &fieldNames](std::size_t slot) {
+        fieldNames.push_back(fields[slot].getColumnName());
+    });
 
-    return primaryKey;
+    return fieldNames;
 }
 
-bool ModelBase::atleastOneFieldModified() const
+const PTS_DataField* ModelBase::findLoadedField(std::string_view fieldName) const
 {
-    for (const auto& [key, value] : dataFields)
-    {
-        if (value->wasModified())
-        {
-            return true;
-        }
-    }
+    return &getLoadedFieldBySlot(getExistingFieldSlot(fieldName));
+}
 
-    return false;
+void ModelBase::throwFieldNotLoaded(std::size_t slot) const
+{
+    throw std::logic_error(getModelName() + " field " + fields[slot].getColumnName() +
+        " is not loaded, load the missing fields first.");
 }
 
-bool ModelBase::allRequiredFieldsHaveData() const
+void ModelBase::setPrimaryKey(std::size_t keyValue)
 {
-    for (const auto& [key, value] : dataFields)
-    {
-        /*
-         * If this is a new object that hasn't been entered into the database yet
-         * then the primary key won't have a value. Whether to insert a new record
-         * or update an existing record is determined in the database interface. 
-         */
-        if (value->isRequired() && key != primaryKeyFieldName)
-        {
-            if (!value->hasValue())
-            {
-                return false;
-            }
-        }
-    }
+    loadFieldValueBySlot(0, keyValue);
+}
 
-    return true;
+std::size_t ModelBase::getPrimaryKey() const
+{
+    return fields[0].getKeyValue();
 }
 
 std::string ModelBase::reportMissingRequiredFields() const
 {
     std::string agregateErrorMessage;
 
-    for (const auto& [key, value] : dataFields)
-    {
-        if (value->isRequired() && key != primaryKeyFieldName)
-        {
-            if (!value->hasValue())
-            {
-                agregateErrorMessage += "The required field " + value->getColumnName() +
-                    " has not been set!\n";
-            }
-        }
-    }
+    forEachSlotIn(getMissingRequiredFields(), [this, &agregateErrorMessage](std::size_t slot) {
+        agregateErrorMessage += "The required field " + fields[slot].getColumnName() + " has not been set!\n";
+    });
 
     return agregateErrorMessage;
 }
 
+std::string ModelBase::getFieldInfo(std::size_t slot) const
+{
+    std::string info(fields[slot].fieldInfo());
+    info += "\tModified: ";
+    info += (modifiedFields & fieldSlotBit(slot))? "True" : "False";
+
+    return info;
+}
+
 /*
  * Protected methods.
  */
@@ -246,51 +222,99 @@ std::chrono::year_month_day ModelBase::getTodaysDate()
     return std::chrono::floor<std::chrono::days>(today);
 }
 
-PTS_DataField_shp ModelBase::findFieldInDataFields(const std::string &fieldName) const
+PTS_DataField* ModelBase::findFieldInDataFields(std::string_view fieldName)
 {
-    auto fieldToFind = dataFields.find(fieldName);
-    if (fieldToFind != dataFields.end())
-    {
-        return fieldToFind->second;
-    }
-    else
+    return &fields[getExistingFieldSlot(fieldName)];
+}
+
+const PTS_DataField* ModelBase::findFieldInDataFields(std::string_view fieldName) const
+{
+    return &fields[getExistingFieldSlot(fieldName)];
+}
+
+std::size_t ModelBase::getExistingFieldSlot(std::string_view fieldName) const
+{
+    std::optional<std::size_t> fieldSlot = schema->findFieldSlot(fieldName);
+    if (!fieldSlot.has_value())
     {
-        std::string eMessage("Interal Error in " + modelClassName + ": ");
-        eMessage += "Field not found in dataFields: " + fieldName;
+        std::string eMessage("Interal Error in " + getModelName() + ": ");
+        eMessage += "Field not found in schema: " + std::string(fieldName);
         std::out_of_range oor(eMessage);
         throw oor;
     }
 
-    return nullptr;
+    return *fieldSlot;
+}
+
+/*
+ * Returned in slot order.
+ */
+PTS_DataField_vector ModelBase::getAllFieldsWithValue() const
+{
+    PTS_DataField_vector valueFields;
+
+    forEachSlotIn(fieldsWithValue, [this, &valueFields](std::size_t slot) { valueFields.push_back(&fields[slot]); });
+
+    return valueFields;
 }
 
-PTS_DataField_vector ModelBase::getAllFieldsWithValue()
+/*
+ * Returned in slot order so the same set of modified fields always produces the
+ * same column list. The primary key is never included, it identifies the row.
+ */
+PTS_DataField_vector ModelBase::getAllModifiedFields() const
 {
-    std::vector<PTS_DataField_shp> fields;
+    PTS_DataField_vector changedFields;
+
+    forEachSlotIn(modifiedFields & ~fieldSlotBit(0), [this, &changedFields](std::size_t slot) {
+        changedFields.push_back(&fields[slot]);
+    });
 
-    for (const auto& [key, value] : dataFields)
+    return changedFields;
+}
+
+/*
+ * Both models must be of the same class so that the slots match. The copy is a
+ * read of the stored row, so no field of this model is left modified even if
+ * other has unsaved changes.
+ */
+bool ModelBase::copyFieldValuesFrom(const ModelBase& other)
+{
+    if (schema != other.schema)
     {
-        PTS_DataField_shp currentField = value;
-        if (currentField->hasValue())
-        {
-            fields.push_back(currentField);
-        }
+        return false;
     }
 
-    return fields;
+    fields = other.fields;
+    modifiedFields = 0;
+    fieldsWithValue = other.fieldsWithValue;
+    loadedFields = other.loadedFields;
+
+    return true;
 }
 
-bool ModelBase::diffAllFields(ModelBase other)
+/*
+ * The generated fields are set by the database, a model that was written has the
+ * value it was read with, so they aren't compared.
+ */
+bool ModelBase::diffAllFields(const ModelBase& other) const
 {
+    if (schema != other.schema)
+    {
+        std::clog << "Models differ: " << getModelName() << " " << other.getModelName() << "\n";
+        return false;
+    }
+
     bool areTheSame = true;
 
-    for (const auto& [key, value] : dataFields)
+    for (std::size_t slot = 0; slot < fields.size(); ++slot)
     {
-        const PTS_DataField_shp otherValue = other.findFieldInDataFields(key);
-        if (*value != *otherValue)
+        const PTS_DataField& otherValue = other.fields[slot];
+        if (!(getGeneratedFields() & fieldSlotBit(slot)) && fields[slot] != otherValue)
         {
             areTheSame = false;
-            std::clog << "Fields differ: " << key << "\n\t" << *value << "\n\t" << *otherValue << "\n";
+            std::clog << "Fields differ: " << fields[slot].getColumnName() << "\n\t" << fields[slot] << "\n\t" <<
+                otherValue << "\n";
         }
     }
 
@@ -4,113 +4,222 @@
 #include <chrono>
 #include <iostream>
 #include <memory>
+#include "ModelSchema.h"
+#include <optional>
 #include "PTS_DataField.h"
 #include <string>
-#include <unordered_map>
+#include <string_view>
+#include <type_traits>
+#include <utility>
 #include <vector>
 
-using PTS_DataField_shp = std::shared_ptr<PTS_DataField>;
-using PTS_DataField_vector = std::vector<PTS_DataField_shp>;
-using PTS_DataField_map = std::unordered_map<std::string, PTS_DataField_shp>;
+using PTS_DataField_vector = std::vector<const PTS_DataField*>;
 
+/*
+ * The columns of a model are described once per class by its ModelSchema, an
+ * instance only holds one PTS_DataField per slot in a single array. Which fields
+ * were modified, have a value or are loaded is kept in one FieldMask each, so
+ * checking or clearing them for the whole model is a single word operation.
+ */
 class ModelBase
 {
 public:
-    ModelBase(const std::string modelName, const std::string tabName, const std::string primaryKeyName, std::size_t primaryKeyIn=0);
+    ModelBase(const ModelSchema& modelSchema, std::size_t primaryKeyIn=0);
     virtual ~ModelBase() = default;
     std::string dateToString(std::chrono::year_month_day taskDate);
     std::chrono::year_month_day stringToDate(std::string dateString);
     bool isInDataBase() const;
-    std::string getTableName() const { return tableName; };
-    void onInsertionClearDirtyBits();
+    const std::string& getTableName() const { return schema->getTableName(); };
+    const std::string& getPrimaryKeyName() const { return schema->getPrimaryKeyName(); };
+    void clearDirtyBits() { modifiedFields = 0; };
     
 /*
  * Field access methods. 
  */
-    PTS_DataField_shp findFieldInDataFields(const std::string& fieldName) const;
+    PTS_DataField* findFieldInDataFields(std::string_view fieldName);
+    const PTS_DataField* findFieldInDataFields(std::string_view fieldName) const;
     void setPrimaryKey(std::size_t keyValue);
     std::size_t getPrimaryKey() const;
-    void addDataField(const std::string& fieldName, PTS_DataField::PTS_DB_FieldType fieldType, bool required=false);
-    bool setFieldValue(const std::string& fieldName, DataValueType dataValue);
-    void initFieldValueNotChanged(const std::string& fieldName, DataValueType dataValue);
-    std::string getFieldValueString(const std::string& fieldName);
-    DataValueType getFieldValue(const std::string& fieldName) const;
-    bool fieldHasValue(const std::string& fieldName) const;
-    bool fieldWasModified(const std::string& fieldName) const;
-    int getIntFieldValue(const std::string& fieldName) const {
-        PTS_DataField_shp fieldToFind = findFieldInDataFields(fieldName);
+/*
+ * Fields are numbered by their slot in the schema, the primary key is slot 0.
+ * Every instance of a model class has the same slots, so a slot found once can be
+ * used for all instances of that class.
+ */
+    std::size_t getFieldCount() const { return fields.size(); };
+    std::optional<std::size_t> findFieldSlot(std::string_view fieldName) const
+    {
+        return schema->findFieldSlot(fieldName);
+    };
+    const PTS_DataField& getFieldBySlot(std::size_t slot) const { return fields[slot]; };
+/*
+ * Setting a field marks it modified, loading it marks it as matching the stored
+ * column. markFieldLoaded() does the same without changing the value.
+ */
+    void setFieldValueBySlot(std::size_t slot, DataValueType dataValue)
+    {
+        storeFieldValue(slot, PTS_ValueCell(dataValue));
+        modifiedFields |= fieldSlotBit(slot);
+    }
+    void loadFieldValueBySlot(std::size_t slot, DataValueType dataValue)
+    {
+        storeFieldValue(slot, PTS_ValueCell(dataValue));
+        modifiedFields &= ~fieldSlotBit(slot);
+    }
+    void markFieldLoaded(std::size_t slot)
+    {
+        loadedFields |= fieldSlotBit(slot);
+        modifiedFields &= ~fieldSlotBit(slot);
+    }
+    FieldMask getModifiedFields() const { return modifiedFields; };
+    FieldMask getFieldsWithValue() const { return fieldsWithValue; };
+    FieldMask getLoadedFields() const { return loadedFields; };
+    FieldMask getGeneratedFields() const { return schema->getGeneratedFieldsMask(); };
+/*
+ * Field is a FieldTag of the model class, its slot and value type are known at
+ * compile time so these don't look the field up by name. A field without a value
+ * of the tag's type reads as the default value.
+ */
+    template<typename Field>
+    typename Field::ValueType get() const
+    {
+        return getLoadedFieldBySlot(Field::slot).getValueOr(typename Field::ValueType{});
+    }
+/*
+ * A string field is set from a view, the field copies the characters once without
+ * building a DataValueType first.
+ */
+    template<typename Field>
+    using FieldArgument = std::conditional_t<std::is_same_v<typename Field::ValueType, std::string>, std::string_view,
+        typename Field::ValueType>;
+    template<typename Field>
+    void set(FieldArgument<Field> value)
+    {
+        storeFieldValue(Field::slot, PTS_ValueCell(value));
+        modifiedFields |= fieldSlotBit(Field::slot);
+    }
+    template<typename Field>
+    void initNotChanged(FieldArgument<Field> value)
+    {
+        storeFieldValue(Field::slot, PTS_ValueCell(value));
+        modifiedFields &= ~fieldSlotBit(Field::slot);
+    }
+/*
+ * A view of a string field, valid until the field is changed or the model is
+ * destroyed. Reading it doesn't copy the string.
+ */
+    template<typename Field>
+    std::string_view getView() const
+    {
+        static_assert(std::is_same_v<typename Field::ValueType, std::string>, "Only string fields have views");
+        return getLoadedFieldBySlot(Field::slot).getStringView();
+    }
+    template<typename Field>
+    bool has() const { return getLoadedFieldBySlot(Field::slot).hasValue(); }
+    bool setFieldValue(std::string_view fieldName, DataValueType dataValue);
+    void initFieldValueNotChanged(std::string_view fieldName, DataValueType dataValue);
+    std::string getFieldValueString(std::string_view fieldName);
+    DataValueType getFieldValue(std::string_view fieldName) const;
+    bool fieldHasValue(std::string_view fieldName) const;
+    bool fieldWasModified(std::string_view fieldName) const;
+/*
+ * A projected read only loads some of the fields, the others are marked not
+ * loaded. Reading a field that is not loaded throws std::logic_error, the storage's
+ * loadMissingFields() loads them. Setting a field also loads it.
+ */
+    void markNotLoadedExcept(const std::vector<std::size_t>& loadedSlots);
+    bool allFieldsLoaded() const { return loadedFields == schema->getAllFieldsMask(); };
+    std::vector<std::string> getNotLoadedFieldNames() const;
+    const PTS_DataField* findLoadedField(std::string_view fieldName) const;
+    const PTS_DataField& getLoadedFieldBySlot(std::size_t slot) const
+    {
+        if (!(loadedFields & fieldSlotBit(slot)))
+        {
+            throwFieldNotLoaded(slot);
+        }
+        return fields[slot];
+    };
+    int getIntFieldValue(std::string_view fieldName) const {
+        const PTS_DataField* fieldToFind = findLoadedField(fieldName);
         return fieldToFind? fieldToFind->getIntValue() : 0;
     };
-    std::size_t getSize_tFieldValue(const std::string& fieldName) const
+    std::size_t getSize_tFieldValue(std::string_view fieldName) const
     {
-        PTS_DataField_shp fieldToFind = findFieldInDataFields(fieldName);
+        const PTS_DataField* fieldToFind = findLoadedField(fieldName);
         return fieldToFind? fieldToFind->getSize_tValue() : 0;
     };
-    std::size_t getKeyFieldValue(const std::string& fieldName) const { return getSize_tFieldValue(fieldName); };
-    double getDoubleFieldValue(const std::string& fieldName) const
+    std::size_t getKeyFieldValue(std::string_view fieldName) const { return getSize_tFieldValue(fieldName); };
+    double getDoubleFieldValue(std::string_view fieldName) const
     {
-        PTS_DataField_shp fieldToFind = findFieldInDataFields(fieldName);
+        const PTS_DataField* fieldToFind = findLoadedField(fieldName);
         return fieldToFind ? fieldToFind->getDoubleValue() : 0.0;
     };
-    float getFloatFieldValue(const std::string& fieldName) const
+    float getFloatFieldValue(std::string_view fieldName) const
     {
-        PTS_DataField_shp fieldToFind = findFieldInDataFields(fieldName);
+        const PTS_DataField* fieldToFind = findLoadedField(fieldName);
         return fieldToFind ? fieldToFind->getFloatValue() : 0.0;
     };
-    std::chrono::year_month_day getDateFieldValue(const std::string& fieldName) const
+    std::chrono::year_month_day getDateFieldValue(std::string_view fieldName) const
     {
         std::chrono::year_month_day badDate;
-        PTS_DataField_shp fieldToFind = findFieldInDataFields(fieldName);
+        const PTS_DataField* fieldToFind = findLoadedField(fieldName);
         return fieldToFind ? fieldToFind->getDateValue() : badDate;
     };
-    std::chrono::time_point<std::chrono::system_clock> getTimeFieldValue(const std::string& fieldName) const
+    std::chrono::time_point<std::chrono::system_clock> getTimeFieldValue(std::string_view fieldName) const
     {
         std::chrono::time_point<std::chrono::system_clock> badTime;
-        PTS_DataField_shp fieldToFind = findFieldInDataFields(fieldName);
+        const PTS_DataField* fieldToFind = findLoadedField(fieldName);
         return fieldToFind ? fieldToFind->getTimeValue() : badTime;
     };
-    std::string getStringFieldValue(const std::string& fieldName) const
+    std::string getStringFieldValue(std::string_view fieldName) const
     {
-        PTS_DataField_shp fieldToFind = findFieldInDataFields(fieldName);
+        const PTS_DataField* fieldToFind = findLoadedField(fieldName);
         return fieldToFind ? fieldToFind->getStringValue() : "";
     };
-    bool getBoolFieldValue(const std::string& fieldName) const
+    std::string_view getStringFieldView(std::string_view fieldName) const
     {
-        PTS_DataField_shp fieldToFind = findFieldInDataFields(fieldName);
+        const PTS_DataField* fieldToFind = findLoadedField(fieldName);
+        return fieldToFind ? fieldToFind->getStringView() : std::string_view();
+    };
+    bool getBoolFieldValue(std::string_view fieldName) const
+    {
+        const PTS_DataField* fieldToFind = findLoadedField(fieldName);
         return fieldToFind ? fieldToFind->getBoolValue() : false;
     };
-    unsigned int getUnsignedIntFieldValue(const std::string& fieldName) const
+    unsigned int getUnsignedIntFieldValue(std::string_view fieldName) const
     {
-        PTS_DataField_shp fieldToFind = findFieldInDataFields(fieldName);
+        const PTS_DataField* fieldToFind = findLoadedField(fieldName);
         return fieldToFind ? fieldToFind->getUnsignedIntValue() : 0;
     }
 /*
  * Object / Class access methods. 
  */
-    bool atleastOneFieldModified() const;
-    bool allRequiredFieldsHaveData() const;
-    bool diffAllFields(ModelBase other);
-    PTS_DataField_vector getAllFieldsWithValue();
+    bool atleastOneFieldModified() const { return modifiedFields != 0; };
+    bool allRequiredFieldsHaveData() const { return getMissingRequiredFields() == 0; };
+    bool diffAllFields(const ModelBase& other) const;
+    PTS_DataField_vector getAllFieldsWithValue() const;
+    PTS_DataField_vector getAllModifiedFields() const;
+    bool copyFieldValuesFrom(const ModelBase& other);
     std::string reportMissingRequiredFields() const;
-    const std::string getModelName() { return modelClassName; };
+    std::string getFieldInfo(std::size_t slot) const;
+    const std::string& getModelName() const { return schema->getModelName(); };
 
 /*
  * Operators
  */
-    bool operator==(ModelBase other)
+    bool operator==(const ModelBase& other) const
     {
         bool areTheSame = true;
 
-        if (modelClassName != other.modelClassName)
+        if (getModelName() != other.getModelName())
         {
             areTheSame = false;
-            std::clog << "Model names differ: " << modelClassName << " " << other.modelClassName << "\n";
+            std::clog << "Model names differ: " << getModelName() << " " << other.getModelName() << "\n";
         }
 
-        if (primaryKeyFieldName != other.primaryKeyFieldName)
+        if (getPrimaryKeyName() != other.getPrimaryKeyName())
         {
             areTheSame = false;
-            std::clog << "Primary key names differ: " << primaryKeyFieldName << " " << other.primaryKeyFieldName << "\n";
+            std::clog << "Primary key names differ: " << getPrimaryKeyName() << " " << other.getPrimaryKeyName() << "\n";
         }
 
         // using == of dataFields doesn't seem to reflect the realality.
@@ -120,21 +229,20 @@ public:
     };
     friend std::ostream& operator<<(std::ostream& os, const ModelBase& obj)
     {
-        os << "Model Class:\t" << obj.modelClassName << "\n";
-        os << "Primary Key field name :" << obj.primaryKeyFieldName << "\n";
+        os << "Model Class:\t" << obj.getModelName() << "\n";
+        os << "Primary Key field name :" << obj.getPrimaryKeyName() << "\n";
         
         os << "Column Names: ";
-        for (const auto& [key, value] : obj.dataFields)
+        for (const auto& field : obj.fields)
         {
-            os << key;
+            os << field.getColumnName();
             os << ", ";
         }
         os << "\n";
 
-        for (const auto& [key, value] : obj.dataFields)
+        for (std::size_t slot = 0; slot < obj.fields.size(); ++slot)
         {
-            PTS_DataField_shp currentField = value;
-            os << currentField;
+            os << obj.getFieldInfo(slot);
             os << "\n";
         }
         return os;
@@ -143,11 +251,35 @@ public:
 protected:
     std::string createDateString(int month, int day, int year);
     std::chrono::year_month_day getTodaysDate();
+    std::size_t getExistingFieldSlot(std::string_view fieldName) const;
+    [[noreturn]] void throwFieldNotLoaded(std::size_t slot) const;
+    void storeFieldValue(std::size_t slot, PTS_ValueCell value)
+    {
+        fields[slot].setValueCell(std::move(value));
+        loadedFields |= fieldSlotBit(slot);
+        if (fields[slot].hasValue())
+        {
+            fieldsWithValue |= fieldSlotBit(slot);
+        }
+        else
+        {
+            fieldsWithValue &= ~fieldSlotBit(slot);
+        }
+    }
+/*
+ * The primary key isn't required to have a value, a new model gets its key when
+ * it is inserted.
+ */
+    FieldMask getMissingRequiredFields() const
+    {
+        return schema->getRequiredFieldsMask() & ~fieldSlotBit(0) & ~fieldsWithValue;
+    }
 
-    const std::string modelClassName;
-    const std::string tableName;
-    const std::string primaryKeyFieldName;
-    PTS_DataField_map dataFields;
+    const ModelSchema* schema;
+    std::vector<PTS_DataField> fields;
+    FieldMask modifiedFields;
+    FieldMask fieldsWithValue;
+    FieldMask loadedFields;
 };
 
 using ModelShp = std::shared_ptr<ModelBase>;
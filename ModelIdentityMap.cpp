@@ -0,0 +1,249 @@
+#include <cstddef>
+#include <list>
+#include <memory>
+#include "ModelBase.h"
+#include "ModelIdentityMap.h"
+#include <mutex>
+#include <optional>
+#include "PTS_DataField.h"
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+ModelIdentityMap::ModelIdentityMap(std::size_t maxModels)
+: capacity{maxModels}, hits{0}, misses{0}, evictions{0}
+{
+}
+
+void ModelIdentityMap::addUniqueIndex(const std::string& tableName, std::vector<std::string> columnNames)
+{
+    std::lock_guard<std::mutex> guard(cacheLock);
+    uniqueIndexes[tableName].push_back(std::move(columnNames));
+}
+
+/*
+ * Only whereArgs that name exactly the primary key or exactly the columns of a
+ * unique index can identify a single row, any other query is not looked up.
+ */
+bool ModelIdentityMap::find(ModelBase& model, const std::vector<WhereArg>& whereArgs)
+{
+    if (!isEnabled())
+    {
+        return false;
+    }
+
+    std::optional<std::string> lookupKey = makeLookupKey(model, whereArgs);
+    if (!lookupKey.has_value())
+    {
+        return false;
+    }
+
+    std::lock_guard<std::mutex> guard(cacheLock);
+    auto cachedEntry = modelsByKey.find(*lookupKey);
+    if (cachedEntry == modelsByKey.end() || !model.copyFieldValuesFrom(*cachedEntry->second->model))
+    {
+        ++misses;
+        return false;
+    }
+
+    ++hits;
+    modelsByUse.splice(modelsByUse.begin(), modelsByUse, cachedEntry->second);
+    return true;
+}
+
+/*
+ * The copy is a ModelBase, it only holds the field values and is only copied into
+ * models of the same schema. Any other copy cached for the row or for one of its
+ * unique index values is dropped.
+ */
+void ModelIdentityMap::store(const ModelBase& model)
+{
+    if (!isEnabled() || !model.isInDataBase() || !model.allFieldsLoaded())
+    {
+        return;
+    }
+
+    ModelShp cachedModel = std::make_shared<ModelBase>(model);
+    cachedModel->clearDirtyBits();
+
+    std::lock_guard<std::mutex> guard(cacheLock);
+    storeLocked(cachedModel);
+}
+
+std::string ModelIdentityMap::getRowKey(const ModelBase& model)
+{
+    return makeKey(model.getTableName(), {model.getFieldBySlot(0).getColumnName()}, {model.getFieldBySlot(0).toString()});
+}
+
+void ModelIdentityMap::eraseRow(const std::string& rowKey)
+{
+    if (!isEnabled())
+    {
+        return;
+    }
+
+    std::lock_guard<std::mutex> guard(cacheLock);
+    auto keyEntry = modelsByKey.find(rowKey);
+    if (keyEntry == modelsByKey.end())
+    {
+        return;
+    }
+
+    LRUList::iterator cachedEntry = keyEntry->second;
+    for (const auto& entryKey: cachedEntry->keys)
+    {
+        modelsByKey.erase(entryKey);
+    }
+    modelsByUse.erase(cachedEntry);
+}
+
+ModelCacheStatistics ModelIdentityMap::getStatistics() const
+{
+    std::lock_guard<std::mutex> guard(cacheLock);
+    return {hits, misses, evictions, modelsByUse.size()};
+}
+
+std::optional<std::string> ModelIdentityMap::makeLookupKey(ModelBase& modelPrototype,
+    const std::vector<WhereArg>& whereArgs)
+{
+    std::string tableName = modelPrototype.getTableName();
+    std::string primaryKeyName = modelPrototype.getFieldBySlot(0).getColumnName();
+
+    if (whereArgs.size() == 1 && whereArgs[0].first == primaryKeyName)
+    {
+        PTS_DataField keyValue = whereArgs[0].second;
+        return makeKey(tableName, {primaryKeyName}, {keyValue.toString()});
+    }
+
+    std::lock_guard<std::mutex> guard(cacheLock);
+    auto tableIndexes = uniqueIndexes.find(tableName);
+    if (tableIndexes == uniqueIndexes.end())
+    {
+        return std::nullopt;
+    }
+
+    for (const auto& indexColumns: tableIndexes->second)
+    {
+        if (indexColumns.size() != whereArgs.size())
+        {
+            continue;
+        }
+
+        std::vector<std::string> columnValues;
+        for (const auto& columnName: indexColumns)
+        {
+            for (const auto& whereArg: whereArgs)
+            {
+                if (whereArg.first == columnName)
+                {
+                    PTS_DataField columnValue = whereArg.second;
+                    columnValues.push_back(columnValue.toString());
+                    break;
+                }
+            }
+        }
+
+        if (columnValues.size() == indexColumns.size())
+        {
+            return makeKey(tableName, indexColumns, columnValues);
+        }
+    }
+
+    return std::nullopt;
+}
+
+std::vector<std::string> ModelIdentityMap::makeAllKeys(const ModelBase& model)
+{
+    std::string tableName = model.getTableName();
+    std::vector<std::string> keys;
+
+    keys.push_back(getRowKey(model));
+
+    auto tableIndexes = uniqueIndexes.find(tableName);
+    if (tableIndexes == uniqueIndexes.end())
+    {
+        return keys;
+    }
+
+    for (const auto& indexColumns: tableIndexes->second)
+    {
+        std::vector<std::string> columnValues;
+        for (const auto& columnName: indexColumns)
+        {
+            std::optional<std::size_t> fieldSlot = model.findFieldSlot(columnName);
+            if (!fieldSlot.has_value() || !model.getFieldBySlot(*fieldSlot).hasValue())
+            {
+                break;
+            }
+            columnValues.push_back(model.getFieldBySlot(*fieldSlot).toString());
+        }
+
+        if (columnValues.size() == indexColumns.size())
+        {
+            keys.push_back(makeKey(tableName, indexColumns, columnValues));
+        }
+    }
+
+    return keys;
+}
+
+std::string ModelIdentityMap::makeKey(const std::string& tableName, const std::vector<std::string>& columnNames,
+    const std::vector<std::string>& columnValues)
+{
+    std::string key(tableName);
+
+    for (std::size_t column = 0; column < columnNames.size(); ++column)
+    {
+        key += '\x1f';
+        key += columnNames[column];
+        key += '=';
+        key += columnValues[column];
+    }
+
+    return key;
+}
+
+void ModelIdentityMap::storeLocked(ModelShp model)
+{
+    eraseLocked(*model);
+
+    modelsByUse.push_front({model, makeAllKeys(*model)});
+    for (const auto& key: modelsByUse.front().keys)
+    {
+        modelsByKey[key] = modelsByUse.begin();
+    }
+
+    while (modelsByUse.size() > capacity)
+    {
+        for (const auto& key: modelsByUse.back().keys)
+        {
+            modelsByKey.erase(key);
+        }
+        modelsByUse.pop_back();
+        ++evictions;
+    }
+}
+
+/*
+ * Removes every entry that shares a key with model. The primary key of a row never
+ * changes, so this includes the entry that holds model under old index values.
+ */
+void ModelIdentityMap::eraseLocked(const ModelBase& model)
+{
+    for (const auto& key: makeAllKeys(model))
+    {
+        auto keyEntry = modelsByKey.find(key);
+        if (keyEntry == modelsByKey.end())
+        {
+            continue;
+        }
+
+        LRUList::iterator cachedEntry = keyEntry->second;
+        for (const auto& entryKey: cachedEntry->keys)
+        {
+            modelsByKey.erase(entryKey);
+        }
+        modelsByUse.erase(cachedEntry);
+    }
+}
@@ -0,0 +1,80 @@
+#ifndef MODELIDENTITYMAP_H_
+#define MODELIDENTITYMAP_H_
+
+/*
+ * ModelIdentityMap:
+ * Keeps at most one copy of the field values per database row, the row is
+ * identified by the table and the primary key. A row can also be found by the
+ * values of any unique index registered for its table. When the map is full the
+ * least recently used row is evicted.
+ *
+ * The map owns its copies, a model stored or found is never shared with the
+ * caller, so changing the caller's model can't change the cached values. All
+ * methods are thread safe.
+ */
+#include <cstddef>
+#include <list>
+#include "ModelBase.h"
+#include <mutex>
+#include <optional>
+#include "PTS_DataField.h"
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+struct ModelCacheStatistics
+{
+    std::size_t hits;
+    std::size_t misses;
+    std::size_t evictions;
+    std::size_t size;
+};
+
+class ModelIdentityMap
+{
+public:
+    ModelIdentityMap(std::size_t maxModels);
+    ~ModelIdentityMap() = default;
+    bool isEnabled() const { return capacity > 0; };
+    void addUniqueIndex(const std::string& tableName, std::vector<std::string> columnNames);
+/*
+ * find() copies the cached values of the row into model, it returns false if the
+ * row isn't cached. store() keeps a copy of model, only a fully loaded model that
+ * is in the database is stored.
+ */
+    bool find(ModelBase& model, const std::vector<WhereArg>& whereArgs);
+    void store(const ModelBase& model);
+/*
+ * A row key names the row of model by table and primary key, eraseRow() drops the
+ * cached object of the row whatever its index values are now.
+ */
+    std::string getRowKey(const ModelBase& model);
+    void eraseRow(const std::string& rowKey);
+    ModelCacheStatistics getStatistics() const;
+
+private:
+    struct CacheEntry
+    {
+        ModelShp model;
+        std::vector<std::string> keys;
+    };
+    using LRUList = std::list<CacheEntry>;
+
+    std::optional<std::string> makeLookupKey(ModelBase& modelPrototype, const std::vector<WhereArg>& whereArgs);
+    std::vector<std::string> makeAllKeys(const ModelBase& model);
+    std::string makeKey(const std::string& tableName, const std::vector<std::string>& columnNames,
+        const std::vector<std::string>& columnValues);
+    void storeLocked(ModelShp model);
+    void eraseLocked(const ModelBase& model);
+
+    const std::size_t capacity;
+    mutable std::mutex cacheLock;
+    LRUList modelsByUse;        // Most recently used first.
+    std::unordered_map<std::string, LRUList::iterator> modelsByKey;
+    std::unordered_map<std::string, std::vector<std::vector<std::string>>> uniqueIndexes;
+    std::size_t hits;
+    std::size_t misses;
+    std::size_t evictions;
+};
+
+#endif  // MODELIDENTITYMAP_H_
@@ -0,0 +1,46 @@
+#include <cstddef>
+#include "ModelSchema.h"
+#include <optional>
+#include "PTS_DataField.h"
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <utility>
+
+ModelSchema::ModelSchema(std::string modelName, std::string tabName, std::string primaryKeyName)
+: modelClassName{std::move(modelName)}, tableName{std::move(tabName)}, allFieldsMask{0}, requiredFieldsMask{0},
+    generatedFieldsMask{0}
+{
+    addField(primaryKeyName, PTS_DataField::PTS_DB_FieldType::Key, true);
+}
+
+/*
+ * The models keep the state of their fields in FieldMasks, so a model has at most
+ * MaxFieldCount fields.
+ */
+void ModelSchema::addField(const std::string& fieldName, PTS_DataField::PTS_DB_FieldType fieldType, bool required)
+{
+    if (fields.size() == MaxFieldCount)
+    {
+        throw std::logic_error(modelClassName + " has more than " + std::to_string(MaxFieldCount) + " fields");
+    }
+
+    allFieldsMask |= fieldSlotBit(fields.size());
+    if (required)
+    {
+        requiredFieldsMask |= fieldSlotBit(fields.size());
+    }
+    slotsByFieldName.insert({fieldName, fields.size()});
+    fields.push_back(PTS_DataField::describeColumn(fieldType, fieldName, required));
+}
+
+std::optional<std::size_t> ModelSchema::findFieldSlot(std::string_view fieldName) const
+{
+    auto fieldSlot = slotsByFieldName.find(fieldName);
+    if (fieldSlot == slotsByFieldName.end())
+    {
+        return std::nullopt;
+    }
+
+    return fieldSlot->second;
+}
@@ -0,0 +1,126 @@
+#ifndef MODELSCHEMA_H_
+#define MODELSCHEMA_H_
+
+/*
+ * ModelSchema:
+ * The model and table names and the column of every field of a model class, in
+ * slot order with the primary key in slot 0. Each model class builds its schema
+ * once, its instances point at the schema and only store the field values.
+ * The fields of the instances point at the descriptors, so a schema must not be
+ * changed once an instance has been created.
+ */
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <optional>
+#include "PTS_DataField.h"
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+/*
+ * A set of fields with one bit per slot, the bit of slot n is 1 << n.
+ */
+using FieldMask = std::uint64_t;
+constexpr std::size_t MaxFieldCount = 64;
+constexpr FieldMask fieldSlotBit(std::size_t slot) { return FieldMask{1} << slot; }
+
+/*
+ * Calls slotFunction with the slot of each set bit, lowest slot first.
+ */
+template<typename SlotFunction>
+void forEachSlotIn(FieldMask slots, SlotFunction&& slotFunction)
+{
+    while (slots)
+    {
+        slotFunction(static_cast<std::size_t>(std::countr_zero(slots)));
+        slots &= slots - 1;
+    }
+}
+
+/*
+ * A field identified at compile time by its slot and column type, a model class
+ * declares one tag per field for ModelBase::get() and set(). The tags must list
+ * the slots in the order the schema adds the fields, addField() checks that when
+ * the schema is built and fieldSlotsInOrder() when the model class is compiled.
+ */
+template<std::size_t fieldSlot, PTS_DataField::PTS_DB_FieldType columnType>
+struct FieldTag
+{
+    static constexpr std::size_t slot = fieldSlot;
+    static constexpr PTS_DataField::PTS_DB_FieldType fieldType = columnType;
+    using ValueType = typename PTS_ColumnValue<columnType>::type;
+};
+
+/*
+ * True if the tags are numbered 0, 1, 2, ... in the order they are listed. A model
+ * class static_asserts its tags in schema order so a misnumbered slot doesn't compile.
+ */
+template<typename... Fields>
+constexpr bool fieldSlotsInOrder()
+{
+    std::size_t position = 0;
+    return ((Fields::slot == position++) && ...);
+}
+
+class ModelSchema
+{
+public:
+    ModelSchema(std::string modelName, std::string tabName, std::string primaryKeyName);
+    ModelSchema(const ModelSchema&) = delete;
+    ModelSchema(ModelSchema&&) = default;
+    ModelSchema& operator=(const ModelSchema&) = delete;
+    void addField(const std::string& fieldName, PTS_DataField::PTS_DB_FieldType fieldType, bool required=false);
+    template<typename Field>
+    void addField(Field, const std::string& fieldName, bool required=false)
+    {
+        if (Field::slot != fields.size())
+        {
+            throw std::logic_error(modelClassName + " field " + fieldName + " is not declared in slot order");
+        }
+        addField(fieldName, Field::fieldType, required);
+    }
+/*
+ * The database sets a generated field, such as a change timestamp, whenever the
+ * row is written. The storage never writes it, a model holds the value the row
+ * was read with.
+ */
+    template<typename Field>
+    void addGeneratedField(Field field, const std::string& fieldName)
+    {
+        addField(field, fieldName);
+        generatedFieldsMask |= fieldSlotBit(Field::slot);
+    }
+    const std::string& getModelName() const { return modelClassName; };
+    const std::string& getTableName() const { return tableName; };
+    const std::string& getPrimaryKeyName() const { return fields.front().columnName; };
+    std::size_t getFieldCount() const { return fields.size(); };
+    const PTS_FieldDescriptor& getField(std::size_t slot) const { return fields[slot]; };
+    std::optional<std::size_t> findFieldSlot(std::string_view fieldName) const;
+    FieldMask getAllFieldsMask() const { return allFieldsMask; };
+    FieldMask getRequiredFieldsMask() const { return requiredFieldsMask; };
+    FieldMask getGeneratedFieldsMask() const { return generatedFieldsMask; };
+
+private:
+    std::string modelClassName;
+    std::string tableName;
+    std::vector<PTS_FieldDescriptor> fields;
+    FieldMask allFieldsMask;
+    FieldMask requiredFieldsMask;
+    FieldMask generatedFieldsMask;
+/*
+ * Looked up by std::string_view so that finding a field by name doesn't build a
+ * std::string.
+ */
+    struct FieldNameHash
+    {
+        using is_transparent = void;
+        std::size_t operator()(std::string_view fieldName) const { return std::hash<std::string_view>{}(fieldName); };
+    };
+    std::unordered_map<std::string, std::size_t, FieldNameHash, std::equal_to<>> slotsByFieldName;
+};
+
+#endif  // MODELSCHEMA_H_
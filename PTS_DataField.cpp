@@ -1,8 +1,11 @@
 #include <chrono>
 #include "GenericDictionary.h"
 #include <iostream>
+#include <memory>
 #include "PTS_DataField.h"
+#include "PTS_ValueCell.h"
 #include <string>
+#include <string_view>
 #include <variant>
 #include <vector>
 #include <utility>
@@ -26,36 +29,45 @@ static std::vector<GenericDictionary<PTS_DataField::PTS_DB_FieldType, std::strin
 
 static GenericDictionary<PTS_DataField::PTS_DB_FieldType, std::string> translationTable(translationTableDefs);
 
+/*
+ * Parameters only carry a value, they share unnamed descriptors so that creating
+ * one doesn't allocate.
+ */
+static const PTS_FieldDescriptor parameterDescriptor{PTS_DataField::PTS_DB_FieldType::Key, "", false, false};
+static const PTS_FieldDescriptor stringParameterDescriptor{PTS_DataField::PTS_DB_FieldType::Text, "", false, true};
+
 PTS_DataField::PTS_DataField(DataValueType inValue)
-: dataValue{inValue}, required{false}, modified{false}
+: descriptor{std::holds_alternative<std::string>(inValue)? &stringParameterDescriptor : &parameterDescriptor},
+    dataValue{inValue}
+{
+}
+
+PTS_DataField::PTS_DataField(const PTS_FieldDescriptor& fieldDescriptor)
+: descriptor{&fieldDescriptor}
 {
 }
 
-PTS_DataField::PTS_DataField(PTS_DataField::PTS_DB_FieldType cType, std::string cName, bool isRequired)
-: columnType{cType}, dbColumnName{cName}, required{isRequired}, modified{false}
+PTS_FieldDescriptor PTS_DataField::describeColumn(PTS_DataField::PTS_DB_FieldType cType, std::string cName,
+    bool isRequired)
 {
-    dataValue = std::monostate{};
+    PTS_FieldDescriptor fieldDescriptor{cType, std::move(cName), isRequired, false};
 
     switch (cType)
     {
         default :
-            stringType = false;
+            fieldDescriptor.stringType = false;
             break;
         case PTS_DataField::PTS_DB_FieldType::VarChar45 :
         case PTS_DataField::PTS_DB_FieldType::VarChar256 :
         case PTS_DataField::PTS_DB_FieldType::VarChar1024 :
         case PTS_DataField::PTS_DB_FieldType::TinyText :
         case PTS_DataField::PTS_DB_FieldType::Text :
-            stringType = true;
+            fieldDescriptor.stringType = true;
             break;
     }
-};
 
-PTS_DataField::PTS_DataField(PTS_DataField::PTS_DB_FieldType cType, std::string cName, DataValueType inValue, bool isRequired)
-: PTS_DataField(cType, cName, isRequired)
-{
-    dataValue = inValue;
-};
+    return fieldDescriptor;
+}
 
 struct Visitor
 {
@@ -81,30 +93,32 @@ struct Visitor
     }
 };
 
-std::string PTS_DataField::toString()
+std::string PTS_DataField::toString() const
 {
-    return std::visit(Visitor{}, dataValue);
+    if (dataValue.holds<std::string>())
+    {
+        return std::string(dataValue.getStringView());
+    }
+
+    return std::visit(Visitor{}, dataValue.toDataValue());
 }
 
 void PTS_DataField::setValue(DataValueType inValue)
 {
-    dataValue = inValue;
-    modified = true;
+    dataValue = PTS_ValueCell(inValue);
 }
 
 bool PTS_DataField::hasValue() const
 {
-    return !std::holds_alternative<std::monostate>(dataValue);
+    return !dataValue.isEmpty();
 }
 
-std::string PTS_DataField::fieldInfo()
+std::string PTS_DataField::fieldInfo() const
 {
     std::string info("Column Name: ");
-    info += dbColumnName + "\tColumn Type: ";
+    info += getColumnName() + "\tColumn Type: ";
     info += typeToName() + "\tRequired: ";
-    info += required? "True" : "False";
-    info += "\tModified: ";
-    info += modified? "True" : "False";
+    info += isRequired()? "True" : "False";
     info += "\tHas value: ";
     info += hasValue()? "True" : "False";
 
@@ -126,7 +140,7 @@ std::string PTS_DataField::fieldInfo()
 
 const std::string PTS_DataField::typeToName() const
 {
-    PTS_DataField::PTS_DB_FieldType target_key = columnType;
+    PTS_DataField::PTS_DB_FieldType target_key = getFieldType();
     auto typeName = translationTable.lookupName(target_key);
     return typeName.has_value()? *typeName : std::string();
 }
@@ -134,9 +148,9 @@ const std::string PTS_DataField::typeToName() const
 int PTS_DataField::getIntValue() const
 {
     if (hasValue() &&
-        columnType == PTS_DataField::PTS_DB_FieldType::Int)
+        getFieldType() == PTS_DataField::PTS_DB_FieldType::Int)
     {
-        return std::get<int>(dataValue);
+        return dataValue.getOr<int>(0);
     }
 
     return 0;
@@ -144,10 +158,10 @@ int PTS_DataField::getIntValue() const
 
 std::size_t PTS_DataField::getSize_tValue() const
 {
-    if (hasValue() && (columnType == PTS_DataField::PTS_DB_FieldType::Key
-        || columnType == PTS_DataField::PTS_DB_FieldType::Size_T))
+    if (hasValue() && (getFieldType() == PTS_DataField::PTS_DB_FieldType::Key
+        || getFieldType() == PTS_DataField::PTS_DB_FieldType::Size_T))
     {
-        return std::get<std::size_t>(dataValue);
+        return dataValue.getOr<std::size_t>(0);
     }
 
     return 0;
@@ -155,9 +169,9 @@ std::size_t PTS_DataField::getSize_tValue() const
 
 double PTS_DataField::getDoubleValue() const
 {
-    if (hasValue() && columnType == PTS_DataField::PTS_DB_FieldType::Double)
+    if (hasValue() && getFieldType() == PTS_DataField::PTS_DB_FieldType::Double)
     {
-        return std::get<double>(dataValue);
+        return dataValue.getOr<double>(0.0);
     }
 
     return 0.0;
@@ -165,9 +179,9 @@ double PTS_DataField::getDoubleValue() const
 
 std::chrono::year_month_day PTS_DataField::getDateValue() const
 {
-    if (hasValue() && columnType == PTS_DataField::PTS_DB_FieldType::Date)
+    if (hasValue() && getFieldType() == PTS_DataField::PTS_DB_FieldType::Date)
     {
-        return std::get<std::chrono::year_month_day>(dataValue);
+        return dataValue.getOr(std::chrono::year_month_day());
     }
 
     return std::chrono::year_month_day();
@@ -175,10 +189,10 @@ std::chrono::year_month_day PTS_DataField::getDateValue() const
 
 std::chrono::time_point<std::chrono::system_clock> PTS_DataField::getTimeValue() const
 {
-    if (hasValue() && (columnType == PTS_DataField::PTS_DB_FieldType::DateTime
-        || columnType == PTS_DataField::PTS_DB_FieldType::TimeStamp))
+    if (hasValue() && (getFieldType() == PTS_DataField::PTS_DB_FieldType::DateTime
+        || getFieldType() == PTS_DataField::PTS_DB_FieldType::TimeStamp))
     {
-        return std::get<std::chrono::time_point<std::chrono::system_clock>>(dataValue);
+        return dataValue.getOr(std::chrono::time_point<std::chrono::system_clock>());
     }
 
     return std::chrono::time_point<std::chrono::system_clock>();
@@ -190,18 +204,23 @@ std::string PTS_DataField::getStringValue() const
     {
         if (isStringType())
         {
-            return std::get<std::string>(dataValue);
+            return std::string(dataValue.getStringView());
         }
     }
 
         return std::string();
 }
 
+std::string_view PTS_DataField::getStringView() const
+{
+    return isStringType()? dataValue.getStringView() : std::string_view();
+}
+
 bool PTS_DataField::getBoolValue() const
 {
-    if (hasValue() && columnType == PTS_DataField::PTS_DB_FieldType::Boolean)
+    if (hasValue() && getFieldType() == PTS_DataField::PTS_DB_FieldType::Boolean)
     {
-        return std::get<bool>(dataValue);
+        return dataValue.getOr<bool>(false);
     }
 
     return false;
@@ -209,9 +228,9 @@ bool PTS_DataField::getBoolValue() const
 
 unsigned int PTS_DataField::getUnsignedIntValue() const
 {
-    if (hasValue() && columnType == PTS_DataField::PTS_DB_FieldType::UnsignedInt)
+    if (hasValue() && getFieldType() == PTS_DataField::PTS_DB_FieldType::UnsignedInt)
     {
-        return std::get<unsigned int>(dataValue);
+        return dataValue.getOr<unsigned int>(0);
     }
 
     return 0;
@@ -9,11 +9,12 @@
  */
 #include <chrono>
 #include <iostream>
+#include "PTS_ValueCell.h"
 #include <string>
-#include <variant>
+#include <string_view>
+#include <utility>
 
-using DataValueType = std::variant<std::monostate, std::size_t, std::chrono::time_point<std::chrono::system_clock>, std::chrono::year_month_day, 
-        unsigned int, int, double, std::string, bool>;
+struct PTS_FieldDescriptor;
 
 class PTS_DataField
 {
@@ -22,19 +23,22 @@ public:
         Boolean, UnsignedInt, Int, Size_T, Double
     };
     PTS_DataField(DataValueType inValue);   // Only used for parameters for SELECT statement
-    PTS_DataField(PTS_DataField::PTS_DB_FieldType cType, std::string cName, bool isRequired=false);
-    PTS_DataField(PTS_DataField::PTS_DB_FieldType cType, std::string cName, DataValueType inValue, bool isRequired=false);
+    PTS_DataField(const PTS_FieldDescriptor& fieldDescriptor);   // A field of a model, see ModelSchema.
     ~PTS_DataField() = default;
+    static PTS_FieldDescriptor describeColumn(PTS_DataField::PTS_DB_FieldType cType, std::string cName,
+        bool isRequired);
 /*
  * Data access methods.
  */
-    std::string toString();
+    std::string toString() const;
     void setValue(DataValueType inValue);
-    void dbSetValue(DataValueType inValue) { dataValue = inValue; };    // Don't set modified.
-    DataValueType getValue() { return dataValue; };
+    void setValueCell(PTS_ValueCell inValue) { dataValue = std::move(inValue); };
+    DataValueType getValue() const { return dataValue.toDataValue(); };
+    const PTS_ValueCell& getValueCell() const { return dataValue; };
+    template<typename ValueType>
+    ValueType getValueOr(ValueType fallback) const { return dataValue.getOr(fallback); }
     bool hasValue() const;
-    bool wasModified() const { return modified; };
-    bool isRequired() const { return required; };
+    bool isRequired() const;
     int getIntValue() const;
     std::size_t getSize_tValue() const;
     std::size_t getKeyValue() const { return getSize_tValue(); };
@@ -43,43 +47,42 @@ public:
     std::chrono::year_month_day getDateValue() const;
     std::chrono::time_point<std::chrono::system_clock> getTimeValue() const;
     std::string getStringValue() const;
+    std::string_view getStringView() const;   // Valid until the field is changed.
     bool getBoolValue() const;
     unsigned int getUnsignedIntValue() const;
-    void clearDirtyBit() { modified = false; };
+    void clearValue() { dataValue = PTS_ValueCell(); };
 
 /*
  * Field information methods.
  */
-    std::string getColumnName() const { return dbColumnName; };
-    PTS_DataField::PTS_DB_FieldType getFieldType() const { return columnType; };
-    std::string fieldInfo();
+    std::string getColumnName() const;
+    PTS_DataField::PTS_DB_FieldType getFieldType() const;
+    std::string fieldInfo() const;
     const std::string typeToName() const;
-    bool isStringType() const { return stringType; };
+    bool isStringType() const;
 
 /*
  * Operators
  */
     bool operator==(const PTS_DataField& other) const
     {
-        bool areTheSame = (columnType == other.columnType && dbColumnName == other.dbColumnName &&
+        bool areTheSame = (getFieldType() == other.getFieldType() && getColumnName() == other.getColumnName() &&
             dataValue == other.dataValue);
 
         if (!areTheSame)
         {
-            std::clog << "Fields differ: " << dbColumnName << "\n";// << other;
+            std::clog << "Fields differ: " << getColumnName() << "\n";// << other;
         }
 
         return areTheSame;
     };
-    friend std::ostream& operator<<(std::ostream& os, PTS_DataField& field)
+    friend std::ostream& operator<<(std::ostream& os, const PTS_DataField& field)
     {
         os << field.fieldInfo() << "\n";
         os << "Column Name: ";
-        os << field.dbColumnName << "\tColumn Type: ";
+        os << field.getColumnName() << "\tColumn Type: ";
         os << field.typeToName() + "\tRequired: ";
-        os << (field.required? "True" : "False");
-        os << "\tModified: ";
-        os << (field.modified? "True" : "False");
+        os << (field.isRequired()? "True" : "False");
         os << "\tHas value: ";
         os << (field.hasValue()? "True" : "False");
 
@@ -100,13 +103,57 @@ public:
 
 
 private:
-    PTS_DB_FieldType columnType;
-    std::string dbColumnName;
-    DataValueType dataValue;
+/*
+ * The fields of a model point at the descriptor in the schema of the model class,
+ * parameters at a shared unnamed descriptor. Whether a field of a model was
+ * modified or loaded is kept by the model, see ModelBase.
+ */
+    const PTS_FieldDescriptor* descriptor;
+    PTS_ValueCell dataValue;
+};
+
+/*
+ * The column a field holds, shared by that field in every instance of a model class.
+ */
+struct PTS_FieldDescriptor
+{
+    PTS_DataField::PTS_DB_FieldType columnType;
+    std::string columnName;
     bool required;
-    bool modified;
     bool stringType;
 };
 
+/*
+ * The alternative of DataValueType that holds the value of a column type, the
+ * character column types hold a std::string.
+ */
+template<PTS_DataField::PTS_DB_FieldType columnType>
+struct PTS_ColumnValue { using type = std::string; };
+template<> struct PTS_ColumnValue<PTS_DataField::PTS_DB_FieldType::Key> { using type = std::size_t; };
+template<> struct PTS_ColumnValue<PTS_DataField::PTS_DB_FieldType::Size_T> { using type = std::size_t; };
+template<> struct PTS_ColumnValue<PTS_DataField::PTS_DB_FieldType::Date> { using type = std::chrono::year_month_day; };
+template<> struct PTS_ColumnValue<PTS_DataField::PTS_DB_FieldType::DateTime>
+{
+    using type = std::chrono::time_point<std::chrono::system_clock>;
+};
+template<> struct PTS_ColumnValue<PTS_DataField::PTS_DB_FieldType::TimeStamp>
+{
+    using type = std::chrono::time_point<std::chrono::system_clock>;
+};
+template<> struct PTS_ColumnValue<PTS_DataField::PTS_DB_FieldType::Boolean> { using type = bool; };
+template<> struct PTS_ColumnValue<PTS_DataField::PTS_DB_FieldType::UnsignedInt> { using type = unsigned int; };
+template<> struct PTS_ColumnValue<PTS_DataField::PTS_DB_FieldType::Int> { using type = int; };
+template<> struct PTS_ColumnValue<PTS_DataField::PTS_DB_FieldType::Double> { using type = double; };
+
+inline bool PTS_DataField::isRequired() const { return descriptor->required; }
+inline std::string PTS_DataField::getColumnName() const { return descriptor->columnName; }
+inline PTS_DataField::PTS_DB_FieldType PTS_DataField::getFieldType() const { return descriptor->columnType; }
+inline bool PTS_DataField::isStringType() const { return descriptor->stringType; }
+
+/*
+ * A column name and the value the column must be equal to in a WHERE clause.
+ */
+using WhereArg = std::pair<std::string, PTS_DataField>;
+
 #endif  // PTS_DATAFIELD_H_
 
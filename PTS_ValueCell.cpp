@@ -0,0 +1,264 @@
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include "PTS_ValueCell.h"
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <variant>
+
+PTS_ValueCell::PTS_ValueCell(const DataValueType& value)
+: payload{}, kind{Kind::Empty}
+{
+    assign(value);
+}
+
+/*
+ * The characters are copied once, straight from the view.
+ */
+PTS_ValueCell::PTS_ValueCell(std::string_view text)
+: payload{}, kind{Kind::Empty}
+{
+    assignString(text);
+}
+
+PTS_ValueCell::PTS_ValueCell(const PTS_ValueCell& other)
+: payload{}, kind{Kind::Empty}
+{
+    copyFrom(other);
+}
+
+/*
+ * The moved from cell is left empty, the owned string changes hands.
+ */
+PTS_ValueCell::PTS_ValueCell(PTS_ValueCell&& other) noexcept
+: kind{other.kind}
+{
+    std::memcpy(payload, other.payload, PayloadSize);
+    other.kind = Kind::Empty;
+}
+
+PTS_ValueCell& PTS_ValueCell::operator=(const PTS_ValueCell& other)
+{
+    if (this != &other)
+    {
+        releaseString();
+        copyFrom(other);
+    }
+
+    return *this;
+}
+
+PTS_ValueCell& PTS_ValueCell::operator=(PTS_ValueCell&& other) noexcept
+{
+    if (this != &other)
+    {
+        releaseString();
+        std::memcpy(payload, other.payload, PayloadSize);
+        kind = other.kind;
+        other.kind = Kind::Empty;
+    }
+
+    return *this;
+}
+
+DataValueType PTS_ValueCell::toDataValue() const
+{
+    switch (kind)
+    {
+        case Kind::Size_T :
+            return loadBits<std::size_t>();
+
+        case Kind::TimePoint :
+            return getOr(std::chrono::time_point<std::chrono::system_clock>());
+
+        case Kind::Date :
+        case Kind::InvalidDate :
+            return loadDate();
+
+        case Kind::UnsignedInt :
+            return loadBits<unsigned int>();
+
+        case Kind::Int :
+            return loadBits<int>();
+
+        case Kind::Double :
+            return loadBits<double>();
+
+        case Kind::Bool :
+            return loadBits<bool>();
+
+        case Kind::InlineString :
+        case Kind::OwnedString :
+            return std::string(getStringView());
+
+        default:
+            return std::monostate{};
+    }
+}
+
+std::string_view PTS_ValueCell::getStringView() const
+{
+    if (kind == Kind::InlineString)
+    {
+        return std::string_view(reinterpret_cast<const char*>(payload), payload[InlineStringCapacity]);
+    }
+
+    if (kind == Kind::OwnedString)
+    {
+        return std::string_view(loadBits<const char*>(), loadBits<std::uint32_t>(OwnedLengthOffset));
+    }
+
+    return std::string_view();
+}
+
+/*
+ * Cells of the same value compare equal however the value is stored, the string
+ * and date kinds depend only on the value so comparing the kinds first is safe.
+ */
+bool PTS_ValueCell::operator==(const PTS_ValueCell& other) const
+{
+    if (kind != other.kind)
+    {
+        return false;
+    }
+
+    switch (kind)
+    {
+        case Kind::Empty :
+            return true;
+
+        case Kind::InlineString :
+        case Kind::OwnedString :
+            return getStringView() == other.getStringView();
+
+        default:
+            return toDataValue() == other.toDataValue();
+    }
+}
+
+void PTS_ValueCell::assign(const DataValueType& value)
+{
+    releaseString();
+    std::visit([this](const auto& alternative) {
+        using AlternativeType = std::decay_t<decltype(alternative)>;
+        if constexpr (std::is_same_v<AlternativeType, std::monostate>)
+        {
+            kind = Kind::Empty;
+        }
+        else if constexpr (std::is_same_v<AlternativeType, std::string>)
+        {
+            assignString(alternative);
+        }
+        else if constexpr (std::is_same_v<AlternativeType, std::chrono::year_month_day>)
+        {
+            assignDate(alternative);
+        }
+        else if constexpr (std::is_same_v<AlternativeType, std::chrono::time_point<std::chrono::system_clock>>)
+        {
+            storeBits<Ticks>(alternative.time_since_epoch().count());
+            kind = Kind::TimePoint;
+        }
+        else
+        {
+            storeBits(alternative);
+            if constexpr (std::is_same_v<AlternativeType, std::size_t>)
+            {
+                kind = Kind::Size_T;
+            }
+            else if constexpr (std::is_same_v<AlternativeType, unsigned int>)
+            {
+                kind = Kind::UnsignedInt;
+            }
+            else if constexpr (std::is_same_v<AlternativeType, int>)
+            {
+                kind = Kind::Int;
+            }
+            else if constexpr (std::is_same_v<AlternativeType, double>)
+            {
+                kind = Kind::Double;
+            }
+            else
+            {
+                kind = Kind::Bool;
+            }
+        }
+    }, value);
+}
+
+void PTS_ValueCell::assignString(std::string_view text)
+{
+    if (text.size() <= InlineStringCapacity)
+    {
+        std::memcpy(payload, text.data(), text.size());
+        payload[InlineStringCapacity] = static_cast<unsigned char>(text.size());
+        kind = Kind::InlineString;
+        return;
+    }
+
+    if (text.size() > std::numeric_limits<std::uint32_t>::max())
+    {
+        throw std::length_error("PTS_ValueCell: string too long");
+    }
+
+    char* ownedChars = new char[text.size()];
+    std::memcpy(ownedChars, text.data(), text.size());
+    storeBits(ownedChars);
+    storeBits(static_cast<std::uint32_t>(text.size()), OwnedLengthOffset);
+    kind = Kind::OwnedString;
+}
+
+/*
+ * A date that isn't valid, such as a zero date from MySQL, has no day count. It
+ * is kept as its year, month and day so it reads back unchanged.
+ */
+void PTS_ValueCell::assignDate(std::chrono::year_month_day date)
+{
+    if (date.ok())
+    {
+        storeBits(static_cast<std::int32_t>(std::chrono::sys_days(date).time_since_epoch().count()));
+        kind = Kind::Date;
+        return;
+    }
+
+    storeBits(static_cast<std::int16_t>(static_cast<int>(date.year())));
+    storeBits(static_cast<unsigned char>(static_cast<unsigned int>(date.month())), sizeof(std::int16_t));
+    storeBits(static_cast<unsigned char>(static_cast<unsigned int>(date.day())), sizeof(std::int16_t) + 1);
+    kind = Kind::InvalidDate;
+}
+
+std::chrono::year_month_day PTS_ValueCell::loadDate() const
+{
+    if (kind == Kind::Date)
+    {
+        return std::chrono::sys_days(std::chrono::days(loadBits<std::int32_t>()));
+    }
+
+    return std::chrono::year_month_day(std::chrono::year(loadBits<std::int16_t>()),
+        std::chrono::month(loadBits<unsigned char>(sizeof(std::int16_t))),
+        std::chrono::day(loadBits<unsigned char>(sizeof(std::int16_t) + 1)));
+}
+
+void PTS_ValueCell::copyFrom(const PTS_ValueCell& other)
+{
+    if (other.kind == Kind::OwnedString)
+    {
+        assignString(other.getStringView());
+        return;
+    }
+
+    std::memcpy(payload, other.payload, PayloadSize);
+    kind = other.kind;
+}
+
+void PTS_ValueCell::releaseString()
+{
+    if (kind == Kind::OwnedString)
+    {
+        delete[] loadBits<char*>();
+    }
+    kind = Kind::Empty;
+}
@@ -0,0 +1,158 @@
+#ifndef PTS_VALUECELL_H_
+#define PTS_VALUECELL_H_
+
+/*
+ * PTS_ValueCell:
+ * The value of one field in 16 bytes. Dates are stored as a count of days, times
+ * as a count of clock ticks and strings of up to 14 characters inline. A longer
+ * string is kept in a block of exactly its length owned by the cell. The value is
+ * converted to and from DataValueType at the edges, see PTS_DataField.
+ *
+ * Holding the DataValueType itself would make a field 48 bytes instead of 24. For
+ * 10000 TaskModels built from testData/planData.txt that is 932 bytes per task
+ * instead of 500. Copying a long string allocates once, as copying a std::string
+ * does, so a copied task makes 2 allocations either way.
+ */
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <variant>
+
+using DataValueType = std::variant<std::monostate, std::size_t, std::chrono::time_point<std::chrono::system_clock>, std::chrono::year_month_day,
+        unsigned int, int, double, std::string, bool>;
+
+class PTS_ValueCell
+{
+public:
+    PTS_ValueCell() : payload{}, kind{Kind::Empty} {};
+    PTS_ValueCell(const DataValueType& value);
+    explicit PTS_ValueCell(std::string_view text);
+    PTS_ValueCell(const PTS_ValueCell& other);
+    PTS_ValueCell(PTS_ValueCell&& other) noexcept;
+    ~PTS_ValueCell() { releaseString(); };
+    PTS_ValueCell& operator=(const PTS_ValueCell& other);
+    PTS_ValueCell& operator=(PTS_ValueCell&& other) noexcept;
+
+    bool isEmpty() const { return kind == Kind::Empty; };
+    DataValueType toDataValue() const;
+/*
+ * ValueType is one of the alternatives of DataValueType. getOr() returns the
+ * fallback if the cell doesn't hold a ValueType.
+ */
+    template<typename ValueType>
+    bool holds() const;
+    template<typename ValueType>
+    ValueType getOr(ValueType fallback) const;
+/*
+ * Empty if the cell doesn't hold a string. The view is valid until the cell is
+ * changed or destroyed.
+ */
+    std::string_view getStringView() const;
+
+    bool operator==(const PTS_ValueCell& other) const;
+
+private:
+    enum class Kind : unsigned char {Empty, Size_T, TimePoint, Date, InvalidDate, UnsignedInt, Int, Double, Bool,
+        InlineString, OwnedString
+    };
+    static constexpr std::size_t PayloadSize = 15;
+    static constexpr std::size_t InlineStringCapacity = PayloadSize - 1;    // The last byte holds the length.
+    static constexpr std::size_t OwnedLengthOffset = sizeof(char*);
+    using Ticks = std::chrono::system_clock::duration::rep;
+    static_assert(sizeof(Ticks) <= sizeof(std::int64_t));
+
+    template<typename BitsType>
+    void storeBits(BitsType bits, std::size_t offset=0)
+    {
+        static_assert(std::is_trivially_copyable_v<BitsType>);
+        std::memcpy(payload + offset, &bits, sizeof(bits));
+    }
+    template<typename BitsType>
+    BitsType loadBits(std::size_t offset=0) const
+    {
+        BitsType bits;
+        std::memcpy(&bits, payload + offset, sizeof(bits));
+        return bits;
+    }
+    void assign(const DataValueType& value);
+    void assignString(std::string_view text);
+    void assignDate(std::chrono::year_month_day date);
+    std::chrono::year_month_day loadDate() const;
+    void copyFrom(const PTS_ValueCell& other);
+    void releaseString();
+
+    alignas(std::int64_t) unsigned char payload[PayloadSize];
+    Kind kind;
+};
+
+static_assert(sizeof(PTS_ValueCell) == 16 && sizeof(PTS_ValueCell) < sizeof(DataValueType));
+
+template<typename ValueType>
+bool PTS_ValueCell::holds() const
+{
+    if constexpr (std::is_same_v<ValueType, std::size_t>)
+    {
+        return kind == Kind::Size_T;
+    }
+    else if constexpr (std::is_same_v<ValueType, std::chrono::time_point<std::chrono::system_clock>>)
+    {
+        return kind == Kind::TimePoint;
+    }
+    else if constexpr (std::is_same_v<ValueType, std::chrono::year_month_day>)
+    {
+        return kind == Kind::Date || kind == Kind::InvalidDate;
+    }
+    else if constexpr (std::is_same_v<ValueType, unsigned int>)
+    {
+        return kind == Kind::UnsignedInt;
+    }
+    else if constexpr (std::is_same_v<ValueType, int>)
+    {
+        return kind == Kind::Int;
+    }
+    else if constexpr (std::is_same_v<ValueType, double>)
+    {
+        return kind == Kind::Double;
+    }
+    else if constexpr (std::is_same_v<ValueType, bool>)
+    {
+        return kind == Kind::Bool;
+    }
+    else
+    {
+        static_assert(std::is_same_v<ValueType, std::string>, "Not an alternative of DataValueType");
+        return kind == Kind::InlineString || kind == Kind::OwnedString;
+    }
+}
+
+template<typename ValueType>
+ValueType PTS_ValueCell::getOr(ValueType fallback) const
+{
+    if (!holds<ValueType>())
+    {
+        return fallback;
+    }
+
+    if constexpr (std::is_same_v<ValueType, std::chrono::time_point<std::chrono::system_clock>>)
+    {
+        return ValueType(std::chrono::system_clock::duration(loadBits<Ticks>()));
+    }
+    else if constexpr (std::is_same_v<ValueType, std::chrono::year_month_day>)
+    {
+        return loadDate();
+    }
+    else if constexpr (std::is_same_v<ValueType, std::string>)
+    {
+        return std::string(getStringView());
+    }
+    else
+    {
+        return loadBits<ValueType>();
+    }
+}
+
+#endif  // PTS_VALUECELL_H_
@@ -22,10 +22,12 @@ CREATE TABLE IF NOT EXISTS  `PlannerTaskScheduleDB`.`UserProfile` (
     `IncludeMinorPriorityInSchedule` BOOLEAN DEFAULT TRUE,
     `UseLettersForMajorPriority` BOOLEAN DEFAULT TRUE,
     `SeparatePriorityWithDot` BOOLEAN DEFAULT FALSE,
+    `LastModified` DATETIME(6) NOT NULL DEFAULT CURRENT_TIMESTAMP(6) ON UPDATE CURRENT_TIMESTAMP(6),
     PRIMARY KEY (`UserID`, `LastName`, `LoginName`),
     UNIQUE INDEX `UserID_UNIQUE` (`UserID`),
     UNIQUE INDEX `FullName_UNIQUE` (`LastName`, `FirstName`, `MiddleInitial`),
-    UNIQUE INDEX `LoginName_UNIQUE` (`LoginName` ASC)
+    UNIQUE INDEX `LoginName_UNIQUE` (`LoginName` ASC),
+    INDEX `LastModified_idx` (`LastModified` ASC)
 );
 
 -- --------------------------------------------------------
@@ -106,11 +108,15 @@ CREATE TABLE IF NOT EXISTS  `PlannerTaskScheduleDB`.`Tasks` (
     `ActualEffortHours` double NOT NULL,
     `SchedulePriorityGroup` INT UNSIGNED NOT NULL,
     `PriorityInGroup` INT UNSIGNED NOT NULL,
+    `LastModified` DATETIME(6) NOT NULL DEFAULT CURRENT_TIMESTAMP(6) ON UPDATE CURRENT_TIMESTAMP(6),
     PRIMARY KEY (`TaskID`, `CreatedBy`),
     UNIQUE INDEX `TaskID_UNIQUE` (`TaskID` ASC),
     INDEX `fk_Tasks_CreatedBy_idx` (`CreatedBy` ASC),
     INDEX `fk_Tasks_AsignedTo_idx` (`AsignedTo` ASC),
     INDEX `Description_idx` (`Description` ASC),
+    INDEX `AsignedTo_RequiredDelivery_idx` (`AsignedTo` ASC, `RequiredDelivery` ASC, `TaskID` ASC),
+    INDEX `AsignedTo_LastModified_idx` (`AsignedTo` ASC, `LastModified` ASC),
+    INDEX `ParentTask_idx` (`ParentTask` ASC),
     CONSTRAINT `fk_Tasks_CreatedBy`
         FOREIGN KEY (`CreatedBy`)
         REFERENCES `UserProfile` (`UserID`)
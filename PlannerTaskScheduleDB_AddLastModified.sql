@@ -0,0 +1,11 @@
+-- Adds the LastModified change tracking of PlannerTaskScheduleDB.sql to a database
+-- that was created before it. Existing rows are stamped with the time of the
+-- migration. The database sets LastModified on every write.
+
+ALTER TABLE `PlannerTaskScheduleDB`.`UserProfile`
+    ADD COLUMN `LastModified` DATETIME(6) NOT NULL DEFAULT CURRENT_TIMESTAMP(6) ON UPDATE CURRENT_TIMESTAMP(6),
+    ADD INDEX `LastModified_idx` (`LastModified` ASC);
+
+ALTER TABLE `PlannerTaskScheduleDB`.`Tasks`
+    ADD COLUMN `LastModified` DATETIME(6) NOT NULL DEFAULT CURRENT_TIMESTAMP(6) ON UPDATE CURRENT_TIMESTAMP(6),
+    ADD INDEX `AsignedTo_LastModified_idx` (`AsignedTo` ASC, `LastModified` ASC);
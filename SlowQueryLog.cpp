@@ -0,0 +1,252 @@
+#include <cctype>
+#include <chrono>
+#include "CommandLineParser.h"
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <format>
+#include <fstream>
+#include <iostream>
+#include <mutex>
+#include "SlowQueryLog.h"
+#include "StatementStatistics.h"
+#include <stop_token>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <thread>
+#include <utility>
+#include <vector>
+
+SlowQueryLog::SlowQueryLog(ProgramOptions& programOptions)
+:   threshold{StatisticsClock::duration::max()}, sampleInterval{programOptions.slowQuerySampleInterval},
+    logFileName{programOptions.slowQueryLogFile}, maxLogFileSize{programOptions.slowQueryLogMaxBytes},
+    slowStatementCount{0}, droppedEntryCount{0}, logFileSize{0}
+{
+    if (programOptions.slowQueryThresholdMilliseconds == 0)
+    {
+        return;
+    }
+
+    openLogFile();
+    if (!logFile.is_open())
+    {
+        std::cerr << "Unable to open the slow query log " << logFileName << ", slow queries are not logged.\n";
+        return;
+    }
+
+    threshold = std::chrono::milliseconds(programOptions.slowQueryThresholdMilliseconds);
+    writerThread = std::jthread([this](std::stop_token stopWriting) { writeEntries(stopWriting); });
+}
+
+/*
+ * The writer drains the queue before it stops.
+ */
+SlowQueryLog::~SlowQueryLog()
+{
+    if (writerThread.joinable())
+    {
+        writerThread.request_stop();
+        writerThread.join();
+    }
+}
+
+void SlowQueryLog::record(std::string_view sqlStatement, StatisticsClock::duration latency, std::size_t rows)
+{
+    {
+        std::lock_guard<std::mutex> guard(queueLock);
+        if (slowStatementCount++ % sampleInterval != 0)
+        {
+            return;
+        }
+        if (pendingEntries.size() >= MaxPendingEntries)
+        {
+            ++droppedEntryCount;
+            return;
+        }
+        pendingEntries.push_back({std::chrono::system_clock::now(), latency, rows, std::string(sqlStatement)});
+    }
+
+    entriesQueued.notify_one();
+}
+
+std::uint64_t SlowQueryLog::getDroppedEntryCount() const
+{
+    std::lock_guard<std::mutex> guard(queueLock);
+    return droppedEntryCount;
+}
+
+std::string SlowQueryLog::normalizeStatement(std::string_view sqlStatement)
+{
+    return collapseRepeatedValueLists(replaceLiterals(sqlStatement));
+}
+
+/*
+ * Quoted strings and numbers become ?, identifiers quoted with backticks and
+ * digits that are part of an identifier are kept.
+ */
+std::string SlowQueryLog::replaceLiterals(std::string_view sqlStatement)
+{
+    auto isIdentifierChar = [](char c) {
+        return std::isalnum(static_cast<unsigned char>(c)) || c == '_' || c == '$';
+    };
+    std::string normalized;
+    normalized.reserve(sqlStatement.size());
+
+    std::size_t position = 0;
+    while (position < sqlStatement.size())
+    {
+        char current = sqlStatement[position];
+        if (current == '\'' || current == '"')
+        {
+            ++position;
+            while (position < sqlStatement.size())
+            {
+                if (sqlStatement[position] == '\\')
+                {
+                    position += 2;
+                }
+                else if (sqlStatement[position] == current)
+                {
+                    ++position;
+                    if (position >= sqlStatement.size() || sqlStatement[position] != current)
+                    {
+                        break;
+                    }
+                    ++position;
+                }
+                else
+                {
+                    ++position;
+                }
+            }
+            normalized += '?';
+        }
+        else if (current == '`')
+        {
+            std::size_t closingQuote = sqlStatement.find('`', position + 1);
+            std::size_t end = (closingQuote == std::string_view::npos)? sqlStatement.size() : closingQuote + 1;
+            normalized.append(sqlStatement.substr(position, end - position));
+            position = end;
+        }
+        else if (std::isdigit(static_cast<unsigned char>(current)) &&
+            (normalized.empty() || !isIdentifierChar(normalized.back())))
+        {
+            while (position < sqlStatement.size() && (isIdentifierChar(sqlStatement[position]) ||
+                sqlStatement[position] == '.'))
+            {
+                ++position;
+            }
+            normalized += '?';
+        }
+        else
+        {
+            normalized += current;
+            ++position;
+        }
+    }
+
+    return normalized;
+}
+
+/*
+ * A value list is a parenthesized group that only contains ?, commas and spaces.
+ */
+std::string SlowQueryLog::collapseRepeatedValueLists(std::string_view sqlStatement)
+{
+    std::string collapsed;
+    collapsed.reserve(sqlStatement.size());
+    std::string_view previousList;
+    bool listWasRepeated = false;
+
+    std::size_t position = 0;
+    while (position < sqlStatement.size())
+    {
+        char current = sqlStatement[position];
+        if (current == '(')
+        {
+            std::size_t listEnd = sqlStatement.find_first_not_of("?, ", position + 1);
+            if (listEnd != std::string_view::npos && sqlStatement[listEnd] == ')')
+            {
+                std::string_view valueList = sqlStatement.substr(position, listEnd - position + 1);
+                if (valueList == previousList && collapsed.ends_with(", "))
+                {
+                    collapsed.resize(collapsed.size() - 2);
+                    if (!listWasRepeated)
+                    {
+                        collapsed += ", ...";
+                        listWasRepeated = true;
+                    }
+                }
+                else
+                {
+                    collapsed.append(valueList);
+                    previousList = valueList;
+                    listWasRepeated = false;
+                }
+                position = listEnd + 1;
+                continue;
+            }
+        }
+
+        if (current != ',' && current != ' ')
+        {
+            previousList = {};
+            listWasRepeated = false;
+        }
+        collapsed += current;
+        ++position;
+    }
+
+    return collapsed;
+}
+
+void SlowQueryLog::writeEntries(std::stop_token stopWriting)
+{
+    while (true)
+    {
+        std::vector<SlowQueryEntry> entries;
+        {
+            std::unique_lock<std::mutex> guard(queueLock);
+            entriesQueued.wait(guard, stopWriting, [this]() { return !pendingEntries.empty(); });
+            entries.swap(pendingEntries);
+        }
+
+        if (entries.empty())
+        {
+            return;
+        }
+
+        for (const auto& entry: entries)
+        {
+            writeLine(std::format("{:%Y-%m-%d %H:%M:%S} {:.3f} ms {} rows {}\n",
+                std::chrono::floor<std::chrono::milliseconds>(entry.finished),
+                std::chrono::duration<double, std::milli>(entry.latency).count(), entry.rows,
+                normalizeStatement(entry.sqlStatement)));
+        }
+        logFile.flush();
+    }
+}
+
+void SlowQueryLog::writeLine(const std::string& line)
+{
+    if (logFileSize > 0 && logFileSize + line.size() > maxLogFileSize)
+    {
+        logFile.close();
+        std::error_code renameError;
+        std::filesystem::rename(logFileName, logFileName + ".1", renameError);
+        openLogFile();
+    }
+
+    logFile << line;
+    logFileSize += line.size();
+}
+
+void SlowQueryLog::openLogFile()
+{
+    logFile.open(logFileName, std::ios::out | std::ios::app);
+
+    std::error_code sizeError;
+    std::uintmax_t existingSize = std::filesystem::file_size(logFileName, sizeError);
+    logFileSize = (sizeError)? 0 : static_cast<std::size_t>(existingSize);
+}
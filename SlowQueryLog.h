@@ -0,0 +1,70 @@
+#ifndef SLOWQUERYLOG_H_
+#define SLOWQUERYLOG_H_
+
+/*
+ * SlowQueryLog:
+ * Writes statements that took at least the threshold to a local log file. One
+ * in every sampleInterval slow statements is logged. The statements are queued
+ * and normalized, formatted and written by a background thread, so a statement
+ * that isn't slow only costs the comparison in isSlow(). When the file reaches
+ * its maximum size it is renamed to <file>.1 and a new file is started.
+ */
+#include <chrono>
+#include "CommandLineParser.h"
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <mutex>
+#include "StatementStatistics.h"
+#include <stop_token>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+class SlowQueryLog
+{
+public:
+    SlowQueryLog(ProgramOptions& programOptions);
+    ~SlowQueryLog();
+    bool isSlow(StatisticsClock::duration latency) const { return latency >= threshold; };
+    void record(std::string_view sqlStatement, StatisticsClock::duration latency, std::size_t rows);
+    std::uint64_t getDroppedEntryCount() const;
+/*
+ * Literals are replaced by ?, runs of identical value lists such as the rows of
+ * a multi-row INSERT are reduced to the first list followed by ", ...".
+ */
+    static std::string normalizeStatement(std::string_view sqlStatement);
+
+private:
+    struct SlowQueryEntry
+    {
+        std::chrono::system_clock::time_point finished;
+        StatisticsClock::duration latency;
+        std::size_t rows;
+        std::string sqlStatement;
+    };
+    static constexpr std::size_t MaxPendingEntries = 4096;
+
+    static std::string replaceLiterals(std::string_view sqlStatement);
+    static std::string collapseRepeatedValueLists(std::string_view sqlStatement);
+    void writeEntries(std::stop_token stopWriting);
+    void writeLine(const std::string& line);
+    void openLogFile();
+
+    StatisticsClock::duration threshold;
+    std::uint64_t sampleInterval;
+    std::string logFileName;
+    std::size_t maxLogFileSize;
+    mutable std::mutex queueLock;
+    std::condition_variable_any entriesQueued;
+    std::vector<SlowQueryEntry> pendingEntries;
+    std::uint64_t slowStatementCount;
+    std::uint64_t droppedEntryCount;
+    std::ofstream logFile;
+    std::size_t logFileSize;
+    std::jthread writerThread;
+};
+
+#endif  // SLOWQUERYLOG_H_
@@ -0,0 +1,287 @@
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <format>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <shared_mutex>
+#include "StatementStatistics.h"
+#include <string>
+#include <string_view>
+#include <vector>
+
+LatencyHistogram::LatencyHistogram()
+: count{0}, maximum{0}
+{
+    for (auto& bucket: buckets)
+    {
+        bucket.store(0, std::memory_order_relaxed);
+    }
+}
+
+void LatencyHistogram::record(StatisticsClock::duration latency)
+{
+    std::int64_t signedNanoseconds = std::chrono::duration_cast<std::chrono::nanoseconds>(latency).count();
+    std::uint64_t nanoseconds = static_cast<std::uint64_t>(std::max<std::int64_t>(signedNanoseconds, 0));
+
+    buckets[bucketIndex(nanoseconds)].fetch_add(1, std::memory_order_relaxed);
+    count.fetch_add(1, std::memory_order_relaxed);
+
+    std::uint64_t previousMaximum = maximum.load(std::memory_order_relaxed);
+    while (nanoseconds > previousMaximum &&
+        !maximum.compare_exchange_weak(previousMaximum, nanoseconds, std::memory_order_relaxed))
+    {
+    }
+}
+
+/*
+ * Concurrent recording can make the bucket total differ slightly from count, the
+ * percentile is taken from the buckets alone.
+ */
+std::chrono::nanoseconds LatencyHistogram::getPercentile(double percentile) const
+{
+    std::array<std::uint64_t, BucketCount> bucketCounts;
+    std::uint64_t total = 0;
+    for (std::size_t index = 0; index < BucketCount; ++index)
+    {
+        bucketCounts[index] = buckets[index].load(std::memory_order_relaxed);
+        total += bucketCounts[index];
+    }
+
+    if (total == 0)
+    {
+        return std::chrono::nanoseconds(0);
+    }
+
+    std::uint64_t rank = static_cast<std::uint64_t>(std::ceil(percentile / 100.0 * static_cast<double>(total)));
+    rank = std::clamp<std::uint64_t>(rank, 1, total);
+
+    std::uint64_t seen = 0;
+    for (std::size_t index = 0; index < BucketCount; ++index)
+    {
+        seen += bucketCounts[index];
+        if (seen >= rank)
+        {
+            std::uint64_t upperBound = std::min(bucketUpperBound(index), maximum.load(std::memory_order_relaxed));
+            return std::chrono::nanoseconds(static_cast<std::int64_t>(upperBound));
+        }
+    }
+
+    return getMaximum();
+}
+
+/*
+ * Values below SubBucketCount have a bucket each. Above that the highest set bit
+ * selects the power of two and the next SubBucketBits bits select the bucket.
+ */
+std::size_t LatencyHistogram::bucketIndex(std::uint64_t nanoseconds)
+{
+    if (nanoseconds < SubBucketCount)
+    {
+        return static_cast<std::size_t>(nanoseconds);
+    }
+
+    unsigned int exponent = static_cast<unsigned int>(std::bit_width(nanoseconds)) - 1;
+    std::size_t subBucket = static_cast<std::size_t>(nanoseconds >> (exponent - SubBucketBits)) - SubBucketCount;
+
+    return (exponent - SubBucketBits + 1) * SubBucketCount + subBucket;
+}
+
+std::uint64_t LatencyHistogram::bucketUpperBound(std::size_t index)
+{
+    if (index < SubBucketCount)
+    {
+        return index;
+    }
+
+    unsigned int shift = static_cast<unsigned int>(index / SubBucketCount) - 1;
+    std::uint64_t subBucket = index % SubBucketCount;
+    std::uint64_t lowerBound = (SubBucketCount + subBucket) << shift;
+
+    return lowerBound + ((std::uint64_t{1} << shift) - 1);
+}
+
+StatementMetrics::StatementMetrics()
+: statements{0}, errors{0}, rowsReturned{0}, bytes{0}
+{
+}
+
+void StatementMetrics::recordStatement(std::size_t rows, std::size_t statementBytes)
+{
+    statements.fetch_add(1, std::memory_order_relaxed);
+    rowsReturned.fetch_add(rows, std::memory_order_relaxed);
+    bytes.fetch_add(statementBytes, std::memory_order_relaxed);
+}
+
+void StatementMetrics::recordError()
+{
+    statements.fetch_add(1, std::memory_order_relaxed);
+    errors.fetch_add(1, std::memory_order_relaxed);
+}
+
+StatementStatistics::StatementStatistics(const std::vector<std::string>& knownTableNames)
+{
+    for (const auto& tableName: knownTableNames)
+    {
+        KindMetrics tableMetrics;
+        for (std::size_t kind = 0; kind < StatementKindCount; ++kind)
+        {
+            tableMetrics[kind] = &getOrCreateMetrics(static_cast<StatementKind>(kind), tableName);
+        }
+        knownTables.emplace_back(tableName, tableMetrics);
+    }
+}
+
+/*
+ * There are only a few known tables, comparing the names is cheaper than hashing.
+ */
+StatementMetrics& StatementStatistics::getMetrics(StatementKind kind, std::string_view tableName)
+{
+    for (const auto& [knownTableName, tableMetrics]: knownTables)
+    {
+        if (knownTableName == tableName)
+        {
+            return *tableMetrics[static_cast<std::size_t>(kind)];
+        }
+    }
+
+    return getOrCreateMetrics(kind, tableName);
+}
+
+StatementMetrics& StatementStatistics::getOrCreateMetrics(StatementKind kind, std::string_view tableName)
+{
+    MetricsKey metricsKey{kind, std::string(tableName)};
+
+    {
+        std::shared_lock<std::shared_mutex> readGuard(metricsLock);
+        auto existingMetrics = metricsByStatement.find(metricsKey);
+        if (existingMetrics != metricsByStatement.end())
+        {
+            return *existingMetrics->second;
+        }
+    }
+
+    std::lock_guard<std::shared_mutex> writeGuard(metricsLock);
+    auto [metrics, inserted] = metricsByStatement.try_emplace(std::move(metricsKey), nullptr);
+    if (inserted)
+    {
+        metrics->second = std::make_unique<StatementMetrics>();
+    }
+
+    return *metrics->second;
+}
+
+std::vector<StatementStatisticsSummary> StatementStatistics::getSummary() const
+{
+    std::vector<StatementStatisticsSummary> summary;
+
+    std::shared_lock<std::shared_mutex> readGuard(metricsLock);
+    for (const auto& [metricsKey, metrics]: metricsByStatement)
+    {
+        if (isUnused(*metrics))
+        {
+            continue;
+        }
+        StatementStatisticsSummary statementSummary{metricsKey.first, metricsKey.second, metrics->getStatementCount(),
+            metrics->getErrorCount(), metrics->getRowsReturned(), metrics->getBytes(), {}};
+        for (std::size_t phase = 0; phase < StatementPhaseCount; ++phase)
+        {
+            const LatencyHistogram& latencies = metrics->getLatencies(static_cast<StatementPhase>(phase));
+            statementSummary.phases[phase] = {latencies.getCount(), latencies.getPercentile(50.0),
+                latencies.getPercentile(99.0), latencies.getPercentile(99.9), latencies.getMaximum()};
+        }
+        summary.push_back(std::move(statementSummary));
+    }
+
+    return summary;
+}
+
+void StatementStatistics::report(std::ostream& output) const
+{
+    auto microseconds = [](std::chrono::nanoseconds latency) {
+        return std::chrono::duration<double, std::micro>(latency).count();
+    };
+
+    output << "Statement statistics, latencies in microseconds:\n";
+    for (const auto& statementSummary: getSummary())
+    {
+        output << std::format("{} {}: statements {}, errors {}, rows {}, bytes {}\n",
+            getKindName(statementSummary.kind), statementSummary.tableName, statementSummary.statements,
+            statementSummary.errors, statementSummary.rowsReturned, statementSummary.bytes);
+
+        for (std::size_t phase = 0; phase < StatementPhaseCount; ++phase)
+        {
+            const PhaseLatencySummary& latencies = statementSummary.phases[phase];
+            if (latencies.count == 0)
+            {
+                continue;
+            }
+            output << std::format("    {:8} count {} p50 {:.1f} p99 {:.1f} p999 {:.1f} max {:.1f}\n",
+                getPhaseName(static_cast<StatementPhase>(phase)), latencies.count, microseconds(latencies.p50),
+                microseconds(latencies.p99), microseconds(latencies.p999), microseconds(latencies.maximum));
+        }
+    }
+}
+
+bool StatementStatistics::isUnused(const StatementMetrics& metrics)
+{
+    if (metrics.getStatementCount() != 0 || metrics.getErrorCount() != 0)
+    {
+        return false;
+    }
+
+    for (std::size_t phase = 0; phase < StatementPhaseCount; ++phase)
+    {
+        if (metrics.getLatencies(static_cast<StatementPhase>(phase)).getCount() != 0)
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+std::string_view StatementStatistics::getKindName(StatementKind kind)
+{
+    switch (kind)
+    {
+        case StatementKind::Insert :
+            return "INSERT";
+        case StatementKind::BulkInsert :
+            return "BULK INSERT";
+        case StatementKind::Update :
+            return "UPDATE";
+        case StatementKind::Select :
+            return "SELECT";
+        case StatementKind::KeyLookup :
+            return "KEY LOOKUP";
+        case StatementKind::Stream :
+            return "STREAM";
+        case StatementKind::Pipeline :
+            return "PIPELINE";
+        case StatementKind::Transaction :
+            return "TRANSACTION";
+    }
+
+    return "UNKNOWN";
+}
+
+std::string_view StatementStatistics::getPhaseName(StatementPhase phase)
+{
+    switch (phase)
+    {
+        case StatementPhase::Connect :
+            return "connect";
+        case StatementPhase::Execute :
+            return "execute";
+        case StatementPhase::Convert :
+            return "convert";
+    }
+
+    return "unknown";
+}
@@ -0,0 +1,143 @@
+#ifndef STATEMENTSTATISTICS_H_
+#define STATEMENTSTATISTICS_H_
+
+/*
+ * StatementStatistics:
+ * Counters and latency histograms for the statements DBInterface sends to the
+ * server, kept per statement kind and table. The metrics of the tables named at
+ * construction are found without a lock or an allocation and recording only uses
+ * relaxed atomic operations, so the statistics don't serialize the ioContext
+ * threads. The metrics of any other table are created under a lock.
+ */
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <ostream>
+#include <shared_mutex>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+/*
+ * Pipeline and bulk insert connect times are recorded for the table "*", the
+ * statements they send can belong to any table.
+ */
+enum class StatementKind {Insert, BulkInsert, Update, Select, KeyLookup, Stream, Pipeline, Transaction};
+constexpr std::size_t StatementKindCount = 8;
+static_assert(static_cast<std::size_t>(StatementKind::Transaction) + 1 == StatementKindCount);
+enum class StatementPhase {Connect, Execute, Convert};
+constexpr std::size_t StatementPhaseCount = 3;
+using StatisticsClock = std::chrono::steady_clock;
+
+/*
+ * Log linear buckets, every power of two nanoseconds is split into 16 buckets.
+ * A percentile is reported as the upper bound of its bucket, at most 1/16 above
+ * the latency that was recorded.
+ */
+class LatencyHistogram
+{
+public:
+    LatencyHistogram();
+    void record(StatisticsClock::duration latency);
+    std::uint64_t getCount() const { return count.load(std::memory_order_relaxed); };
+    std::chrono::nanoseconds getMaximum() const
+    {
+        return std::chrono::nanoseconds(maximum.load(std::memory_order_relaxed));
+    };
+    std::chrono::nanoseconds getPercentile(double percentile) const;
+
+private:
+    static constexpr unsigned int SubBucketBits = 4;
+    static constexpr std::size_t SubBucketCount = std::size_t{1} << SubBucketBits;
+    static constexpr std::size_t BucketCount = (64 - SubBucketBits + 1) * SubBucketCount;
+    static std::size_t bucketIndex(std::uint64_t nanoseconds);
+    static std::uint64_t bucketUpperBound(std::size_t index);
+
+    std::array<std::atomic<std::uint64_t>, BucketCount> buckets;
+    std::atomic<std::uint64_t> count;
+    std::atomic<std::uint64_t> maximum;
+};
+
+/*
+ * statements counts every statement, including the ones that failed. bytes is
+ * the size of the parameters sent and of the field data returned, the protocol
+ * overhead isn't included.
+ */
+class StatementMetrics
+{
+public:
+    StatementMetrics();
+    void recordStatement(std::size_t rows, std::size_t bytes);
+    void recordError();
+    void recordLatency(StatementPhase phase, StatisticsClock::duration latency)
+    {
+        phaseLatencies[static_cast<std::size_t>(phase)].record(latency);
+    };
+    std::uint64_t getStatementCount() const { return statements.load(std::memory_order_relaxed); };
+    std::uint64_t getErrorCount() const { return errors.load(std::memory_order_relaxed); };
+    std::uint64_t getRowsReturned() const { return rowsReturned.load(std::memory_order_relaxed); };
+    std::uint64_t getBytes() const { return bytes.load(std::memory_order_relaxed); };
+    const LatencyHistogram& getLatencies(StatementPhase phase) const
+    {
+        return phaseLatencies[static_cast<std::size_t>(phase)];
+    };
+
+private:
+    std::atomic<std::uint64_t> statements;
+    std::atomic<std::uint64_t> errors;
+    std::atomic<std::uint64_t> rowsReturned;
+    std::atomic<std::uint64_t> bytes;
+    std::array<LatencyHistogram, StatementPhaseCount> phaseLatencies;
+};
+
+struct PhaseLatencySummary
+{
+    std::uint64_t count;
+    std::chrono::nanoseconds p50;
+    std::chrono::nanoseconds p99;
+    std::chrono::nanoseconds p999;
+    std::chrono::nanoseconds maximum;
+};
+
+struct StatementStatisticsSummary
+{
+    StatementKind kind;
+    std::string tableName;
+    std::uint64_t statements;
+    std::uint64_t errors;
+    std::uint64_t rowsReturned;
+    std::uint64_t bytes;
+    std::array<PhaseLatencySummary, StatementPhaseCount> phases;
+};
+
+class StatementStatistics
+{
+public:
+    StatementStatistics(const std::vector<std::string>& knownTableNames);
+/*
+ * The returned metrics live as long as the StatementStatistics object. Metrics
+ * nothing was recorded in are left out of the summary.
+ */
+    StatementMetrics& getMetrics(StatementKind kind, std::string_view tableName);
+    std::vector<StatementStatisticsSummary> getSummary() const;
+    void report(std::ostream& output) const;
+    static std::string_view getKindName(StatementKind kind);
+    static std::string_view getPhaseName(StatementPhase phase);
+
+private:
+    using MetricsKey = std::pair<StatementKind, std::string>;
+    using KindMetrics = std::array<StatementMetrics*, StatementKindCount>;
+    StatementMetrics& getOrCreateMetrics(StatementKind kind, std::string_view tableName);
+    static bool isUnused(const StatementMetrics& metrics);
+
+    std::vector<std::pair<std::string, KindMetrics>> knownTables;    // Not changed after construction.
+    mutable std::shared_mutex metricsLock;
+    std::map<MetricsKey, std::unique_ptr<StatementMetrics>> metricsByStatement;
+};
+
+#endif  // STATEMENTSTATISTICS_H_
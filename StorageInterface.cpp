@@ -0,0 +1,497 @@
+#include <algorithm>
+#include <cctype>
+#include <charconv>
+#include <chrono>
+#include <cstddef>
+#include <exception>
+#include <expected>
+#include <format>
+#include <future>
+#include <memory>
+#include "ModelBase.h"
+#include <optional>
+#include "StorageInterface.h"
+#include <string>
+#include <system_error>
+#include "TaskModel.h"
+#include <unordered_map>
+#include "UserModel.h"
+#include <utility>
+#include <vector>
+#include "WriteBehindQueue.h"
+
+StorageInterface::StorageInterface()
+: errorMessages{""}
+{
+}
+
+StorageInterface::~StorageInterface()
+{
+}
+
+UserList StorageInterface::getAllUsers()
+{
+    UserList allUsers;
+
+    getAllUsers([&allUsers](UserList& userBatch) {
+        allUsers.insert(allUsers.end(), userBatch.begin(), userBatch.end());
+    });
+
+    return allUsers;
+}
+
+TaskList StorageInterface::getAllTasksForUser(UserModel_shp user)
+{
+    return getAllTasksForUser(*user);
+}
+
+TaskList StorageInterface::getAllTasksForUser(UserModel& user)
+{
+    TaskList allTasks;
+
+    getAllTasksForUser(user.getUserID(), [&allTasks](TaskList& taskBatch) {
+        allTasks.insert(allTasks.end(), taskBatch.begin(), taskBatch.end());
+    });
+
+    return allTasks;
+}
+
+std::future<WriteKeyResult> StorageInterface::insertWriteBehind(ModelShp model, WriteCompletionCallback onComplete)
+{
+    return queueWrite({WriteBehindRequest::Kind::Insert, std::move(model), {}, std::move(onComplete)});
+}
+
+std::future<WriteKeyResult> StorageInterface::updateWriteBehind(ModelShp model, WriteCompletionCallback onComplete)
+{
+    return queueWrite({WriteBehindRequest::Kind::Update, std::move(model), {}, std::move(onComplete)});
+}
+
+/*
+ * Returns once every write queued before the call has completed.
+ */
+void StorageInterface::flushWriteBehind()
+{
+    queueWrite({WriteBehindRequest::Kind::Flush, nullptr, {}, nullptr}).wait();
+}
+
+DBStatus StorageInterface::validateModelForInsert(ModelBase& model)
+{
+    if (model.isInDataBase())
+    {
+        return std::unexpected(std::string("The model object is already in the database.\n"));
+    }
+
+    if (!model.allRequiredFieldsHaveData())
+    {
+        return std::unexpected(model.reportMissingRequiredFields());
+    }
+
+    return DBStatus{};
+}
+
+DBStatus StorageInterface::validateModelForUpdate(ModelBase& model)
+{
+    if (!model.isInDataBase())
+    {
+        return std::unexpected(std::string("The model object is not in the database yet.\n"));
+    }
+
+    return DBStatus{};
+}
+
+/*
+ * The tables use the server's default collation, utf8mb4_0900_ai_ci, which
+ * compares strings without regard to case. Strings are folded to lower case so
+ * that equal values have equal comparison values, accents are not folded.
+ */
+std::string StorageInterface::makeComparisonValue(const DataValueType& value)
+{
+    if (const std::string* text = std::get_if<std::string>(&value))
+    {
+        std::string foldedText(*text);
+        std::transform(foldedText.begin(), foldedText.end(), foldedText.begin(),
+            [](unsigned char character) { return static_cast<char>(std::tolower(character)); });
+        return foldedText;
+    }
+
+    PTS_DataField field(value);
+    return field.toString();
+}
+
+DBStatus StorageInterface::reportNoRowUpdated(ModelBase& model)
+{
+    return std::unexpected(std::format("{} {} is not in the database, the update matched no row.\n",
+        model.getModelName(), model.getPrimaryKey()));
+}
+
+bool StorageInterface::reportModelStatus(const std::vector<DBStatus>& modelStatus)
+{
+    bool allSucceeded = true;
+
+    for (std::size_t modelIndex = 0; modelIndex < modelStatus.size(); ++modelIndex)
+    {
+        if (!modelStatus[modelIndex])
+        {
+            appendErrorMessage(std::format("Model {}: {}\n", modelIndex, modelStatus[modelIndex].error()));
+            allSucceeded = false;
+        }
+    }
+
+    return allSucceeded;
+}
+
+bool StorageInterface::reportPipelineStatus(const std::vector<PipelineStage>& stages)
+{
+    bool allStagesSucceeded = true;
+
+    for (std::size_t stageIndex = 0; stageIndex < stages.size(); ++stageIndex)
+    {
+        if (!stages[stageIndex].status)
+        {
+            appendErrorMessage(std::format("Stage {}: {}\n", stageIndex, stages[stageIndex].status.error()));
+            allStagesSucceeded = false;
+        }
+    }
+
+    return allStagesSucceeded;
+}
+
+/*
+ * The cursor is the order, the user and the sort values of the last task joined
+ * by '.', the due date is stored as days since the epoch.
+ */
+std::string StorageInterface::makeTaskPageCursor(const TaskPageCursor& position)
+{
+    std::chrono::sys_days lastDueDay = (position.order == TaskPageOrder::RequiredDelivery)?
+        std::chrono::sys_days{position.lastDueDate} : std::chrono::sys_days{};
+
+    return std::format("{}.{}.{}.{}", static_cast<unsigned int>(position.order), position.userID,
+        lastDueDay.time_since_epoch().count(), position.lastTaskID);
+}
+
+std::expected<StorageInterface::TaskPageCursor, std::string> StorageInterface::parseTaskPageCursor(
+    const std::string& cursor, TaskPageOrder order, std::size_t userID)
+{
+    const char* position = cursor.data();
+    const char* cursorEnd = cursor.data() + cursor.size();
+    auto readValue = [&position, cursorEnd](auto& value, bool lastValue) {
+        auto [valueEnd, errorCode] = std::from_chars(position, cursorEnd, value);
+        if (errorCode != std::errc() || (lastValue && valueEnd != cursorEnd) ||
+            (!lastValue && (valueEnd == cursorEnd || *valueEnd != '.')))
+        {
+            return false;
+        }
+        position = (lastValue)? valueEnd : valueEnd + 1;
+        return true;
+    };
+
+    unsigned int cursorOrder = 0;
+    std::size_t cursorUserID = 0;
+    int lastDueDay = 0;
+    std::size_t lastTaskID = 0;
+    if (!readValue(cursorOrder, false) || !readValue(cursorUserID, false) || !readValue(lastDueDay, false) ||
+        !readValue(lastTaskID, true) || cursorOrder != static_cast<unsigned int>(order) || cursorUserID != userID)
+    {
+        return std::unexpected(std::string("The page cursor doesn't belong to this task listing.\n"));
+    }
+
+    std::chrono::sys_days lastDueDate{std::chrono::days{lastDueDay}};
+
+    return TaskPageCursor{order, userID, std::chrono::year_month_day{lastDueDate}, lastTaskID};
+}
+
+std::expected<std::vector<std::size_t>, std::string> StorageInterface::findProjectedSlots(const ModelBase& model,
+    const FieldProjection& projection)
+{
+    std::vector<std::size_t> loadedSlots{0};
+    std::string unknownFields;
+
+    for (const auto& fieldName: projection.fieldNames)
+    {
+        std::optional<std::size_t> fieldSlot = model.findFieldSlot(fieldName);
+        if (!fieldSlot.has_value())
+        {
+            unknownFields += "The projection field " + fieldName + " is not a field of the model.\n";
+            continue;
+        }
+        loadedSlots.push_back(*fieldSlot);
+    }
+
+    if (!unknownFields.empty())
+    {
+        return std::unexpected(unknownFields);
+    }
+
+    std::sort(loadedSlots.begin(), loadedSlots.end());
+    loadedSlots.erase(std::unique(loadedSlots.begin(), loadedSlots.end()), loadedSlots.end());
+
+    return loadedSlots;
+}
+
+ChangeStamp StorageInterface::getChangeWindowStart(const ChangeWatermark& watermark)
+{
+    return (watermark.lastModified - ChangeStamp{} > ChangeOverlapWindow)?
+        watermark.lastModified - ChangeOverlapWindow : ChangeStamp{};
+}
+
+/*
+ * Every change in the window has been seen once the query returns, the changes
+ * that are still in the window of the next watermark are remembered.
+ */
+ChangedTasks StorageInterface::skipSeenChanges(const ChangeWatermark& watermark, TaskList windowTasks)
+{
+    ChangedTasks changes{{}, {watermark.lastModified, {}}};
+    std::vector<std::pair<ChangeStamp, std::size_t>> windowChanges;
+    windowChanges.reserve(windowTasks.size());
+
+    for (auto& task: windowTasks)
+    {
+        std::pair<ChangeStamp, std::size_t> change{task->getLastModified(), task->getTaskID()};
+        if (!std::binary_search(watermark.seenChanges.begin(), watermark.seenChanges.end(), change))
+        {
+            changes.tasks.push_back(std::move(task));
+        }
+        changes.nextWatermark.lastModified = std::max(changes.nextWatermark.lastModified, change.first);
+        windowChanges.push_back(change);
+    }
+
+    ChangeStamp nextWindowStart = getChangeWindowStart(changes.nextWatermark);
+    for (const auto& change: windowChanges)
+    {
+        if (change.first >= nextWindowStart)
+        {
+            changes.nextWatermark.seenChanges.push_back(change);
+        }
+    }
+
+    return changes;
+}
+
+DBStatus StorageInterface::validateTaskSubtreeDepth(std::size_t maxDepth)
+{
+    if (maxDepth > MaxTaskSubtreeDepth)
+    {
+        return std::unexpected(std::format("The subtree depth {} is deeper than the maximum of {}.\n", maxDepth,
+            MaxTaskSubtreeDepth));
+    }
+
+    return DBStatus{};
+}
+
+std::expected<TaskTreeNodeShp, std::string> StorageInterface::buildTaskTree(std::size_t rootTaskID,
+    const TaskList& tasks)
+{
+    if (tasks.empty() || tasks.front()->getTaskID() != rootTaskID)
+    {
+        return std::unexpected(std::format("The task {} was not found.\n", rootTaskID));
+    }
+
+    std::unordered_map<std::size_t, TaskTreeNodeShp> nodesByTaskID;
+    TaskTreeNodeShp root = std::make_shared<TaskTreeNode>(TaskTreeNode{tasks.front(), {}, {}, 0});
+    nodesByTaskID.insert({rootTaskID, root});
+
+    for (std::size_t taskIndex = 1; taskIndex < tasks.size(); ++taskIndex)
+    {
+        const TaskModel_shp& task = tasks[taskIndex];
+        auto parentNode = nodesByTaskID.find(task->getParentTaskID());
+        if (parentNode == nodesByTaskID.end() || nodesByTaskID.contains(task->getTaskID()))
+        {
+            continue;
+        }
+
+        TaskTreeNodeShp node = std::make_shared<TaskTreeNode>(
+            TaskTreeNode{task, parentNode->second, {}, parentNode->second->depth + 1});
+        parentNode->second->children.push_back(node);
+        nodesByTaskID.insert({task->getTaskID(), node});
+    }
+
+    return root;
+}
+
+void StorageInterface::startWriteBehind(std::size_t queueDepth)
+{
+    if (queueDepth > 0)
+    {
+        writeBehindQueue = std::make_unique<WriteBehindQueue>(queueDepth);
+        writeBehindFlusher = std::jthread([this]() { runWriteBehindFlusher(); });
+    }
+}
+
+/*
+ * The queued writes are flushed before the flusher exits.
+ */
+void StorageInterface::stopWriteBehind()
+{
+    if (writeBehindQueue)
+    {
+        writeBehindQueue->close();
+        writeBehindFlusher.join();
+        writeBehindQueue.reset();
+    }
+}
+
+std::future<WriteKeyResult> StorageInterface::queueWrite(WriteBehindRequest request)
+{
+    std::future<WriteKeyResult> keyFuture = request.keyPromise.get_future();
+
+    if (writeBehindQueue)
+    {
+        writeBehindQueue->push(std::move(request));
+        return keyFuture;
+    }
+
+    std::vector<WriteBehindRequest> batch;
+    batch.push_back(std::move(request));
+    flushWriteBehindBatch(batch);
+
+    return keyFuture;
+}
+
+/*
+ * Every request that is queued while a batch is written joins the next batch,
+ * the batches grow with the load.
+ */
+void StorageInterface::runWriteBehindFlusher()
+{
+    std::vector<WriteBehindRequest> batch;
+    batch.reserve(writeBehindQueue->getCapacity());
+
+    while (writeBehindQueue->popBatch(batch, writeBehindQueue->getCapacity()))
+    {
+        flushWriteBehindBatch(batch);
+        batch.clear();
+    }
+}
+
+void StorageInterface::flushWriteBehindBatch(std::vector<WriteBehindRequest>& batch)
+{
+    std::size_t firstRequest = 0;
+    for (std::size_t requestIndex = 0; requestIndex < batch.size(); ++requestIndex)
+    {
+        if (batch[requestIndex].kind == WriteBehindRequest::Kind::Flush)
+        {
+            writeQueuedRequests(batch, firstRequest, requestIndex);
+            batch[requestIndex].keyPromise.set_value(0);
+            firstRequest = requestIndex + 1;
+        }
+    }
+
+    writeQueuedRequests(batch, firstRequest, batch.size());
+}
+
+/*
+ * All inserts are written first and then all updates. An update of a model that
+ * is already written by the same requests is coalesced into that write, an insert
+ * writes every field. An insert of a model that is already queued fails, after an
+ * update the model had no row when the update was queued.
+ */
+void StorageInterface::writeQueuedRequests(std::vector<WriteBehindRequest>& batch, std::size_t firstRequest,
+    std::size_t endRequest)
+{
+    if (firstRequest == endRequest)
+    {
+        return;
+    }
+
+    enum class WriteList {None, Insert, Update};
+    struct RequestWrite
+    {
+        WriteList list;
+        std::size_t listIndex;
+        DBStatus status;
+    };
+    std::vector<RequestWrite> requestWrites;
+    std::unordered_map<const ModelBase*, std::size_t> writeRequestByModel;
+    ModelList insertModels;
+    ModelList updateModels;
+
+    for (std::size_t requestIndex = firstRequest; requestIndex < endRequest; ++requestIndex)
+    {
+        WriteBehindRequest& request = batch[requestIndex];
+        if (!request.model)
+        {
+            requestWrites.push_back({WriteList::None, 0, std::unexpected(std::string("NULL model pointer.\n"))});
+            continue;
+        }
+
+        auto [writeRequest, firstWrite] = writeRequestByModel.try_emplace(request.model.get(), requestWrites.size());
+        if (!firstWrite)
+        {
+            RequestWrite& coalescedWrite = requestWrites[writeRequest->second];
+            if (request.kind == WriteBehindRequest::Kind::Insert && coalescedWrite.list != WriteList::None)
+            {
+                requestWrites.push_back({WriteList::None, 0, std::unexpected(std::string(
+                    (coalescedWrite.list == WriteList::Insert)? "The model object is already queued for insert.\n" :
+                    "The model object is queued for update before its insert.\n"))});
+                continue;
+            }
+            if (request.kind == WriteBehindRequest::Kind::Update)
+            {
+                requestWrites.push_back(coalescedWrite);
+                continue;
+            }
+        }
+
+        if (request.kind == WriteBehindRequest::Kind::Insert)
+        {
+            requestWrites.push_back({WriteList::Insert, insertModels.size(), {}});
+            insertModels.push_back(request.model);
+        }
+        else
+        {
+            requestWrites.push_back({WriteList::Update, updateModels.size(), {}});
+            updateModels.push_back(request.model);
+        }
+        writeRequest->second = requestWrites.size() - 1;
+    }
+
+    std::vector<DBStatus> insertStatus;
+    std::vector<DBStatus> updateStatus;
+    try
+    {
+        if (!insertModels.empty())
+        {
+            insertStatus = insertOutsideTransaction(insertModels);
+        }
+        if (!updateModels.empty())
+        {
+            updateStatus = updateOutsideTransaction(updateModels);
+        }
+    }
+    catch(const std::exception& e)
+    {
+        std::string eMsg("In StorageInterface::writeQueuedRequests() ");
+        eMsg += e.what();
+        insertStatus.resize(insertModels.size(), std::unexpected(eMsg));
+        updateStatus.resize(updateModels.size(), std::unexpected(eMsg));
+    }
+
+    for (std::size_t requestIndex = firstRequest; requestIndex < endRequest; ++requestIndex)
+    {
+        WriteBehindRequest& request = batch[requestIndex];
+        const RequestWrite& requestWrite = requestWrites[requestIndex - firstRequest];
+        DBStatus status = (requestWrite.list == WriteList::Insert)? insertStatus[requestWrite.listIndex] :
+            (requestWrite.list == WriteList::Update)? updateStatus[requestWrite.listIndex] : requestWrite.status;
+
+        if (status)
+        {
+            request.keyPromise.set_value(request.model->getPrimaryKey());
+        }
+        else
+        {
+            request.keyPromise.set_value(std::unexpected(status.error()));
+        }
+
+        // The callback runs on the flusher thread, an exception would end it.
+        if (request.onComplete)
+        {
+            try
+            {
+                request.onComplete(request.model, status);
+            }
+            catch(...)
+            {
+            }
+        }
+    }
+}
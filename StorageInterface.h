@@ -0,0 +1,284 @@
+#ifndef STORAGEINTERFACE_H_
+#define STORAGEINTERFACE_H_
+
+/*
+ * StorageInterface:
+ * The storage operations the models and the user interface depend on. DBInterface
+ * stores the models in the MySQL database, InMemoryStorage keeps the same tables
+ * in memory so that everything above the storage can run and be profiled without
+ * a MySQL server.
+ */
+#include <chrono>
+#include <cstddef>
+#include <expected>
+#include <functional>
+#include <future>
+#include <initializer_list>
+#include "ModelBase.h"
+#include <memory>
+#include "PTS_DataField.h"
+#include <string>
+#include "TaskModel.h"
+#include <thread>
+#include "UserModel.h"
+#include <utility>
+#include <vector>
+
+using DBStatus = std::expected<void, std::string>;
+
+/*
+ * The values of the key columns of one row in a batch key lookup.
+ */
+using KeyTuple = std::vector<PTS_DataField>;
+
+/*
+ * One statement in a pipeline. An Insert stage inserts model, an Update stage
+ * writes the modified fields of model, a Select stage reads the model selected by
+ * whereArgs into model. status reports the outcome of the stage.
+ */
+struct PipelineStage
+{
+    enum class Kind {Insert, Update, Select};
+    Kind kind;
+    ModelShp model;
+    std::vector<WhereArg> whereArgs;
+    DBStatus status;
+};
+
+/*
+ * The fields a projected read loads, the primary key is always loaded.
+ */
+struct FieldProjection
+{
+    std::vector<std::string> fieldNames;
+};
+
+/*
+ * List queries deliver their models in batches. The MySQL database calls the
+ * callbacks on one of the DBInterface threads while the query waits for them, so
+ * a callback must not call back into the storage. DBInterface fails such a call
+ * with std::logic_error rather than waiting on itself.
+ */
+using UserBatchCallback = std::function<void(UserList& userBatch)>;
+using TaskBatchCallback = std::function<void(TaskList& taskBatch)>;
+
+/*
+ * Task pages are ordered by TaskID, or by RequiredDelivery and then TaskID. The
+ * cursor is opaque to the caller: an empty cursor requests the first page, the
+ * nextCursor of a page requests the page after it and is empty on the last page.
+ */
+enum class TaskPageOrder {TaskID, RequiredDelivery};
+struct TaskPage
+{
+    TaskList tasks;
+    std::string nextCursor;
+};
+
+/*
+ * The database stamps LastModified when a row is written, but the row can only be
+ * read once its transaction commits and rows with later stamps may have been read
+ * before that. A change query reads the changes stamped up to ChangeOverlapWindow
+ * before lastModified again and skips the seenChanges, the (LastModified, TaskID)
+ * of the changes it already returned within that window. A change that commits
+ * more than ChangeOverlapWindow after it was stamped can be missed.
+ * The changed tasks are returned in (LastModified, TaskID) order, ChangeWatermark{}
+ * returns all of them.
+ */
+using ChangeStamp = std::chrono::time_point<std::chrono::system_clock>;
+constexpr std::chrono::seconds ChangeOverlapWindow{60};
+struct ChangeWatermark
+{
+    ChangeStamp lastModified;
+    std::vector<std::pair<ChangeStamp, std::size_t>> seenChanges;
+};
+struct ChangedTasks
+{
+    TaskList tasks;
+    ChangeWatermark nextWatermark;
+};
+
+/*
+ * A task and the tasks whose ParentTask it is, children are in TaskID order. The
+ * root of a subtree has no parent and depth 0. MySQL ends a recursive query after
+ * cte_max_recursion_depth levels, 1000 by default, so a subtree can't be deeper.
+ */
+constexpr std::size_t MaxTaskSubtreeDepth = 1000;
+struct TaskTreeNode
+{
+    TaskModel_shp task;
+    std::weak_ptr<TaskTreeNode> parent;
+    std::vector<std::shared_ptr<TaskTreeNode>> children;
+    std::size_t depth;
+};
+using TaskTreeNodeShp = std::shared_ptr<TaskTreeNode>;
+
+/*
+ * The key future of a write-behind request receives the primary key of the model
+ * once it has been written, or the error. onComplete is called on the thread that
+ * wrote the model after the future has become ready. An exception thrown by
+ * onComplete is discarded.
+ */
+using WriteKeyResult = std::expected<std::size_t, std::string>;
+using WriteCompletionCallback = std::function<void(ModelShp model, const DBStatus& status)>;
+class WriteBehindQueue;
+struct WriteBehindRequest;
+
+class StorageInterface
+{
+public:
+    StorageInterface();
+    virtual ~StorageInterface();
+    std::string getAllErrorMessages() const { return errorMessages; };
+    virtual bool beginTransaction() = 0;
+    virtual bool commit() = 0;
+    virtual bool rollback() = 0;
+    virtual bool insertIntoDataBase(ModelBase& model) = 0;
+    virtual bool insertManyIntoDataBase(ModelList& models) = 0;
+    virtual bool updateInDataBase(ModelBase& model) = 0;
+    virtual bool updateManyInDataBase(ModelList& models) = 0;
+    virtual bool executePipeline(std::vector<PipelineStage>& stages) = 0;
+    virtual bool getUniqueModelFromDB(ModelShp model, std::vector<WhereArg> whereArgs) = 0;
+    bool getUniqueModelFromDB(ModelShp model, std::initializer_list<WhereArg> whereArgs)
+    {
+        std::vector<WhereArg> vWhereArgs{whereArgs};
+        return getUniqueModelFromDB(model, vWhereArgs);
+    };
+/*
+ * The row is read into model, from the model cache if the row is cached. Returns
+ * model, or nullptr on errors. The cache keeps its own copy, changing model
+ * doesn't change the cached values.
+ */
+    virtual ModelShp getCachedModelFromDB(ModelShp model, std::vector<WhereArg> whereArgs) = 0;
+/*
+ * models[i] receives the row whose keyColumnNames are equal to keys[i], all models
+ * must be from the same table. A key without a row is reported for its model.
+ */
+    virtual bool getUniqueModelsFromDB(ModelList& models, const std::vector<std::string>& keyColumnNames,
+        const std::vector<KeyTuple>& keys) = 0;
+    virtual bool getAllUsers(UserBatchCallback onBatch) = 0;
+    virtual bool getAllTasksForUser(std::size_t userID, TaskBatchCallback onBatch) = 0;
+/*
+ * Each page continues from the position stored in the cursor instead of skipping
+ * the earlier rows, so a deep page costs the same as the first one.
+ */
+    virtual bool getTaskPageForUser(std::size_t userID, TaskPageOrder order, std::size_t pageSize,
+        const std::string& cursor, TaskPage& page) = 0;
+/*
+ * Returns the tasks of the user that were inserted or updated since the query
+ * that returned watermark.
+ */
+    virtual bool getTasksChangedSince(std::size_t userID, const ChangeWatermark& watermark,
+        ChangedTasks& changes) = 0;
+/*
+ * Loads the task rootTaskID and every task below it down to maxDepth levels, a
+ * maxDepth above MaxTaskSubtreeDepth is an error. A task that is reached a second
+ * time through a ParentTask cycle is left out.
+ */
+    virtual bool getTaskSubtree(std::size_t rootTaskID, std::size_t maxDepth, TaskTreeNodeShp& root) = 0;
+/*
+ * Projected reads load only the primary key and the projected fields, the other
+ * fields are marked not loaded. loadMissingFields() reads the fields of the model
+ * that are not loaded by primary key, a field that was set since the read keeps
+ * its value. It reports errors only through its status.
+ */
+    virtual bool getProjectedModelFromDB(ModelShp model, std::vector<WhereArg> whereArgs,
+        FieldProjection projection) = 0;
+    virtual bool getAllUsers(UserBatchCallback onBatch, FieldProjection projection) = 0;
+    virtual DBStatus loadMissingFields(ModelBase& model) = 0;
+    UserList getAllUsers();
+    TaskList getAllTasksForUser(UserModel_shp user);
+    TaskList getAllTasksForUser(UserModel& user);
+/*
+ * Write-behind, enabled by a write behind depth above 0. The calls return once
+ * the request is queued and only block while the queue is full. The model belongs
+ * to the queue until its future is ready, it must not be changed or written by
+ * other calls before that. The same model may be queued again: since it doesn't
+ * change while queued, an update after its insert or update in the same batch
+ * shares that write, and an insert after its insert or update fails. Queued writes
+ * are never part of a transaction, each batch is written and committed on its own
+ * whether or not a transaction is open. Without a queue the model is written
+ * before the call returns.
+ */
+    std::future<WriteKeyResult> insertWriteBehind(ModelShp model, WriteCompletionCallback onComplete = nullptr);
+    std::future<WriteKeyResult> updateWriteBehind(ModelShp model, WriteCompletionCallback onComplete = nullptr);
+    void flushWriteBehind();
+
+protected:
+    void clearPreviousErrors() { errorMessages.clear(); };
+    void appendErrorMessage(std::string newError) { errorMessages.append(newError); };
+    bool reportStatus(DBStatus status)
+    {
+        if (!status)
+        {
+            appendErrorMessage(status.error());
+        }
+        return status.has_value();
+    };
+    DBStatus validateModelForInsert(ModelBase& model);
+    DBStatus validateModelForUpdate(ModelBase& model);
+/*
+ * The status of an update that matched no row, the row was deleted or the primary
+ * key is wrong. The model keeps its modified fields.
+ */
+    DBStatus reportNoRowUpdated(ModelBase& model);
+/*
+ * Values that the database's collation considers equal have the same comparison
+ * value.
+ */
+    static std::string makeComparisonValue(const DataValueType& value);
+    bool reportModelStatus(const std::vector<DBStatus>& modelStatus);
+    bool reportPipelineStatus(const std::vector<PipelineStage>& stages);
+/*
+ * The sort values of the last task on a page. A cursor is only accepted by the
+ * listing that created it, lastDueDate isn't used for TaskPageOrder::TaskID.
+ */
+    struct TaskPageCursor
+    {
+        TaskPageOrder order;
+        std::size_t userID;
+        std::chrono::year_month_day lastDueDate;
+        std::size_t lastTaskID;
+    };
+    static std::string makeTaskPageCursor(const TaskPageCursor& position);
+    static std::expected<TaskPageCursor, std::string> parseTaskPageCursor(const std::string& cursor,
+        TaskPageOrder order, std::size_t userID);
+/*
+ * The slots of the primary key and the projected fields in slot order. Unknown
+ * field names are reported here, before anything is read.
+ */
+    static std::expected<std::vector<std::size_t>, std::string> findProjectedSlots(const ModelBase& model,
+        const FieldProjection& projection);
+/*
+ * windowTasks are the tasks of the user stamped at or after getChangeWindowStart()
+ * in (LastModified, TaskID) order.
+ */
+    static ChangeStamp getChangeWindowStart(const ChangeWatermark& watermark);
+    static ChangedTasks skipSeenChanges(const ChangeWatermark& watermark, TaskList windowTasks);
+    static DBStatus validateTaskSubtreeDepth(std::size_t maxDepth);
+/*
+ * tasks must list every parent before its children, the first task is the root.
+ */
+    static std::expected<TaskTreeNodeShp, std::string> buildTaskTree(std::size_t rootTaskID, const TaskList& tasks);
+/*
+ * The flusher thread calls the write functions of the subclass, a subclass that
+ * starts write-behind must stop it in its destructor. The write functions return
+ * the status of each model and don't report errors through errorMessages.
+ */
+    void startWriteBehind(std::size_t queueDepth);
+    void stopWriteBehind();
+    virtual std::vector<DBStatus> insertOutsideTransaction(ModelList& models) = 0;
+    virtual std::vector<DBStatus> updateOutsideTransaction(ModelList& models) = 0;
+
+    std::string errorMessages;
+
+private:
+    std::future<WriteKeyResult> queueWrite(WriteBehindRequest request);
+    void runWriteBehindFlusher();
+    void flushWriteBehindBatch(std::vector<WriteBehindRequest>& batch);
+    void writeQueuedRequests(std::vector<WriteBehindRequest>& batch, std::size_t firstRequest, std::size_t endRequest);
+
+    std::unique_ptr<WriteBehindQueue> writeBehindQueue;
+    std::jthread writeBehindFlusher;
+};
+
+#endif  // STORAGEINTERFACE_H_
@@ -3,9 +3,12 @@
 #include <iostream>
 #include <memory>
 #include "ModelBase.h"
+#include "ModelSchema.h"
 #include <string>
+#include <string_view>
 #include "TaskModel.h"
 #include "UserModel.h"
+#include <utility>
 #include <vector>
 
 static const TaskModel::TaskStatus UnknowStatus = static_cast<TaskModel::TaskStatus>(-1);
@@ -20,26 +23,39 @@ static std::vector<GenericDictionary<TaskModel::TaskStatus, std::string>::DictTy
 
 static GenericDictionary<TaskModel::TaskStatus, std::string> taskStatusConversionTable(statusConversionsDefs);
 
-TaskModel::TaskModel()
-    : ModelBase("TaskModel", "Tasks", "TaskID")
-{
-    addDataField("CreatedBy", PTS_DataField::PTS_DB_FieldType::Key, true);
-    addDataField("AsignedTo", PTS_DataField::PTS_DB_FieldType::Key, true);
-    addDataField("Description", PTS_DataField::PTS_DB_FieldType::VarChar256, true);
-    addDataField("ParentTask", PTS_DataField::PTS_DB_FieldType::Key);
-    addDataField("Status", PTS_DataField::PTS_DB_FieldType::UnsignedInt);
-    addDataField("PercentageComplete", PTS_DataField::PTS_DB_FieldType::Double, true);
-    addDataField("CreatedOn", PTS_DataField::PTS_DB_FieldType::Date, true);
-    addDataField("RequiredDelivery", PTS_DataField::PTS_DB_FieldType::Date, true);
-    addDataField("ScheduledStart", PTS_DataField::PTS_DB_FieldType::Date, true);
-    addDataField("ActualStart", PTS_DataField::PTS_DB_FieldType::Date);
-    addDataField("EstimatedCompletion", PTS_DataField::PTS_DB_FieldType::Date);
-    addDataField("Completed", PTS_DataField::PTS_DB_FieldType::Date);
-    addDataField("EstimatedEffortHours", PTS_DataField::PTS_DB_FieldType::UnsignedInt, true);
-    addDataField("ActualEffortHours", PTS_DataField::PTS_DB_FieldType::Double, true);
-    addDataField("SchedulePriorityGroup", PTS_DataField::PTS_DB_FieldType::UnsignedInt, true);
-    addDataField("PriorityInGroup", PTS_DataField::PTS_DB_FieldType::UnsignedInt, true);
+/*
+ * The columns of Tasks in PlannerTaskScheduleDB.sql.
+ */
+const ModelSchema& TaskModel::getSchema()
+{
+    static const ModelSchema taskSchema = []() {
+        ModelSchema schema("TaskModel", "Tasks", "TaskID");
+        schema.addField(CreatedBy{}, "CreatedBy", true);
+        schema.addField(AsignedTo{}, "AsignedTo", true);
+        schema.addField(Description{}, "Description", true);
+        schema.addField(ParentTask{}, "ParentTask");
+        schema.addField(Status{}, "Status");
+        schema.addField(PercentageComplete{}, "PercentageComplete", true);
+        schema.addField(CreatedOn{}, "CreatedOn", true);
+        schema.addField(RequiredDelivery{}, "RequiredDelivery", true);
+        schema.addField(ScheduledStart{}, "ScheduledStart", true);
+        schema.addField(ActualStart{}, "ActualStart");
+        schema.addField(EstimatedCompletion{}, "EstimatedCompletion");
+        schema.addField(Completed{}, "Completed");
+        schema.addField(EstimatedEffortHours{}, "EstimatedEffortHours", true);
+        schema.addField(ActualEffortHours{}, "ActualEffortHours", true);
+        schema.addField(SchedulePriorityGroup{}, "SchedulePriorityGroup", true);
+        schema.addField(PriorityInGroup{}, "PriorityInGroup", true);
+        schema.addGeneratedField(LastModified{}, "LastModified");
+        return schema;
+    }();
+
+    return taskSchema;
+}
 
+TaskModel::TaskModel()
+    : ModelBase(getSchema())
+{
     std::chrono::year_month_day today = getTodaysDate();
     setCreationDate(today);
 }
@@ -51,7 +67,7 @@ TaskModel::TaskModel(UserModel_shp creator)
     setAssignToID(creator->getUserID());
 }
 
-TaskModel::TaskModel(UserModel_shp creator, std::string description)
+TaskModel::TaskModel(UserModel_shp creator, std::string_view description)
 : TaskModel()
 {
     setCreatorID(creator->getUserID());
@@ -79,117 +95,127 @@ std::size_t TaskModel::getTaskID() const
 
 std::size_t TaskModel::getCreatorID() const 
 {
-    return getKeyFieldValue("CreatedBy");
+    return get<CreatedBy>();
 }
 
 std::size_t TaskModel::getAssignToID() const 
 {
-    return getKeyFieldValue("AsignedTo");
+    return get<AsignedTo>();
 }
 
 std::string TaskModel::getDescription() const 
 {
-    return getStringFieldValue("Description") ;
+    return get<Description>();
+}
+
+std::string_view TaskModel::getDescriptionView() const
+{
+    return getView<Description>();
 }
 
 TaskModel::TaskStatus TaskModel::getStatus() const 
 {
-    return statusFromInt(getUnsignedIntFieldValue("Status"));
+    return statusFromInt(get<Status>());
 }
 
 unsigned int TaskModel::getStatusIntVal() const
 {
-    return getUnsignedIntFieldValue("Status");
+    return get<Status>();
 }
 
 std::size_t TaskModel::getParentTaskID() const 
 {
-    return getKeyFieldValue("ParentTask");
+    return get<ParentTask>();
 }
 
 double TaskModel::getPercentageComplete() const 
 {
-    return getDoubleFieldValue("PercentageComplete");
+    return get<PercentageComplete>();
 }
 
 std::chrono::year_month_day TaskModel::getCreationDate() const 
 {
-    return getDateFieldValue("CreatedOn");
+    return get<CreatedOn>();
 }
 
 std::chrono::year_month_day TaskModel::getDueDate() const 
 {
-    return getDateFieldValue("RequiredDelivery");
+    return get<RequiredDelivery>();
 }
 
 std::chrono::year_month_day TaskModel::getScheduledStart() const 
 {
-    return getDateFieldValue("ScheduledStart");
+    return get<ScheduledStart>();
 }
 
 std::chrono::year_month_day TaskModel::getactualStartDate() const 
 {
-    return getDateFieldValue("ActualStart");
+    return get<ActualStart>();
 }
 
 std::chrono::year_month_day TaskModel::getEstimatedCompletion() const 
 {
-return getDateFieldValue("EstimatedCompletion");
+    return get<EstimatedCompletion>();
 }
 
 std::chrono::year_month_day TaskModel::getCompletionDate() const
 {
-    return getDateFieldValue("Completed");
+    return get<Completed>();
 }
 
 unsigned int TaskModel::getEstimatedEffort() const
 {
-    return getUnsignedIntFieldValue("EstimatedEffortHours");
+    return get<EstimatedEffortHours>();
 }
 
 double TaskModel::getactualEffortToDate() const
 {
-    return getDoubleFieldValue("ActualEffortHours");
+    return get<ActualEffortHours>();
 }
 
 unsigned int TaskModel::getPriorityGroup() const
 {
-    return getUnsignedIntFieldValue("SchedulePriorityGroup");
+    return get<SchedulePriorityGroup>();
 }
 
 unsigned int TaskModel::getPriority() const
 {
-    return getUnsignedIntFieldValue("PriorityInGroup");
+    return get<PriorityInGroup>();
+}
+
+std::chrono::time_point<std::chrono::system_clock> TaskModel::getLastModified() const
+{
+    return get<LastModified>();
 }
 
 bool TaskModel::hasOptionalFieldStatus() const
 {
-    return fieldHasValue("Status");
+    return has<Status>();
 }
 
 bool TaskModel::hasOptionalFieldParentTaskID() const
 {
-    return fieldHasValue("ParentTask");
+    return has<ParentTask>();
 }
 
 bool TaskModel::hasOptionalFieldActualStartDate() const
 {
-    return fieldHasValue("ActualStart");
+    return has<ActualStart>();
 }
 
 bool TaskModel::hasOptionalFieldEstimatedCompletion() const
 {
-    return fieldHasValue("EstimatedCompletion");
+    return has<EstimatedCompletion>();
 }
 
 bool TaskModel::hasOptionalFieldCompletionDate() const
 {
-    return fieldHasValue("Completed");
+    return has<Completed>();
 }
 
 void TaskModel::setCreatorID(std::size_t creatorID)
 {
-    setFieldValue("CreatedBy", creatorID);
+    set<CreatedBy>(creatorID);
 }
 
 void TaskModel::setCreatorID(UserModel_shp creator)
@@ -199,7 +225,7 @@ void TaskModel::setCreatorID(UserModel_shp creator)
 
 void TaskModel::setAssignToID(std::size_t assignedID)
 {
-    setFieldValue("AsignedTo", assignedID);
+    set<AsignedTo>(assignedID);
 }
 
 void TaskModel::setAssignToID(UserModel_shp assignedUser)
@@ -207,14 +233,14 @@ void TaskModel::setAssignToID(UserModel_shp assignedUser)
     setAssignToID(assignedUser->getPrimaryKey());
 }
 
-void TaskModel::setDescription(std::string description)
+void TaskModel::setDescription(std::string_view description)
 {
-    setFieldValue("Description", description);
+    set<Description>(description);
 }
 
 void TaskModel::setStatus(TaskModel::TaskStatus status)
 {
-    setFieldValue("Status", static_cast<unsigned int>(status));
+    set<Status>(static_cast<unsigned int>(status));
 }
 
 void TaskModel::setStatus(std::string statusStr)
@@ -228,7 +254,7 @@ void TaskModel::setStatus(std::string statusStr)
 
 void TaskModel::setParentTaskID(std::size_t parentTaskID)
 {
-    setFieldValue("ParentTask", parentTaskID);
+    set<ParentTask>(parentTaskID);
 }
 
 void TaskModel::setParentTaskID(std::shared_ptr<TaskModel> parentTask)
@@ -238,52 +264,52 @@ void TaskModel::setParentTaskID(std::shared_ptr<TaskModel> parentTask)
 
 void TaskModel::setPercentageComplete(double percentComplete)
 {
-    setFieldValue("PercentageComplete", percentComplete);
+    set<PercentageComplete>(percentComplete);
 }
 
 void TaskModel::setCreationDate(std::chrono::year_month_day creationDate)
 {
-    setFieldValue("CreatedOn", creationDate);
+    set<CreatedOn>(creationDate);
 }
 
 void TaskModel::setDueDate(std::chrono::year_month_day dueDate)
 {
-    setFieldValue("RequiredDelivery", dueDate);
+    set<RequiredDelivery>(dueDate);
 }
 
 void TaskModel::setScheduledStart(std::chrono::year_month_day startDate)
 {
-    setFieldValue("ScheduledStart", startDate);
+    set<ScheduledStart>(startDate);
 }
 
 void TaskModel::setactualStartDate(std::chrono::year_month_day startDate)
 {
-    setFieldValue("ActualStart", startDate);
+    set<ActualStart>(startDate);
 }
 
 void TaskModel::setEstimatedCompletion(std::chrono::year_month_day completionDate)
 {
-    setFieldValue("EstimatedCompletion", completionDate);
+    set<EstimatedCompletion>(completionDate);
 }
 
 void TaskModel::setCompletionDate(std::chrono::year_month_day completionDate)
 {
-    setFieldValue("Completed", completionDate);
+    set<Completed>(completionDate);
 }
 
 void TaskModel::setEstimatedEffort(unsigned int estimatedHours)
 {
-    setFieldValue("EstimatedEffortHours", estimatedHours);
+    set<EstimatedEffortHours>(estimatedHours);
 }
 
 void TaskModel::setactualEffortToDate(double effortHoursYTD)
 {
-    setFieldValue("ActualEffortHours", effortHoursYTD);
+    set<ActualEffortHours>(effortHoursYTD);
 }
 
 void TaskModel::setPriorityGroup(unsigned int priorityGroup)
 {
-    setFieldValue("SchedulePriorityGroup", priorityGroup);
+    set<SchedulePriorityGroup>(priorityGroup);
 }
 
 void TaskModel::setPriorityGroup(const char priorityGroup)
@@ -294,7 +320,7 @@ void TaskModel::setPriorityGroup(const char priorityGroup)
 
 void TaskModel::setPriority(unsigned int priority)
 {
-    setFieldValue("PriorityInGroup", priority);
+    set<PriorityInGroup>(priority);
 }
 
 void TaskModel::addEffortHours(double hours)
@@ -5,7 +5,9 @@
 #include <iostream>
 #include <memory>
 #include "ModelBase.h"
+#include "ModelSchema.h"
 #include <string>
+#include <string_view>
 #include "UserModel.h"
 #include <vector>
 
@@ -17,16 +19,44 @@ public:
         Not_Started, On_Hold, Waiting_for_Dependency, Work_in_Progress, Complete
     };
 
+/*
+ * The fields in schema slot order, for get() and set().
+ */
+    using TaskID = FieldTag<0, PTS_DataField::PTS_DB_FieldType::Key>;
+    using CreatedBy = FieldTag<1, PTS_DataField::PTS_DB_FieldType::Key>;
+    using AsignedTo = FieldTag<2, PTS_DataField::PTS_DB_FieldType::Key>;
+    using Description = FieldTag<3, PTS_DataField::PTS_DB_FieldType::VarChar256>;
+    using ParentTask = FieldTag<4, PTS_DataField::PTS_DB_FieldType::Key>;
+    using Status = FieldTag<5, PTS_DataField::PTS_DB_FieldType::UnsignedInt>;
+    using PercentageComplete = FieldTag<6, PTS_DataField::PTS_DB_FieldType::Double>;
+    using CreatedOn = FieldTag<7, PTS_DataField::PTS_DB_FieldType::Date>;
+    using RequiredDelivery = FieldTag<8, PTS_DataField::PTS_DB_FieldType::Date>;
+    using ScheduledStart = FieldTag<9, PTS_DataField::PTS_DB_FieldType::Date>;
+    using ActualStart = FieldTag<10, PTS_DataField::PTS_DB_FieldType::Date>;
+    using EstimatedCompletion = FieldTag<11, PTS_DataField::PTS_DB_FieldType::Date>;
+    using Completed = FieldTag<12, PTS_DataField::PTS_DB_FieldType::Date>;
+    using EstimatedEffortHours = FieldTag<13, PTS_DataField::PTS_DB_FieldType::UnsignedInt>;
+    using ActualEffortHours = FieldTag<14, PTS_DataField::PTS_DB_FieldType::Double>;
+    using SchedulePriorityGroup = FieldTag<15, PTS_DataField::PTS_DB_FieldType::UnsignedInt>;
+    using PriorityInGroup = FieldTag<16, PTS_DataField::PTS_DB_FieldType::UnsignedInt>;
+    using LastModified = FieldTag<17, PTS_DataField::PTS_DB_FieldType::TimeStamp>;
+    static_assert(fieldSlotsInOrder<TaskID, CreatedBy, AsignedTo, Description, ParentTask, Status,
+        PercentageComplete, CreatedOn, RequiredDelivery, ScheduledStart, ActualStart, EstimatedCompletion, Completed,
+        EstimatedEffortHours, ActualEffortHours, SchedulePriorityGroup, PriorityInGroup, LastModified>(),
+        "TaskModel field tags are not numbered in schema slot order");
+
     TaskModel();
     TaskModel(UserModel_shp creator);
-    TaskModel(UserModel_shp creator, std::string descriptionIn);
+    TaskModel(UserModel_shp creator, std::string_view descriptionIn);
     virtual ~TaskModel() = default;
+    static const ModelSchema& getSchema();
 
     void addEffortHours(double hours);
     std::size_t getTaskID() const;
     std::size_t getCreatorID() const;
     std::size_t getAssignToID() const;
     std::string getDescription() const;
+    std::string_view getDescriptionView() const;
     TaskModel::TaskStatus getStatus() const;
     unsigned int getStatusIntVal() const;
     std::size_t getParentTaskID() const;
@@ -41,6 +71,7 @@ public:
     double getactualEffortToDate() const;
     unsigned int getPriorityGroup() const;
     unsigned int getPriority() const;
+    std::chrono::time_point<std::chrono::system_clock> getLastModified() const;
     bool hasOptionalFieldStatus() const;
     bool hasOptionalFieldParentTaskID() const;
     bool hasOptionalFieldActualStartDate() const;
@@ -50,7 +81,7 @@ public:
     void setCreatorID(UserModel_shp creator);
     void setAssignToID(std::size_t assignedID);
     void setAssignToID(UserModel_shp assignedUser);
-    void setDescription(std::string description);
+    void setDescription(std::string_view description);
     void setStatus(TaskModel::TaskStatus status);
     void setStatus(std::string statusStr);
     void setParentTaskID(std::size_t parentTaskID);
@@ -74,18 +105,17 @@ public:
     friend std::ostream& operator<<(std::ostream& os, const TaskModel& obj)
     {
         os << "TaskModel:\n";
-        os << obj.primaryKeyFieldName;
+        os << obj.getPrimaryKeyName();
         os << "Column Names: ";
-        for (const auto& [key, value] : obj.dataFields)
+        for (const auto& field : obj.fields)
         {
-            os << key;
+            os << field.getColumnName();
             os << ", ";
         }
         os << "\n";
-        for (const auto& [key, value] : obj.dataFields)
+        for (std::size_t slot = 0; slot < obj.fields.size(); ++slot)
         {
-            PTS_DataField_shp currentField = value;
-            os << currentField->fieldInfo();
+            os << obj.getFieldInfo(slot);
             os << "\n";
         }
         return os;
@@ -1,51 +1,70 @@
+#include <chrono>
 #include <exception>
+#include "ModelSchema.h"
 #include "UserModel.h"
 #include <stdexcept>
 #include <string>
+#include <string_view>
+#include <utility>
+
+/*
+ * The columns of UserProfile in PlannerTaskScheduleDB.sql.
+ */
+const ModelSchema& UserModel::getSchema()
+{
+    static const ModelSchema userSchema = []() {
+        ModelSchema schema("UserModel", "UserProfile", "UserID");
+        schema.addField(LastName{}, "LastName", true);
+        schema.addField(FirstName{}, "FirstName", true);
+        schema.addField(MiddleInitial{}, "MiddleInitial");
+        schema.addField(LoginName{}, "LoginName", true);
+        schema.addField(HashedPassWord{}, "HashedPassWord", true);
+        schema.addField(EmailAddress{}, "EmailAddress", true);
+        schema.addField(ScheduleDayStart{}, "ScheduleDayStart", true);
+        schema.addField(ScheduleDayEnd{}, "ScheduleDayEnd", true);
+        schema.addField(IncludePriorityInSchedule{}, "IncludePriorityInSchedule");
+        schema.addField(IncludeMinorPriorityInSchedule{}, "IncludeMinorPriorityInSchedule");
+        schema.addField(UseLettersForMajorPriority{}, "UseLettersForMajorPriority");
+        schema.addField(SeparatePriorityWithDot{}, "SeparatePriorityWithDot");
+        schema.addGeneratedField(LastModified{}, "LastModified");
+        return schema;
+    }();
+
+    return userSchema;
+}
 
 UserModel::UserModel()
-    : ModelBase("UserModel", "UserProfile", "UserID")
-{
-    addDataField("LastName", PTS_DataField::PTS_DB_FieldType::VarChar45, true);
-    addDataField("FirstName", PTS_DataField::PTS_DB_FieldType::VarChar45, true);
-    addDataField("MiddleInitial", PTS_DataField::PTS_DB_FieldType::VarChar45);
-    addDataField("LoginName",  PTS_DataField::PTS_DB_FieldType::VarChar45, true);
-    addDataField("HashedPassWord", PTS_DataField::PTS_DB_FieldType::TinyText, true);
-    addDataField("EmailAddress", PTS_DataField::PTS_DB_FieldType::VarChar256, true);
-    addDataField("ScheduleDayStart", PTS_DataField::PTS_DB_FieldType::VarChar45, true);
-    addDataField("ScheduleDayEnd", PTS_DataField::PTS_DB_FieldType::VarChar45, true);
-    addDataField("IncludePriorityInSchedule", PTS_DataField::PTS_DB_FieldType::Boolean);
-    addDataField("IncludeMinorPriorityInSchedule", PTS_DataField::PTS_DB_FieldType::Boolean);
-    addDataField("UseLettersForMajorPriority", PTS_DataField::PTS_DB_FieldType::Boolean);
-    addDataField("SeparatePriorityWithDot", PTS_DataField::PTS_DB_FieldType::Boolean);
-    initFieldValueNotChanged("IncludePriorityInSchedule", true);
-    initFieldValueNotChanged("IncludeMinorPriorityInSchedule", true);
-    initFieldValueNotChanged("UseLettersForMajorPriority", true);
-    initFieldValueNotChanged("SeparatePriorityWithDot", false);
-    initFieldValueNotChanged("ScheduleDayStart", "8:30 AM");
-    initFieldValueNotChanged("ScheduleDayEnd", "5:00 PM");
-}
-
-UserModel::UserModel(std::string lastIn, std::string firstIn, std::string middleIIn, std::string email)
+    : ModelBase(getSchema())
+{
+    initNotChanged<IncludePriorityInSchedule>(true);
+    initNotChanged<IncludeMinorPriorityInSchedule>(true);
+    initNotChanged<UseLettersForMajorPriority>(true);
+    initNotChanged<SeparatePriorityWithDot>(false);
+    initNotChanged<ScheduleDayStart>("8:30 AM");
+    initNotChanged<ScheduleDayEnd>("5:00 PM");
+}
+
+UserModel::UserModel(std::string_view lastIn, std::string_view firstIn, std::string_view middleIIn,
+    std::string_view email)
     : UserModel()
 {
-    setFieldValue("LastName", lastIn);
-    setFieldValue("FirstName", firstIn);
-    setFieldValue("MiddleInitial", middleIIn);
-    setFieldValue("EmailAddress", email);
-    createLoginBasedOnUserName(lastIn, firstIn, middleIIn);
+    set<LastName>(lastIn);
+    set<FirstName>(firstIn);
+    set<MiddleInitial>(middleIIn);
+    set<EmailAddress>(email);
+    createLoginBasedOnUserName(getLastNameView(), getFirstNameView(), getMiddleInitialView());
 }
 
 void UserModel::autoGenerateLoginAndPassword()
 {
-    if (!fieldHasValue("LoginName") && !fieldHasValue("HashedPassWord"))
+    if (!has<LoginName>() && !has<HashedPassWord>())
     {
-        createLoginBasedOnUserName(getLastName(), getFirstName(), getMiddleInitial());
+        createLoginBasedOnUserName(getLastNameView(), getFirstNameView(), getMiddleInitialView());
     }
 }
 
 void UserModel::createLoginBasedOnUserName(
-    const std::string& lastName, const std::string& firstName, const std::string& middleInitial)
+    std::string_view lastName, std::string_view firstName, std::string_view middleInitial)
 {
     std::string tempLoginName(lastName);
     tempLoginName += firstName;
@@ -55,47 +74,87 @@ void UserModel::createLoginBasedOnUserName(
     }
 
     setLoginName(tempLoginName);
-    setPassword(tempLoginName);
+    setPassword(std::move(tempLoginName));
 }
 
 std::string UserModel::getLastName() const
 {
-    return getStringFieldValue("LastName");
+    return get<LastName>();
+}
+
+std::string_view UserModel::getLastNameView() const
+{
+    return getView<LastName>();
 }
 
 std::string UserModel::getFirstName() const
 {
-    return getStringFieldValue("FirstName");
+    return get<FirstName>();
+}
+
+std::string_view UserModel::getFirstNameView() const
+{
+    return getView<FirstName>();
 }
 
 std::string UserModel::getMiddleInitial() const
 {
-    return getStringFieldValue("MiddleInitial");
+    return get<MiddleInitial>();
+}
+
+std::string_view UserModel::getMiddleInitialView() const
+{
+    return getView<MiddleInitial>();
 }
 
 std::string UserModel::getEmail() const
 {
-    return getStringFieldValue("EmailAddress");
+    return get<EmailAddress>();
+}
+
+std::string_view UserModel::getEmailView() const
+{
+    return getView<EmailAddress>();
 }
 
 std::string UserModel::getLoginName() const
 {
-    return getStringFieldValue("LoginName");
+    return get<LoginName>();
+}
+
+std::string_view UserModel::getLoginNameView() const
+{
+    return getView<LoginName>();
 }
 
 std::string UserModel::getPassword() const
 {
-    return getStringFieldValue("HashedPassWord"); 
+    return get<HashedPassWord>(); 
+}
+
+std::string_view UserModel::getPasswordView() const
+{
+    return getView<HashedPassWord>();
 }
 
 std::string UserModel::getStartTime() const
 {
-    return getStringFieldValue("ScheduleDayStart"); 
+    return get<ScheduleDayStart>(); 
+}
+
+std::string_view UserModel::getStartTimeView() const
+{
+    return getView<ScheduleDayStart>();
 }
 
 std::string UserModel::getEndTime() const
 {
-    return getStringFieldValue("ScheduleDayEnd"); 
+    return get<ScheduleDayEnd>(); 
+}
+
+std::string_view UserModel::getEndTimeView() const
+{
+    return getView<ScheduleDayEnd>();
 }
 
 std::size_t UserModel::getUserID() const
@@ -103,83 +162,88 @@ std::size_t UserModel::getUserID() const
     return getPrimaryKey();
 }
 
+std::chrono::time_point<std::chrono::system_clock> UserModel::getLastModified() const
+{
+    return get<LastModified>();
+}
+
 bool UserModel::isPriorityInSchedule() const
 {
-    return getBoolFieldValue("IncludePriorityInSchedule");
+    return get<IncludePriorityInSchedule>();
 }
 
 bool UserModel::isMinorPriorityInSchedule() const 
 {
-    return getBoolFieldValue("IncludeMinorPriorityInSchedule");
+    return get<IncludeMinorPriorityInSchedule>();
 }
 
 bool UserModel::isUsingLettersForMaorPriority() const
 {
-    return getBoolFieldValue("UseLettersForMajorPriority");
+    return get<UseLettersForMajorPriority>();
 }
 
 bool UserModel::isSeparatingPriorityWithDot() const
 {
-    return getBoolFieldValue("SeparatePriorityWithDot");
+    return get<SeparatePriorityWithDot>();
 }
 
-void UserModel::setLastName(const std::string& lastName)
+void UserModel::setLastName(std::string_view lastName)
 {
-    setFieldValue("LastName", lastName);
+    set<LastName>(lastName);
 };
 
-void UserModel::setFirstName(const std::string& firstName)
+void UserModel::setFirstName(std::string_view firstName)
 {
-    setFieldValue("FirstName", firstName);
+    set<FirstName>(firstName);
 }
 
-void UserModel::setMiddleInitial(const std::string& middleinit)
+void UserModel::setMiddleInitial(std::string_view middleinit)
 {
-    setFieldValue("MiddleInitial", middleinit);
+    set<MiddleInitial>(middleinit);
 }
 
-void UserModel::setEmail(const std::string& email)
+void UserModel::setEmail(std::string_view email)
 {
-    setFieldValue("EmailAddress", email);
+    set<EmailAddress>(email);
 }
 
-void UserModel::setLoginName(const std::string& loginName)
+void UserModel::setLoginName(std::string_view loginName)
 {
-    setFieldValue("LoginName", loginName);
+    set<LoginName>(loginName);
 }
 
-void UserModel::setPassword(const std::string& password)
+void UserModel::setPassword(std::string_view password)
 {
-    setFieldValue("HashedPassWord", password);
+    set<HashedPassWord>(password);
 };
 
-void UserModel::setStartTime(const std::string& startTime)
+void UserModel::setStartTime(std::string_view startTime)
 {
-    setFieldValue("ScheduleDayStart", startTime); 
+    set<ScheduleDayStart>(startTime); 
 }
 
-void UserModel::setEndTime(const std::string& endTime)
+void UserModel::setEndTime(std::string_view endTime)
 {
-    setFieldValue("ScheduleDayEnd", endTime); 
+    set<ScheduleDayEnd>(endTime); 
 }
 
 void UserModel::setPriorityInSchedule(bool inSchedule)
 {
-    setFieldValue("IncludePriorityInSchedule", inSchedule); 
+    set<IncludePriorityInSchedule>(inSchedule); 
 }
 
 void UserModel::setMinorPriorityInSchedule(bool inSchedule)
 {
-    setFieldValue("IncludeMinorPriorityInSchedule", inSchedule); 
+    set<IncludeMinorPriorityInSchedule>(inSchedule); 
 }
 
 void UserModel::setUsingLettersForMaorPriority(bool usingLetters)
 {
-    setFieldValue("UseLettersForMajorPriority", usingLetters);
+    set<UseLettersForMajorPriority>(usingLetters);
 }
 
 void UserModel::setSeparatingPriorityWithDot(bool separate)
 {
-    setFieldValue("SeparatePriorityWithDot", separate);
+    set<SeparatePriorityWithDot>(separate);
 }
 
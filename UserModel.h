@@ -1,40 +1,76 @@
 #ifndef USERMODEL_H_
 #define USERMODEL_H_
 
+#include <chrono>
 #include <iostream>
 #include "ModelBase.h"
+#include "ModelSchema.h"
 #include <string>
+#include <string_view>
 
 class UserModel : public ModelBase
 {
 public:
+/*
+ * The fields in schema slot order, for get() and set().
+ */
+    using UserID = FieldTag<0, PTS_DataField::PTS_DB_FieldType::Key>;
+    using LastName = FieldTag<1, PTS_DataField::PTS_DB_FieldType::VarChar45>;
+    using FirstName = FieldTag<2, PTS_DataField::PTS_DB_FieldType::VarChar45>;
+    using MiddleInitial = FieldTag<3, PTS_DataField::PTS_DB_FieldType::VarChar45>;
+    using LoginName = FieldTag<4, PTS_DataField::PTS_DB_FieldType::VarChar45>;
+    using HashedPassWord = FieldTag<5, PTS_DataField::PTS_DB_FieldType::TinyText>;
+    using EmailAddress = FieldTag<6, PTS_DataField::PTS_DB_FieldType::VarChar256>;
+    using ScheduleDayStart = FieldTag<7, PTS_DataField::PTS_DB_FieldType::VarChar45>;
+    using ScheduleDayEnd = FieldTag<8, PTS_DataField::PTS_DB_FieldType::VarChar45>;
+    using IncludePriorityInSchedule = FieldTag<9, PTS_DataField::PTS_DB_FieldType::Boolean>;
+    using IncludeMinorPriorityInSchedule = FieldTag<10, PTS_DataField::PTS_DB_FieldType::Boolean>;
+    using UseLettersForMajorPriority = FieldTag<11, PTS_DataField::PTS_DB_FieldType::Boolean>;
+    using SeparatePriorityWithDot = FieldTag<12, PTS_DataField::PTS_DB_FieldType::Boolean>;
+    using LastModified = FieldTag<13, PTS_DataField::PTS_DB_FieldType::TimeStamp>;
+    static_assert(fieldSlotsInOrder<UserID, LastName, FirstName, MiddleInitial, LoginName, HashedPassWord,
+        EmailAddress, ScheduleDayStart, ScheduleDayEnd, IncludePriorityInSchedule, IncludeMinorPriorityInSchedule,
+        UseLettersForMajorPriority, SeparatePriorityWithDot, LastModified>(),
+        "UserModel field tags are not numbered in schema slot order");
+
     UserModel();
-    UserModel(std::string lastIn, std::string firstIn, std::string middleIIn, std::string email="");
+    UserModel(std::string_view lastIn, std::string_view firstIn, std::string_view middleIIn,
+        std::string_view email="");
     ~UserModel() = default;
+    static const ModelSchema& getSchema();
 
     void autoGenerateLoginAndPassword();
     std::string getLastName() const;
+    std::string_view getLastNameView() const;
     std::string getFirstName() const;
+    std::string_view getFirstNameView() const;
     std::string getMiddleInitial() const;
+    std::string_view getMiddleInitialView() const;
     std::string getEmail() const;
+    std::string_view getEmailView() const;
     std::string getLoginName() const;
+    std::string_view getLoginNameView() const;
     std::string getPassword() const;
+    std::string_view getPasswordView() const;
     std::string getStartTime() const;
+    std::string_view getStartTimeView() const;
     std::string getEndTime() const;
+    std::string_view getEndTimeView() const;
     std::size_t getUserID() const;
+    std::chrono::time_point<std::chrono::system_clock> getLastModified() const;
     bool isPriorityInSchedule() const;
     bool isMinorPriorityInSchedule() const;
     bool isUsingLettersForMaorPriority() const;
     bool isSeparatingPriorityWithDot() const;
 
-    void setLastName(const std::string& lastName);
-    void setFirstName(const std::string& firstName);
-    void setMiddleInitial(const std::string& middleinit);
-    void setEmail(const std::string& email);
-    void setLoginName(const std::string& loginName);
-    void setPassword(const std::string& password);
-    void setStartTime(const std::string& startTime);
-    void setEndTime(const std::string& endTime);
+    void setLastName(std::string_view lastName);
+    void setFirstName(std::string_view firstName);
+    void setMiddleInitial(std::string_view middleinit);
+    void setEmail(std::string_view email);
+    void setLoginName(std::string_view loginName);
+    void setPassword(std::string_view password);
+    void setStartTime(std::string_view startTime);
+    void setEndTime(std::string_view endTime);
     void setPriorityInSchedule(bool inSchedule);
     void setMinorPriorityInSchedule(bool inSchedule);
     void setUsingLettersForMaorPriority(bool usingLetters);
@@ -43,18 +79,17 @@ public:
 
     friend std::ostream& operator<<(std::ostream& os, const UserModel& obj)
     {
-        os << obj.primaryKeyFieldName;
+        os << obj.getPrimaryKeyName();
         os << "Column Names: ";
-        for (const auto& [key, value] : obj.dataFields)
+        for (const auto& field : obj.fields)
         {
-            os << key;
+            os << field.getColumnName();
             os << ", ";
         }
         os << "\n";
-        for (const auto& [key, value] : obj.dataFields)
+        for (std::size_t slot = 0; slot < obj.fields.size(); ++slot)
         {
-            PTS_DataField_shp currentField = value;
-            os << currentField->fieldInfo();
+            os << obj.getFieldInfo(slot);
             os << "\n";
         }
 
@@ -62,8 +97,8 @@ public:
     };
 
 private:
-    void createLoginBasedOnUserName(const std::string& lastName,
-        const std::string& firstName,const std::string& middleInitial);
+    void createLoginBasedOnUserName(std::string_view lastName, std::string_view firstName,
+        std::string_view middleInitial);
 };
 
 using UserModel_shp = std::shared_ptr<UserModel>;
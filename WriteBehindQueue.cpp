@@ -0,0 +1,70 @@
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <utility>
+#include <vector>
+#include "WriteBehindQueue.h"
+
+WriteBehindQueue::WriteBehindQueue(std::size_t queueCapacity)
+:   capacity{queueCapacity}, cells{std::make_unique<Cell[]>(queueCapacity)},
+    freeCells{static_cast<std::ptrdiff_t>(queueCapacity)}, enqueuePosition{0}, dequeuePosition{0}, wakeups{0},
+    closed{false}
+{
+}
+
+/*
+ * A cell is released only after the consumer has taken its request, so once a
+ * free cell has been acquired the claimed position can't overtake the consumer.
+ */
+void WriteBehindQueue::push(WriteBehindRequest request)
+{
+    freeCells.acquire();
+
+    std::uint64_t position = enqueuePosition.fetch_add(1, std::memory_order_relaxed);
+    Cell& cell = cells[position % capacity];
+    cell.request = std::move(request);
+    cell.sequence.store(position + 1, std::memory_order_release);
+
+    wakeups.fetch_add(1, std::memory_order_release);
+    wakeups.notify_one();
+}
+
+/*
+ * Requests are taken in the order of their positions, a producer that has claimed
+ * a position but not published it yet holds back the requests behind it.
+ */
+bool WriteBehindQueue::popBatch(std::vector<WriteBehindRequest>& batch, std::size_t maxRequests)
+{
+    while (!isPublished(dequeuePosition))
+    {
+        std::uint64_t seenWakeups = wakeups.load(std::memory_order_acquire);
+        if (isPublished(dequeuePosition))
+        {
+            break;
+        }
+        if (closed.load(std::memory_order_acquire))
+        {
+            return false;
+        }
+        wakeups.wait(seenWakeups, std::memory_order_acquire);
+    }
+
+    while (batch.size() < maxRequests && isPublished(dequeuePosition))
+    {
+        Cell& cell = cells[dequeuePosition % capacity];
+        batch.push_back(std::move(cell.request));
+        cell.request = WriteBehindRequest{};
+        ++dequeuePosition;
+        freeCells.release();
+    }
+
+    return true;
+}
+
+void WriteBehindQueue::close()
+{
+    closed.store(true, std::memory_order_release);
+    wakeups.fetch_add(1, std::memory_order_release);
+    wakeups.notify_one();
+}
@@ -0,0 +1,74 @@
+#ifndef WRITEBEHINDQUEUE_H_
+#define WRITEBEHINDQUEUE_H_
+
+/*
+ * WriteBehindQueue:
+ * A bounded multiple producer, single consumer queue of the inserts and updates
+ * that are waiting to be written. A producer claims a cell with one atomic
+ * increment and publishes it through the sequence number of the cell, producers
+ * never wait for each other or for the consumer. The only wait is for a free
+ * cell when the queue is full, that backpressure keeps the depth bounded.
+ */
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <future>
+#include "ModelBase.h"
+#include <memory>
+#include <semaphore>
+#include "StorageInterface.h"
+#include <vector>
+
+/*
+ * A Flush request completes once every request queued before it is written.
+ */
+struct WriteBehindRequest
+{
+    enum class Kind {Insert, Update, Flush};
+    Kind kind;
+    ModelShp model;
+    std::promise<WriteKeyResult> keyPromise;
+    WriteCompletionCallback onComplete;
+};
+
+class WriteBehindQueue
+{
+public:
+    WriteBehindQueue(std::size_t queueCapacity);
+    std::size_t getCapacity() const { return capacity; };
+/*
+ * Blocks while the queue is full. Must not be called after close().
+ */
+    void push(WriteBehindRequest request);
+/*
+ * Consumer only. Waits until a request is queued or the queue is closed, then
+ * moves up to maxRequests requests into batch. Returns false once the queue is
+ * closed and every request has been taken.
+ */
+    bool popBatch(std::vector<WriteBehindRequest>& batch, std::size_t maxRequests);
+    void close();
+
+private:
+/*
+ * The cell of position p is published when its sequence is p + 1.
+ */
+    struct Cell
+    {
+        std::atomic<std::uint64_t> sequence{0};
+        WriteBehindRequest request;
+    };
+    bool isPublished(std::uint64_t position) const
+    {
+        return cells[position % capacity].sequence.load(std::memory_order_acquire) == position + 1;
+    };
+
+    std::size_t capacity;
+    std::unique_ptr<Cell[]> cells;
+    std::counting_semaphore<> freeCells;
+    std::atomic<std::uint64_t> enqueuePosition;
+    std::uint64_t dequeuePosition;
+    std::atomic<std::uint64_t> wakeups;
+    std::atomic<bool> closed;
+};
+
+#endif  // WRITEBEHINDQUEUE_H_
@@ -1,22 +1,31 @@
+#include <atomic>
 #include <boost/asio.hpp>
 #include <boost/mysql.hpp>
+#include <cctype>
+#include <chrono>
 #include "CommandLineParser.h"
 #include "DBInterface.h"
 #include "CSVReader.h"
 #include <exception>
+#include <future>
+#include "InMemoryStorage.h"
 #include <iostream>
+#include <memory>
+#include "ModelIdentityMap.h"
 #include <stdexcept>
+#include "StorageInterface.h"
 #include <string>
-#include <vector>
 #include "TaskModel.h"
+#include <unordered_set>
 #include "UserModel.h"
 #include "UtilityTimer.h"
+#include <vector>
 
-static bool testGetUserByLoginName(DBInterface& userDBInterface, UserModel_shp insertedUser)
+static bool testRetrievedUser(const PipelineStage& retrieval, UserModel_shp insertedUser, const std::string& testName)
 {
-    UserModel_shp retrievedUser = std::make_shared<UserModel>(UserModel());
-    if (userDBInterface.getUniqueModelFromDB(retrievedUser, {{"LoginName", PTS_DataField(insertedUser->getLoginName())}}))
+    if (retrieval.status)
     {
+        UserModel_shp retrievedUser = std::dynamic_pointer_cast<UserModel>(retrieval.model);
         if (*retrievedUser == *insertedUser)
         {
             return true;
@@ -30,38 +39,22 @@ static bool testGetUserByLoginName(DBInterface& userDBInterface, UserModel_shp i
     }
     else
     {
-        std::cerr << "userDBInterface.getUserByLogin(user->getLoginName()) FAILED!\n" <<
-            userDBInterface.getAllErrorMessages() << "\n";
+        std::cerr << "userDBInterface." << testName << "() FAILED!\n" << retrieval.status.error() << "\n";
         return false;
     }
 }
 
-static bool testGetUserByFullName(DBInterface& userDBInterface, UserModel_shp insertedUser)
+static std::unique_ptr<StorageInterface> createStorage(ProgramOptions& programOptions)
 {
-    UserModel_shp retrievedUser = std::make_shared<UserModel>(UserModel());
-    if (userDBInterface.getUniqueModelFromDB(retrievedUser, {{"LastName", PTS_DataField(insertedUser->getLastName())},
-        {"FirstName", PTS_DataField(insertedUser->getFirstName())}, {"MiddleInitial", PTS_DataField(insertedUser->getMiddleInitial())}}))
-    {
-        if (*retrievedUser == *insertedUser)
-        {
-            return true;
-        }
-        else
-        {
-            std::cerr << "Insertion user and retrieved User are not the same. Test FAILED!\nInserted User:\n" <<
-            *insertedUser << "\n" "Retreived User:\n" << *retrievedUser << "\n";
-            return false;
-        }
-    }
-    else
+    if (programOptions.useInMemoryStorage)
     {
-        std::cerr << "userDBInterface.getUserByFullName() FAILED!\n" <<
-            userDBInterface.getAllErrorMessages() << "\n";
-        return false;
+        return std::make_unique<InMemoryStorage>(programOptions);
     }
+
+    return std::make_unique<DBInterface>(programOptions);
 }
 
-static UserList loadUserProfileTestDataIntoDatabase(ProgramOptions &programOptions)
+static UserList loadUserProfileTestDataIntoDatabase(StorageInterface& storage, ProgramOptions &programOptions)
 {
     // Test one case of the alternate constructor.
     UserList userProfileTestData = {{std::make_shared<UserModel>("PacMan", "IN", "BW", "pacmaninbw@gmail.com")}};
@@ -79,32 +72,46 @@ static UserList loadUserProfileTestDataIntoDatabase(ProgramOptions &programOptio
         userProfileTestData.push_back(userIn);
     }
 
-    DBInterface userDBInterface(programOptions);
     bool allTestsPassed = true;
 
+    // Each user is inserted and then retrieved by login name and by full name,
+    // all of the statements are sent to the database as one pipeline.
+    std::vector<PipelineStage> userStages;
     for (auto user: userProfileTestData)
     {
-        if (!userDBInterface.insertIntoDataBase(*user))
+        userStages.push_back({PipelineStage::Kind::Insert, user, {}, {}});
+        userStages.push_back({PipelineStage::Kind::Select, std::make_shared<UserModel>(UserModel()),
+            {{"LoginName", PTS_DataField(user->getLoginName())}}, {}});
+        userStages.push_back({PipelineStage::Kind::Select, std::make_shared<UserModel>(UserModel()),
+            {{"LastName", PTS_DataField(user->getLastName())}, {"FirstName", PTS_DataField(user->getFirstName())},
+            {"MiddleInitial", PTS_DataField(user->getMiddleInitial())}}, {}});
+    }
+    storage.executePipeline(userStages);
+
+    for (std::size_t stage = 0; stage < userStages.size(); stage += 3)
+    {
+        UserModel_shp user = std::dynamic_pointer_cast<UserModel>(userStages[stage].model);
+        if (!userStages[stage].status)
         {
-            std::cerr << userDBInterface.getAllErrorMessages() << "\n" << *user << "\n";
+            std::cerr << userStages[stage].status.error() << "\n" << *user << "\n";
             allTestsPassed = false;
         }
         else
         {
             if (user->isInDataBase())
             {
-                if (!testGetUserByLoginName(userDBInterface, user))
+                if (!testRetrievedUser(userStages[stage + 1], user, "getUserByLogin"))
                 {
                     allTestsPassed = false;
                 }
-                if (!testGetUserByFullName(userDBInterface, user))
+                if (!testRetrievedUser(userStages[stage + 2], user, "getUserByFullName"))
                 {
                     allTestsPassed = false;
                 }
             }
             else
             {
-                std::clog << "Primary key for user: " << user->getLastName() << ", " << user->getFirstName() << " not set!\n";
+                std::clog << "Primary key for user: " << user->getLastNameView() << ", " << user->getFirstNameView() << " not set!\n";
                 if (programOptions.verboseOutput)
                 {
                     std::clog << *user << "\n\n";
@@ -125,11 +132,11 @@ static UserList loadUserProfileTestDataIntoDatabase(ProgramOptions &programOptio
     return userProfileTestData;
 }
 
-static bool testGetTaskByDescription(DBInterface& taskDBInterface, TaskModel& task, bool verboseOutput)
+static bool testRetrievedTask(const PipelineStage& retrieval, TaskModel& task, bool verboseOutput)
 {
-    TaskModel_shp testInDB = std::make_shared<TaskModel>(TaskModel());
-    if (taskDBInterface.getUniqueModelFromDB(testInDB, {{"Description", PTS_DataField(task.getDescription())}}))
+    if (retrieval.status)
     {
+        TaskModel_shp testInDB = std::dynamic_pointer_cast<TaskModel>(retrieval.model);
         if (*testInDB == task)
         {
             return true;
@@ -147,7 +154,7 @@ static bool testGetTaskByDescription(DBInterface& taskDBInterface, TaskModel& ta
     else
     {
         std::cerr << "userDBInterface.getTaskByDescription(task.getDescription())) FAILED!\n" 
-            << taskDBInterface.getAllErrorMessages() << "\n";
+            << retrieval.status.error() << "\n";
         return false;
     }
 }
@@ -251,35 +258,45 @@ static TaskModel_shp creatEvenTask(const UserModel_shp userOne, const UserTaskTe
     return newTask;
 }
 
-static bool loadUserTaskestDataIntoDatabase(UserModel_shp userOne, ProgramOptions& programOptions)
+static bool loadUserTaskestDataIntoDatabase(StorageInterface& storage, UserModel_shp userOne,
+    ProgramOptions& programOptions)
 {
-    DBInterface TaskDBInterface(programOptions);
     bool allTestsPassed = true;
     std::size_t lCount = 0;
     std::vector<UserTaskTestData> userTaskTestData = loadTasksFromDataFile(programOptions.taskTestDataFile);;
+    std::vector<PipelineStage> taskStages;
 
     for (auto taskTestData: userTaskTestData)
     {
         // Try both constructors on an alternating basis.
         TaskModel_shp testTask = (lCount & 0x000001)? creatOddTask(userOne, taskTestData) : creatEvenTask(userOne, taskTestData);
+        taskStages.push_back({PipelineStage::Kind::Insert, testTask, {}, {}});
+        taskStages.push_back({PipelineStage::Kind::Select, std::make_shared<TaskModel>(TaskModel()),
+            {{"Description", PTS_DataField(testTask->getDescription())}}, {}});
+        ++lCount;
+    }
+    storage.executePipeline(taskStages);
 
-        if (!TaskDBInterface.insertIntoDataBase(*testTask))
+    for (std::size_t stage = 0; stage < taskStages.size(); stage += 2)
+    {
+        TaskModel_shp testTask = std::dynamic_pointer_cast<TaskModel>(taskStages[stage].model);
+        if (!taskStages[stage].status)
         {
-            std::cerr << TaskDBInterface.getAllErrorMessages() << *testTask << "\n";
+            std::cerr << taskStages[stage].status.error() << *testTask << "\n";
             allTestsPassed = false;
         }
         else
         {
             if (testTask->isInDataBase())
             {
-                if (!testGetTaskByDescription(TaskDBInterface, *testTask, programOptions.verboseOutput))
+                if (!testRetrievedTask(taskStages[stage + 1], *testTask, programOptions.verboseOutput))
                 {
                     allTestsPassed = false;
                 }
             }
             else
             {
-                std::clog << "Primary key for task: " << testTask->getPrimaryKey() << ", " << testTask->getDescription() <<
+                std::clog << "Primary key for task: " << testTask->getPrimaryKey() << ", " << testTask->getDescriptionView() <<
                 " not set!\n";
                 if (programOptions.verboseOutput)
                 {
@@ -288,13 +305,582 @@ static bool loadUserTaskestDataIntoDatabase(UserModel_shp userOne, ProgramOption
                 allTestsPassed = false;
             }
         }
-        ++lCount;
     }
 
     std::clog << "All Task insertions and retrival tests PASSED\n";
     return allTestsPassed;
 }
 
+/*
+ * The tasks of planData.txt are inserted with one call, each task must be read
+ * back by the key it was assigned. A user whose LoginName is taken fails the
+ * multi-row insert, the rows are then inserted one at a time and only that user
+ * must be left out.
+ */
+static bool testBulkInsert(StorageInterface& storage, UserList& userList, ProgramOptions& programOptions)
+{
+    ModelList bulkTasks;
+    for (auto taskTestData: loadTasksFromDataFile(programOptions.taskTestDataFile))
+    {
+        taskTestData.parentTask = 0;
+        bulkTasks.push_back(creatEvenTask(userList[0], taskTestData));
+    }
+
+    if (!storage.insertManyIntoDataBase(bulkTasks))
+    {
+        std::cerr << "insertManyIntoDataBase() of tasks FAILED!\n" << storage.getAllErrorMessages() << "\n";
+        return false;
+    }
+
+    std::unordered_set<std::size_t> assignedKeys;
+    for (auto model: bulkTasks)
+    {
+        TaskModel_shp readBack = std::make_shared<TaskModel>();
+        if (!model->isInDataBase() || !assignedKeys.insert(model->getPrimaryKey()).second ||
+            !storage.getUniqueModelFromDB(readBack,
+                std::vector<WhereArg>{{"TaskID", PTS_DataField(model->getPrimaryKey())}}) ||
+            !(*readBack == *model))
+        {
+            std::cerr << "Bulk inserted task " << model->getPrimaryKey() << " wasn't read back by its key. "
+                "Test FAILED!\n" << storage.getAllErrorMessages() << "\n";
+            return false;
+        }
+    }
+
+    UserModel_shp takenLogin = std::make_shared<UserModel>("Bulk", "Taken", "L", "bulk.taken@example.com");
+    takenLogin->setLoginName(userList[0]->getLoginNameView());
+    ModelList bulkUsers = {std::make_shared<UserModel>("Bulk", "First", "F", "bulk.first@example.com"), takenLogin,
+        std::make_shared<UserModel>("Bulk", "Second", "S", "bulk.second@example.com")};
+    if (storage.insertManyIntoDataBase(bulkUsers) || takenLogin->isInDataBase() ||
+        !bulkUsers[0]->isInDataBase() || !bulkUsers[2]->isInDataBase())
+    {
+        std::cerr << "insertManyIntoDataBase() didn't insert only the users with a free LoginName. "
+            "Test FAILED!\n" << storage.getAllErrorMessages() << "\n";
+        return false;
+    }
+
+    for (std::size_t userIndex: {0, 2})
+    {
+        UserModel_shp readBack = std::make_shared<UserModel>();
+        if (!storage.getUniqueModelFromDB(readBack,
+                std::vector<WhereArg>{{"UserID", PTS_DataField(bulkUsers[userIndex]->getPrimaryKey())}}) ||
+            !(*readBack == *bulkUsers[userIndex]))
+        {
+            std::cerr << "Bulk inserted user " << bulkUsers[userIndex]->getPrimaryKey() << " wasn't read back by "
+                "its key. Test FAILED!\n" << storage.getAllErrorMessages() << "\n";
+            return false;
+        }
+        userList.push_back(std::static_pointer_cast<UserModel>(bulkUsers[userIndex]));
+    }
+
+    std::clog << "Bulk insert of tasks and users test PASSED\n";
+    return true;
+}
+
+/*
+ * The keys mix existing users, a user listed twice, a LoginName in another case,
+ * which the column's collation matches, and a LoginName without a row. Only the
+ * missing key may fail, every other model must hold its user.
+ */
+static bool testUniqueModelLookups(StorageInterface& storage, UserList& userList)
+{
+    std::string otherCaseLogin = userList[3]->getLoginName();
+    for (auto& loginCharacter: otherCaseLogin)
+    {
+        loginCharacter = static_cast<char>(std::toupper(static_cast<unsigned char>(loginCharacter)));
+    }
+
+    std::vector<UserModel_shp> expectedUsers = {userList[1], userList[2], userList[1], userList[3], nullptr};
+    std::vector<KeyTuple> keys = {{PTS_DataField(userList[1]->getLoginName())},
+        {PTS_DataField(userList[2]->getLoginName())}, {PTS_DataField(userList[1]->getLoginName())},
+        {PTS_DataField(otherCaseLogin)}, {PTS_DataField(std::string("NoSuchLoginName"))}};
+    ModelList lookedUpUsers;
+    for (std::size_t keyIndex = 0; keyIndex < keys.size(); ++keyIndex)
+    {
+        lookedUpUsers.push_back(std::make_shared<UserModel>());
+    }
+
+    if (storage.getUniqueModelsFromDB(lookedUpUsers, {"LoginName"}, keys) || storage.getAllErrorMessages().empty())
+    {
+        std::cerr << "getUniqueModelsFromDB() didn't report the missing LoginName. Test FAILED!\n";
+        return false;
+    }
+
+    for (std::size_t keyIndex = 0; keyIndex < keys.size(); ++keyIndex)
+    {
+        bool found = lookedUpUsers[keyIndex]->isInDataBase();
+        if (found != (expectedUsers[keyIndex] != nullptr) ||
+            (found && !(*lookedUpUsers[keyIndex] == *expectedUsers[keyIndex])))
+        {
+            std::cerr << "getUniqueModelsFromDB() key " << keyIndex << " didn't read the expected user. "
+                "Test FAILED!\n" << storage.getAllErrorMessages() << "\n";
+            return false;
+        }
+    }
+
+    std::clog << "Lookup of many users by unique key test PASSED\n";
+    return true;
+}
+
+static bool checkModelCacheStatistics(const ModelCacheStatistics& statistics, std::size_t hits, std::size_t misses,
+    std::size_t evictions, const std::string& testName)
+{
+    if (statistics.hits == hits && statistics.misses == misses && statistics.evictions == evictions)
+    {
+        return true;
+    }
+
+    std::cerr << testName << " counted " << statistics.hits << " hits, " << statistics.misses << " misses and " <<
+        statistics.evictions << " evictions instead of " << hits << ", " << misses << " and " << evictions <<
+        ". Test FAILED!\n";
+    return false;
+}
+
+/*
+ * A cache of two users: storing a third evicts the least recently used, a hit
+ * copies the cached values and changing the copy doesn't change the cache. With a
+ * database a DBInterface with a small cache must also read the values written by
+ * an update.
+ */
+static bool testModelCache(StorageInterface& storage, UserList& userList, ProgramOptions& programOptions)
+{
+    ModelIdentityMap modelCache(2);
+    modelCache.addUniqueIndex(UserModel().getTableName(), {"LoginName"});
+    modelCache.store(*userList[1]);
+    modelCache.store(*userList[2]);
+    UserModel cachedUser;
+    if (!modelCache.find(cachedUser, {{"UserID", PTS_DataField(userList[1]->getUserID())}}))
+    {
+        std::cerr << "The model cache didn't find a stored user. Test FAILED!\n";
+        return false;
+    }
+    modelCache.store(*userList[3]);
+
+    UserModel evictedUser;
+    cachedUser.setEmail("changed.in.the.copy@example.com");
+    UserModel copiedUser;
+    if (modelCache.find(evictedUser, {{"UserID", PTS_DataField(userList[2]->getUserID())}}) ||
+        !modelCache.find(copiedUser, {{"LoginName", PTS_DataField(userList[1]->getLoginName())}}) ||
+        !(copiedUser == *userList[1]) || copiedUser.getModifiedFields() != 0)
+    {
+        std::cerr << "The model cache didn't evict the least recently used user or didn't keep its own copy. "
+            "Test FAILED!\n";
+        return false;
+    }
+    if (!checkModelCacheStatistics(modelCache.getStatistics(), 2, 1, 1, "ModelIdentityMap"))
+    {
+        return false;
+    }
+
+    UserModel_shp updatedUser = userList[4];
+    updatedUser->setEmail("updated.in.the.cache.test@example.com");
+    UserModel_shp readBack = std::make_shared<UserModel>();
+    if (!storage.updateInDataBase(*updatedUser) || !storage.getUniqueModelFromDB(readBack,
+        std::vector<WhereArg>{{"UserID", PTS_DataField(updatedUser->getUserID())}}) || !(*readBack == *updatedUser))
+    {
+        std::cerr << "A read after an update didn't return the updated user. Test FAILED!\n" <<
+            storage.getAllErrorMessages() << "\n";
+        return false;
+    }
+
+    if (!programOptions.useInMemoryStorage)
+    {
+        ProgramOptions cacheOptions = programOptions;
+        cacheOptions.modelCacheSize = 2;
+        DBInterface cachedStorage(cacheOptions);
+        auto readUser = [&cachedStorage](UserModel_shp user) {
+            UserModel_shp readUser = std::make_shared<UserModel>();
+            return cachedStorage.getUniqueModelFromDB(readUser,
+                std::vector<WhereArg>{{"UserID", PTS_DataField(user->getUserID())}}) && *readUser == *user;
+        };
+
+        // Misses for 1, 2 and 3, a hit for 3, then 1 was evicted by 3.
+        if (!readUser(userList[1]) || !readUser(userList[2]) || !readUser(userList[3]) || !readUser(userList[3]) ||
+            !readUser(userList[1]) ||
+            !checkModelCacheStatistics(cachedStorage.getModelCacheStatistics(), 1, 4, 2, "DBInterface model cache"))
+        {
+            return false;
+        }
+
+        updatedUser->setEmail("updated.through.the.cache@example.com");
+        if (!cachedStorage.updateInDataBase(*updatedUser) || !readUser(updatedUser) || !readUser(updatedUser) ||
+            !checkModelCacheStatistics(cachedStorage.getModelCacheStatistics(), 2, 5, 3, "DBInterface model cache"))
+        {
+            std::cerr << "A cached read after an update didn't return the updated user. Test FAILED!\n" <<
+                cachedStorage.getAllErrorMessages() << "\n";
+            return false;
+        }
+    }
+
+    std::clog << "Model cache test PASSED\n";
+    return true;
+}
+
+/*
+ * Every task of the user must be listed exactly once across the pages, in the
+ * order of the listing, and a cursor must only be accepted by its own listing.
+ */
+static bool testTaskPagesForUser(StorageInterface& storage, UserModel_shp userOne, TaskPageOrder order,
+    const std::string& orderName)
+{
+    TaskList allTasks = storage.getAllTasksForUser(userOne);
+    std::unordered_set<std::size_t> listedTaskIDs;
+    TaskModel_shp previousTask;
+    std::string cursor;
+    std::string firstCursor;
+    constexpr std::size_t pageSize = 7;
+
+    do
+    {
+        TaskPage page;
+        if (!storage.getTaskPageForUser(userOne->getUserID(), order, pageSize, cursor, page))
+        {
+            std::cerr << "getTaskPageForUser() by " << orderName << " FAILED!\n" << storage.getAllErrorMessages() << "\n";
+            return false;
+        }
+        if (page.tasks.size() > pageSize || (page.tasks.size() < pageSize && !page.nextCursor.empty()))
+        {
+            std::cerr << "Task page by " << orderName << " has " << page.tasks.size() << " tasks. Test FAILED!\n";
+            return false;
+        }
+
+        for (auto task: page.tasks)
+        {
+            bool inOrder = !previousTask || ((order == TaskPageOrder::RequiredDelivery &&
+                previousTask->getDueDate() != task->getDueDate())? previousTask->getDueDate() < task->getDueDate() :
+                previousTask->getTaskID() < task->getTaskID());
+            if (!inOrder || !listedTaskIDs.insert(task->getTaskID()).second)
+            {
+                std::cerr << "Task " << task->getTaskID() << " is out of order or listed twice in the pages by "
+                    << orderName << ". Test FAILED!\n";
+                return false;
+            }
+            previousTask = task;
+        }
+
+        if (firstCursor.empty())
+        {
+            firstCursor = page.nextCursor;
+        }
+        cursor = page.nextCursor;
+    } while (!cursor.empty());
+
+    if (listedTaskIDs.size() != allTasks.size())
+    {
+        std::cerr << "The pages by " << orderName << " listed " << listedTaskIDs.size() << " of " << allTasks.size()
+            << " tasks. Test FAILED!\n";
+        return false;
+    }
+
+    if (!firstCursor.empty())
+    {
+        TaskPage page;
+        TaskPageOrder otherOrder = (order == TaskPageOrder::TaskID)? TaskPageOrder::RequiredDelivery : TaskPageOrder::TaskID;
+        if (storage.getTaskPageForUser(userOne->getUserID(), otherOrder, pageSize, firstCursor, page) ||
+            storage.getTaskPageForUser(userOne->getUserID() + 1, order, pageSize, firstCursor, page) ||
+            storage.getTaskPageForUser(userOne->getUserID(), order, pageSize, firstCursor + "x", page))
+        {
+            std::cerr << "A task page cursor by " << orderName << " was accepted by another listing. Test FAILED!\n";
+            return false;
+        }
+    }
+
+    return true;
+}
+
+static bool testTaskPages(StorageInterface& storage, UserModel_shp userOne)
+{
+    if (!testTaskPagesForUser(storage, userOne, TaskPageOrder::TaskID, "TaskID") ||
+        !testTaskPagesForUser(storage, userOne, TaskPageOrder::RequiredDelivery, "RequiredDelivery"))
+    {
+        return false;
+    }
+
+    std::clog << "Keyset pagination of tasks test PASSED\n";
+    return true;
+}
+
+/*
+ * More tasks are queued than the queue holds so the producer has to wait for the
+ * flusher. A failing callback must not stop the flusher, and the queued writes
+ * must not be rolled back with a transaction that is open while they are written.
+ */
+static bool testWriteBehind(StorageInterface& storage, UserModel_shp userOne, ProgramOptions& programOptions)
+{
+    std::vector<UserTaskTestData> userTaskTestData = loadTasksFromDataFile(programOptions.taskTestDataFile);
+    if (userTaskTestData.empty())
+    {
+        return true;
+    }
+
+    constexpr std::size_t taskCount = 50;
+    TaskList tasks;
+    std::vector<std::future<WriteKeyResult>> keyFutures;
+    std::atomic<std::size_t> completedWrites = 0;
+    WriteCompletionCallback countWrite = [&completedWrites](ModelShp, const DBStatus& status) {
+        if (status)
+        {
+            ++completedWrites;
+        }
+    };
+
+    for (std::size_t taskIndex = 0; taskIndex < taskCount; ++taskIndex)
+    {
+        TaskModel_shp task = creatEvenTask(userOne, userTaskTestData[taskIndex % userTaskTestData.size()]);
+        task->setDescription("Write-behind task " + std::to_string(taskIndex));
+        tasks.push_back(task);
+        keyFutures.push_back(storage.insertWriteBehind(task, (taskIndex == 0)?
+            [](ModelShp, const DBStatus&) { throw std::runtime_error("Callback failure"); } : countWrite));
+    }
+    storage.flushWriteBehind();
+
+    for (std::size_t taskIndex = 0; taskIndex < taskCount; ++taskIndex)
+    {
+        if (keyFutures[taskIndex].wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+        {
+            std::cerr << "Write-behind insert " << taskIndex << " isn't complete after the flush. Test FAILED!\n";
+            return false;
+        }
+        WriteKeyResult key = keyFutures[taskIndex].get();
+        if (!key || *key == 0 || *key != tasks[taskIndex]->getTaskID())
+        {
+            std::cerr << "Write-behind insert " << taskIndex << " FAILED!\n" << (key? "" : key.error()) << "\n";
+            return false;
+        }
+    }
+
+    keyFutures.clear();
+    for (auto task: tasks)
+    {
+        task->setPercentageComplete(50.0);
+        keyFutures.push_back(storage.updateWriteBehind(task, countWrite));
+    }
+
+    TaskModel_shp transactionTask = creatEvenTask(userOne, userTaskTestData[0]);
+    transactionTask->setDescription("Write-behind task during a transaction");
+    if (!storage.beginTransaction())
+    {
+        std::cerr << "beginTransaction() FAILED!\n" << storage.getAllErrorMessages() << "\n";
+        return false;
+    }
+    keyFutures.push_back(storage.insertWriteBehind(transactionTask, countWrite));
+    storage.flushWriteBehind();
+    storage.rollback();
+
+    if (completedWrites != 2 * taskCount)
+    {
+        std::cerr << "Write-behind completed " << completedWrites << " of " << 2 * taskCount << " writes. Test FAILED!\n";
+        return false;
+    }
+
+    tasks.push_back(transactionTask);
+    for (std::size_t taskIndex = 0; taskIndex < tasks.size(); ++taskIndex)
+    {
+        WriteKeyResult key = keyFutures[taskIndex].get();
+        TaskModel_shp taskInDB = std::make_shared<TaskModel>();
+        if (!key || !storage.getUniqueModelFromDB(taskInDB, std::vector<WhereArg>{{"TaskID", PTS_DataField(*key)}}) ||
+            *taskInDB != *tasks[taskIndex])
+        {
+            std::cerr << "Write-behind task " << taskIndex << " wasn't stored. Test FAILED!\n" <<
+                (key? storage.getAllErrorMessages() : key.error()) << "\n";
+            return false;
+        }
+    }
+
+    std::clog << "Write-behind insert and update test PASSED\n";
+    return true;
+}
+
+/*
+ * The first query returns every task of the user, a query from its watermark
+ * returns none of them again, and an updated task is returned once.
+ */
+static bool testTasksChangedSince(StorageInterface& storage, UserModel_shp userOne)
+{
+    TaskList allTasks = storage.getAllTasksForUser(userOne);
+    ChangedTasks allChanges;
+    if (!storage.getTasksChangedSince(userOne->getUserID(), ChangeWatermark{}, allChanges) ||
+        allChanges.tasks.empty() || allChanges.tasks.size() != allTasks.size())
+    {
+        std::cerr << "getTasksChangedSince() returned " << allChanges.tasks.size() << " of " << allTasks.size()
+            << " tasks. Test FAILED!\n" << storage.getAllErrorMessages() << "\n";
+        return false;
+    }
+
+    ChangedTasks noChanges;
+    if (!storage.getTasksChangedSince(userOne->getUserID(), allChanges.nextWatermark, noChanges) ||
+        !noChanges.tasks.empty())
+    {
+        std::cerr << "getTasksChangedSince() returned " << noChanges.tasks.size() <<
+            " tasks that were already returned. Test FAILED!\n" << storage.getAllErrorMessages() << "\n";
+        return false;
+    }
+
+    TaskModel_shp changedTask = allChanges.tasks.front();
+    changedTask->setPercentageComplete(changedTask->getPercentageComplete() + 1.0);
+    ChangedTasks updateChanges;
+    if (!storage.updateInDataBase(*changedTask) ||
+        !storage.getTasksChangedSince(userOne->getUserID(), noChanges.nextWatermark, updateChanges) ||
+        updateChanges.tasks.size() != 1 || updateChanges.tasks.front()->getTaskID() != changedTask->getTaskID() ||
+        updateChanges.tasks.front()->getLastModified() < allChanges.nextWatermark.lastModified)
+    {
+        std::cerr << "getTasksChangedSince() didn't return the updated task " << changedTask->getTaskID() <<
+            " once. Test FAILED!\n" << storage.getAllErrorMessages() << "\n";
+        return false;
+    }
+
+    std::clog << "Changed tasks watermark test PASSED\n";
+    return true;
+}
+
+/*
+ * A projected read loads only the projected fields, reading another field fails
+ * until loadMissingFields() has loaded it.
+ */
+static bool testProjectedReads(StorageInterface& storage, UserList& userList)
+{
+    UserModel_shp userOne = userList[0];
+    UserModel_shp projectedUser = std::make_shared<UserModel>();
+    if (!storage.getProjectedModelFromDB(projectedUser,
+        std::vector<WhereArg>{{"LoginName", PTS_DataField(userOne->getLoginName())}}, {{"LoginName", "LastName"}}))
+    {
+        std::cerr << "getProjectedModelFromDB() FAILED!\n" << storage.getAllErrorMessages() << "\n";
+        return false;
+    }
+    if (projectedUser->allFieldsLoaded() || projectedUser->getUserID() != userOne->getUserID() ||
+        projectedUser->getLastNameView() != userOne->getLastNameView())
+    {
+        std::cerr << "The projected user doesn't hold the projected fields. Test FAILED!\n";
+        return false;
+    }
+
+    bool notLoadedReported = false;
+    try
+    {
+        projectedUser->getFirstName();
+    }
+    catch (const std::logic_error&)
+    {
+        notLoadedReported = true;
+    }
+    if (!notLoadedReported)
+    {
+        std::cerr << "Reading a field that isn't loaded didn't fail. Test FAILED!\n";
+        return false;
+    }
+
+    DBStatus loaded = storage.loadMissingFields(*projectedUser);
+    if (!loaded || !projectedUser->allFieldsLoaded() || !(*projectedUser == *userOne))
+    {
+        std::cerr << "loadMissingFields() FAILED!\n" << (loaded? "" : loaded.error()) << "\n";
+        return false;
+    }
+
+    UserModel newUser;
+    newUser.markNotLoadedExcept({});
+    if (storage.getProjectedModelFromDB(std::make_shared<UserModel>(),
+        std::vector<WhereArg>{{"LoginName", PTS_DataField(userOne->getLoginName())}}, {{"NoSuchField"}}) ||
+        storage.loadMissingFields(newUser))
+    {
+        std::cerr << "A projection of an unknown field or a load of a new model didn't fail. Test FAILED!\n";
+        return false;
+    }
+
+    std::size_t projectedUserCount = 0;
+    bool allProjected = storage.getAllUsers([&projectedUserCount](UserList& userBatch) {
+            for (auto user: userBatch)
+            {
+                if (!user->allFieldsLoaded() && !user->getLastNameView().empty())
+                {
+                    ++projectedUserCount;
+                }
+            }
+        }, {{"LastName"}});
+    if (!allProjected || projectedUserCount != userList.size())
+    {
+        std::cerr << "getAllUsers() projected " << projectedUserCount << " of " << userList.size() <<
+            " users. Test FAILED!\n" << storage.getAllErrorMessages() << "\n";
+        return false;
+    }
+
+    std::clog << "Projected reads and loading missing fields test PASSED\n";
+    return true;
+}
+
+/*
+ * The subtree is root, its children first and second and the grandchild below
+ * first. Once root is made a child of the grandchild the cycle must end at root.
+ */
+static bool testTaskSubtree(StorageInterface& storage, UserModel_shp userOne, ProgramOptions& programOptions)
+{
+    std::vector<UserTaskTestData> userTaskTestData = loadTasksFromDataFile(programOptions.taskTestDataFile);
+    if (userTaskTestData.empty())
+    {
+        return true;
+    }
+
+    UserTaskTestData taskData = userTaskTestData[0];
+    taskData.parentTask = 0;
+    TaskList subtreeTasks;
+    for (auto description: {"Subtree root", "Subtree first child", "Subtree second child", "Subtree grandchild"})
+    {
+        TaskModel_shp task = creatEvenTask(userOne, taskData);
+        task->setDescription(description);
+        if (subtreeTasks.size() == 1 || subtreeTasks.size() == 2)
+        {
+            task->setParentTaskID(subtreeTasks[0]->getTaskID());
+        }
+        else if (subtreeTasks.size() == 3)
+        {
+            task->setParentTaskID(subtreeTasks[1]->getTaskID());
+        }
+        if (!storage.insertIntoDataBase(*task))
+        {
+            std::cerr << "Inserting the subtree tasks FAILED!\n" << storage.getAllErrorMessages() << "\n";
+            return false;
+        }
+        subtreeTasks.push_back(task);
+    }
+
+    auto subtreeIsComplete = [&subtreeTasks](const TaskTreeNodeShp& root) {
+        return root->task->getTaskID() == subtreeTasks[0]->getTaskID() && root->children.size() == 2 &&
+            root->children[0]->task->getTaskID() == subtreeTasks[1]->getTaskID() &&
+            root->children[1]->task->getTaskID() == subtreeTasks[2]->getTaskID() &&
+            root->children[1]->children.empty() && root->children[0]->children.size() == 1 &&
+            root->children[0]->children[0]->task->getTaskID() == subtreeTasks[3]->getTaskID() &&
+            root->children[0]->children[0]->depth == 2 && root->children[0]->children[0]->children.empty();
+    };
+
+    TaskTreeNodeShp root;
+    TaskTreeNodeShp shallowRoot;
+    if (!storage.getTaskSubtree(subtreeTasks[0]->getTaskID(), MaxTaskSubtreeDepth, root) || !subtreeIsComplete(root) ||
+        !storage.getTaskSubtree(subtreeTasks[0]->getTaskID(), 1, shallowRoot) ||
+        shallowRoot->children.size() != 2 || !shallowRoot->children[0]->children.empty())
+    {
+        std::cerr << "getTaskSubtree() FAILED!\n" << storage.getAllErrorMessages() << "\n";
+        return false;
+    }
+
+    subtreeTasks[0]->setParentTaskID(subtreeTasks[3]->getTaskID());
+    TaskTreeNodeShp cycleRoot;
+    if (!storage.updateInDataBase(*subtreeTasks[0]) ||
+        !storage.getTaskSubtree(subtreeTasks[0]->getTaskID(), MaxTaskSubtreeDepth, cycleRoot) ||
+        !subtreeIsComplete(cycleRoot))
+    {
+        std::cerr << "getTaskSubtree() with a ParentTask cycle FAILED!\n" << storage.getAllErrorMessages() << "\n";
+        return false;
+    }
+
+    if (storage.getTaskSubtree(subtreeTasks[0]->getTaskID(), MaxTaskSubtreeDepth + 1, root))
+    {
+        std::cerr << "getTaskSubtree() accepted a depth above MaxTaskSubtreeDepth. Test FAILED!\n";
+        return false;
+    }
+
+    std::clog << "Task subtree test PASSED\n";
+    return true;
+}
+
 int main(int argc, char* argv[])
 {
     try {
@@ -302,10 +888,43 @@ int main(int argc, char* argv[])
 		{
 			ProgramOptions programOptions = *progOptions;
             UtilityTimer stopWatch;
-            UserList userList = loadUserProfileTestDataIntoDatabase(programOptions);
+            std::unique_ptr<StorageInterface> storage = createStorage(programOptions);
+            UserList userList = loadUserProfileTestDataIntoDatabase(*storage, programOptions);
             if (userList.size())
             {
-                if (!loadUserTaskestDataIntoDatabase(userList[0], programOptions))
+                if (!loadUserTaskestDataIntoDatabase(*storage, userList[0], programOptions))
+                {
+                    return EXIT_FAILURE;
+                }
+                if (!testBulkInsert(*storage, userList, programOptions))
+                {
+                    return EXIT_FAILURE;
+                }
+                if (!testUniqueModelLookups(*storage, userList))
+                {
+                    return EXIT_FAILURE;
+                }
+                if (!testModelCache(*storage, userList, programOptions))
+                {
+                    return EXIT_FAILURE;
+                }
+                if (!testTaskPages(*storage, userList[0]))
+                {
+                    return EXIT_FAILURE;
+                }
+                if (!testWriteBehind(*storage, userList[0], programOptions))
+                {
+                    return EXIT_FAILURE;
+                }
+                if (!testTasksChangedSince(*storage, userList[0]))
+                {
+                    return EXIT_FAILURE;
+                }
+                if (!testProjectedReads(*storage, userList))
+                {
+                    return EXIT_FAILURE;
+                }
+                if (!testTaskSubtree(*storage, userList[0], programOptions))
                 {
                     return EXIT_FAILURE;
                 }